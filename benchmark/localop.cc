@@ -0,0 +1,94 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+//
+// Compares LocalOp::product, which applies the
+// L-Op1-Op2-R network to dense tensors using a
+// plan computed once per bond, against the
+// step-by-step ITensor contraction sequence.
+//
+// Usage: ./localop [nrepeat]
+//
+#include <cstdlib>
+#include "itensor/util/cputime.h"
+#include "itensor/util/print_macro.h"
+#include "itensor/mps/localop.h"
+
+using namespace itensor;
+
+ITensor
+stepwiseProduct(ITensor const& L,
+                ITensor const& Op1,
+                ITensor const& Op2,
+                ITensor const& R,
+                ITensor const& phi)
+    {
+    auto phip = phi*L;
+    phip *= Op1;
+    phip *= Op2;
+    phip *= R;
+    phip.mapprime(1,0);
+    return phip;
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    int nrepeat = 20;
+    if(argc > 1) nrepeat = std::atoi(argv[1]);
+
+    //{bond dimension, MPO dimension, site dimension}
+    std::vector<std::array<long,3>> shapes =
+        {{{50,5,2}},
+         {{100,5,2}},
+         {{200,5,2}},
+         {{400,5,2}},
+         {{100,20,4}},
+         {{200,20,4}}};
+
+    printfln("%-12s %12s %12s %8s %10s","m,k,d","fused (s)","stepwise (s)","speedup","rel diff");
+    for(auto& s : shapes)
+        {
+        auto m = s[0],
+             k = s[1],
+             d = s[2];
+        auto s1 = Index("s1",d,Site);
+        auto s2 = Index("s2",d,Site);
+        auto h0 = Index("h0",k);
+        auto h1 = Index("h1",k);
+        auto h2 = Index("h2",k);
+        auto l0 = Index("l0",m);
+        auto l2 = Index("l2",m);
+
+        auto Op1 = randomTensor(s1,prime(s1),h0,h1);
+        auto Op2 = randomTensor(s2,prime(s2),h1,h2);
+        auto L = randomTensor(l0,prime(l0),h0);
+        auto R = randomTensor(l2,prime(l2),h2);
+        auto phi = randomTensor(l0,s1,s2,l2);
+        auto lop = LocalOp<ITensor>(Op1,Op2,L,R);
+
+        auto fused = ITensor();
+        lop.product(phi,fused);
+        auto t1 = cpu_time();
+        for(int r = 0; r < nrepeat; ++r)
+            {
+            lop.product(phi,fused);
+            }
+        auto tfused = t1.sincemark().wall/nrepeat;
+
+        auto stepwise = ITensor();
+        auto t2 = cpu_time();
+        for(int r = 0; r < nrepeat; ++r)
+            {
+            stepwise = stepwiseProduct(L,Op1,Op2,R,phi);
+            }
+        auto tstep = t2.sincemark().wall/nrepeat;
+
+        printfln("%-12s %12.3E %12.3E %8.2f %10.2E",
+                 format("%d,%d,%d",m,k,d),tfused,tstep,tstep/tfused,
+                 norm(fused-stepwise)/norm(stepwise));
+        }
+
+    return 0;
+    }
@@ -0,0 +1,111 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+//
+// Times copying permuted tensors (T &= permute(A,P), as done
+// by contract) using transform, against the single strided
+// loop along the largest index used previously.
+//
+// Usage: ./permute [nrepeat]
+//
+#include <cstdlib>
+#include "itensor/util/cputime.h"
+#include "itensor/util/print_macro.h"
+#include "itensor/tensor/sliceten.h"
+#include "itensor/detail/algs.h"
+
+using namespace itensor;
+
+//Copy with the inner loop always
+//running over the largest index
+void
+stridedCopy(TensorRefc from,
+            TensorRef to)
+    {
+    auto r = to.r();
+    size_t bigind = 0, 
+           bigsize = from.extent(0);
+    for(decltype(r) j = 1; j < r; ++j)
+        if(bigsize < from.extent(j))
+            {
+            bigsize = from.extent(j); 
+            bigind = j;
+            }
+    auto stepfrom = from.stride(bigind);
+    auto stepto = to.stride(bigind);
+    auto RB = RangeBuilder(r);
+    for(decltype(r) i = 0; i < r; ++i) RB.setIndex(i,from.extent(i));
+    RB.setIndex(bigind,1);
+    for(auto& i : RB.build())
+        {
+        auto* pto = to.data()+offset(to,i);
+        auto* pfrom = from.data()+offset(from,i);
+        for(size_t b = 0; b < bigsize; ++b)
+            {
+            *pto = *pfrom;
+            pto += stepto;
+            pfrom += stepfrom;
+            }
+        }
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    int nrepeat = 20;
+    if(argc > 1) nrepeat = std::atoi(argv[1]);
+
+    struct Case
+        {
+        std::vector<size_t> dims;
+        Labels perm;
+        };
+    //Shapes of MPS/environment tensors
+    //for bond dimensions m=100..800
+    auto cases = std::vector<Case>
+        {{{100,2,100},{2,0,1}},
+         {{400,4,400},{0,2,1}},
+         {{200,3,3,200},{3,1,0,2}},
+         {{100,100,20},{1,0,2}},
+         {{800,800},{1,0}},
+         {{1600,400},{1,0}},
+         {{1200,2,1200},{2,1,0}},
+         {{2000,2000},{1,0}},
+         {{300,300,30},{1,0,2}},
+         {{40,2,2,40,20},{4,3,0,2,1}}};
+
+    printfln("%-20s %-12s %12s %12s %8s","dims","perm","transform","strided","speedup");
+    for(auto& c : cases)
+        {
+        auto RB = RangeBuilder(c.dims.size());
+        for(auto j : range(c.dims)) RB.setIndex(j,c.dims[j]);
+        auto R = RB.build();
+        auto A = Tensor(std::vector<Real>(area(R)),std::move(R));
+        for(auto& el : A) el = detail::quickran();
+        auto PA = permute(A,c.perm);
+        auto B1 = Tensor(PA);
+        auto B2 = Tensor(PA);
+
+        auto t1 = cpu_time();
+        for(int r = 0; r < nrepeat; ++r) makeRef(B1) &= PA;
+        auto tnew = t1.sincemark().wall/nrepeat;
+
+        auto t2 = cpu_time();
+        for(int r = 0; r < nrepeat; ++r) stridedCopy(PA,makeRef(B2));
+        auto told = t2.sincemark().wall/nrepeat;
+
+        for(auto j : range(B1.size()))
+            {
+            if(B1.data()[j] != B2.data()[j]) Error("Mismatch between permuted copies");
+            }
+
+        auto dstr = std::string{},
+             pstr = std::string{};
+        for(auto d : c.dims) dstr += format("%d ",d);
+        for(auto p : c.perm) pstr += format("%d",p);
+        printfln("%-20s %-12s %12.3E %12.3E %8.2f",dstr,pstr,tnew,told,told/tnew);
+        }
+
+    return 0;
+    }
@@ -0,0 +1,158 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+//
+// Replays a contraction trace recorded by running
+// a program with ITENSOR_CONTRACT_TRACE=<file>
+// (see itensor/util/tensorstats.h).
+//
+// Each recorded contraction is rebuilt from random
+// tensors with the same dimensions, labels and block
+// structure, then timed again (best of nrepeat).
+// Recorded times include building QDense contraction
+// plans, which later repeats take from the plan cache.
+// Prints the total recorded and replayed time and
+// the slowest contractions.
+//
+// Usage: ./replay tracefile [nrepeat] [nshow]
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include "itensor/util/tensorstats.h"
+#include "itensor/iqtensor.h"
+
+using namespace itensor;
+
+using Clock = std::chrono::steady_clock;
+
+ITensor
+makeTensor(TStats::Tens const& t,
+           std::map<int,Index>& inds)
+    {
+    auto is = std::vector<Index>();
+    for(auto& i : t.inds)
+        {
+        auto it = inds.find(i.label);
+        if(it == inds.end())
+            {
+            it = inds.emplace(i.label,Index(format("i%d",i.label),i.dim)).first;
+            }
+        is.push_back(it->second);
+        }
+    auto T = ITensor(IndexSet(std::move(is)));
+    randomize(T,{"Complex",t.cplx});
+    return T;
+    }
+
+IQTensor
+makeTensor(TStats::Tens const& t,
+           std::map<int,IQIndex>& inds)
+    {
+    auto is = std::vector<IQIndex>();
+    for(auto& i : t.inds)
+        {
+        auto it = inds.find(i.label);
+        if(it == inds.end())
+            {
+            auto sectors = IQIndex::storage();
+            for(auto n : range(i.sector_dims))
+                {
+                sectors.emplace_back(Index(format("i%d_%d",i.label,n),i.sector_dims[n]),i.sector_qns[n]);
+                }
+            auto I = IQIndex(format("I%d",i.label),std::move(sectors),Arrow(i.dir));
+            it = inds.emplace(i.label,I).first;
+            }
+        auto& I = it->second;
+        is.push_back(int(I.dir()) == i.dir ? I : dag(I));
+        }
+
+    //Offsets of the recorded blocks, whose numbers
+    //are computed with the first index fastest
+    auto offsets = std::vector<BlOf>();
+    long size = 0;
+    for(auto b : t.blocks)
+        {
+        auto area = 1l;
+        auto rem = b;
+        for(auto& I : is)
+            {
+            area *= I.index(1+rem%I.nindex()).m();
+            rem /= I.nindex();
+            }
+        offsets.push_back(BlOf{b,size});
+        size += area;
+        }
+    auto T = IQTensor(IQIndexSet(std::move(is)),QDenseReal(offsets,size));
+    randomize(T,{"Complex",t.cplx});
+    return T;
+    }
+
+template<typename IndexMap>
+Real
+replay(TStats const& t, int nrepeat)
+    {
+    auto inds = IndexMap();
+    auto A = makeTensor(t.A,inds);
+    auto B = makeTensor(t.B,inds);
+    auto best = std::numeric_limits<Real>::max();
+    for(int r = 0; r < nrepeat; ++r)
+        {
+        auto start = Clock::now();
+        auto C = A*B;
+        best = std::min(best,std::chrono::duration<Real>(Clock::now()-start).count());
+        }
+    return best;
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    if(argc < 2)
+        {
+        printfln("Usage: %s tracefile [nrepeat] [nshow]",argv[0]);
+        return 1;
+        }
+    auto trace = readContractTrace(argv[1]);
+    int nrepeat = (argc > 2 ? std::atoi(argv[2]) : 3);
+    int nshow = (argc > 3 ? std::atoi(argv[3]) : 10);
+
+    auto times = std::vector<Real>(trace.size());
+    Real recorded = 0,
+         replayed = 0;
+    long nblocksparse = 0;
+    for(auto n : range(trace))
+        {
+        auto& t = trace[n];
+        if(t.blocksparse)
+            {
+            times[n] = replay<std::map<int,IQIndex>>(t,nrepeat);
+            ++nblocksparse;
+            }
+        else
+            {
+            times[n] = replay<std::map<int,Index>>(t,nrepeat);
+            }
+        recorded += t.time;
+        replayed += times[n];
+        }
+
+    printfln("%d contractions (%d block sparse)",trace.size(),nblocksparse);
+    printfln("Recorded time = %.4f s, replayed time = %.4f s (best of %d)",recorded,replayed,nrepeat);
+
+    auto order = std::vector<size_t>(trace.size());
+    for(auto n : range(order)) order[n] = n;
+    std::sort(order.begin(),order.end(),[&times](size_t a, size_t b) { return times[a] > times[b]; });
+    nshow = std::min<int>(nshow,order.size());
+    if(nshow > 0) printfln("\nSlowest %d contractions:",nshow);
+    for(auto j : range(nshow))
+        {
+        auto n = order[j];
+        printfln("#%d: replayed %.3E s, recorded %.3E s\n%s\n",n,times[n],trace[n].time,trace[n]);
+        }
+
+    return 0;
+    }
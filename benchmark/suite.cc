@@ -0,0 +1,430 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+//
+// Benchmark suite covering the main kernels (gemm,
+// permute/transform, SVD, diagHermitian, dense and
+// block-sparse contraction) and DMRG sweeps of the
+// models in sample/dmrg.cc and sample/iqdmrg.cc.
+//
+// Each benchmark is set up with a fixed random seed,
+// run once to warm up, then timed nrepeat times
+// (DMRG runs are timed once). Results are written as
+// JSON, one benchmark per line, with the best and
+// median time of each.
+//
+// Given a baseline (a JSON file written earlier)
+// the best times are compared against it, and the
+// exit status is 1 if any benchmark is slower by
+// more than the tolerance.
+//
+// Usage: ./suite [-r nrepeat] [-f filter] [-o out.json]
+//                [-b baseline.json] [-t tolerance] [-l]
+//
+//  -r  number of timed runs (default 5)
+//  -f  only run benchmarks whose name contains filter
+//  -o  write results to this file (default suite.json)
+//  -b  compare with this baseline
+//  -t  allowed relative slowdown (default 0.1)
+//  -l  list the benchmarks and exit
+//
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <sstream>
+#include "itensor/all.h"
+#include "itensor/tensor/sliceten.h"
+
+using namespace itensor;
+
+using Clock = std::chrono::steady_clock;
+
+struct Result
+    {
+    std::string name;
+    Real best = 0,
+         median = 0;
+    int repeats = 0;
+    //Checks of the computed results, e.g. energies
+    std::vector<std::pair<std::string,Real>> checks;
+    };
+
+//
+// A benchmark sets up its data in setup and returns
+// the function to time, which may add checks
+//
+struct Benchmark
+    {
+    using Run = std::function<void(Result&)>;
+    std::string name;
+    std::function<Run()> setup;
+    bool once;
+
+    Benchmark(std::string n, std::function<Run()> s, bool o = false)
+      : name(std::move(n)), setup(std::move(s)), once(o) { }
+    };
+
+Matrix
+randomMatrix(long nrow, long ncol)
+    {
+    auto M = Matrix(nrow,ncol);
+    for(auto& el : M) el = detail::quickran();
+    return M;
+    }
+
+Matrix
+randomSymmetric(long n)
+    {
+    auto M = randomMatrix(n,n);
+    return Matrix(M+transpose(M));
+    }
+
+void
+addGemm(std::vector<Benchmark>& B, long m, long k, long n, bool cplx)
+    {
+    auto name = format("gemm/%s/%dx%dx%d",cplx ? "cplx" : "real",m,k,n);
+    B.push_back({name,[=]()
+        {
+        if(cplx)
+            {
+            auto A = std::make_shared<CMatrix>(m,k),
+                 X = std::make_shared<CMatrix>(k,n),
+                 C = std::make_shared<CMatrix>(m,n);
+            for(auto& el : *A) el = Cplx(detail::quickran(),detail::quickran());
+            for(auto& el : *X) el = Cplx(detail::quickran(),detail::quickran());
+            return Benchmark::Run([=](Result&) { gemm(makeRef(*A),makeRef(*X),makeRef(*C),1.,0.); });
+            }
+        auto A = std::make_shared<Matrix>(randomMatrix(m,k)),
+             X = std::make_shared<Matrix>(randomMatrix(k,n)),
+             C = std::make_shared<Matrix>(m,n);
+        return Benchmark::Run([=](Result&) { gemm(makeRef(*A),makeRef(*X),makeRef(*C),1.,0.); });
+        }});
+    }
+
+//Name such as "200x3x3x200/3102"
+std::string
+shapeName(std::vector<size_t> const& dims, Labels const& perm)
+    {
+    auto name = std::string();
+    for(auto j : range(dims)) name += format(j == 0 ? "%d" : "x%d",dims[j]);
+    name += "/";
+    for(auto p : perm) name += format("%d",p);
+    return name;
+    }
+
+void
+addPermute(std::vector<Benchmark>& B, std::vector<size_t> dims, Labels perm)
+    {
+    auto name = "permute/" + shapeName(dims,perm);
+    B.push_back({name,[=]()
+        {
+        auto RB = RangeBuilder(dims.size());
+        for(auto j : range(dims)) RB.setIndex(j,dims[j]);
+        auto R = RB.build();
+        auto A = std::make_shared<Tensor>(std::vector<Real>(area(R)),std::move(R));
+        for(auto& el : *A) el = detail::quickran();
+        auto T = std::make_shared<Tensor>(permute(*A,perm));
+        return Benchmark::Run([=](Result&) { makeRef(*T) &= permute(*A,perm); });
+        }});
+    }
+
+//transform adding a permuted tensor into another,
+//as done when permuting back the result of contract
+void
+addTransform(std::vector<Benchmark>& B, std::vector<size_t> dims, Labels perm)
+    {
+    auto name = "transform/" + shapeName(dims,perm);
+    B.push_back({name,[=]()
+        {
+        auto RB = RangeBuilder(dims.size());
+        for(auto j : range(dims)) RB.setIndex(j,dims[j]);
+        auto R = RB.build();
+        auto A = std::make_shared<Tensor>(std::vector<Real>(area(R)),std::move(R));
+        for(auto& el : *A) el = detail::quickran();
+        auto T = std::make_shared<Tensor>(permute(*A,perm));
+        return Benchmark::Run([=](Result&)
+            {
+            transform(permute(*A,perm),makeRef(*T),[](Real a, Real& t) { t = 0.5*t+a; });
+            });
+        }});
+    }
+
+void
+addSVD(std::vector<Benchmark>& B, long m, long n, SVDMethod method, std::string const& mname)
+    {
+    B.push_back({format("SVDRef/%s/%dx%d",mname,m,n),[=]()
+        {
+        auto M = std::make_shared<Matrix>(randomMatrix(m,n));
+        auto nsv = std::min(m,n);
+        auto U = std::make_shared<Matrix>(m,nsv),
+             V = std::make_shared<Matrix>(n,nsv);
+        auto D = std::make_shared<Vector>(nsv);
+        return Benchmark::Run([=](Result&)
+            {
+            SVDRef(makeRef(*M),makeRef(*U),makeRef(*D),makeRef(*V),method,SVD_THRESH);
+            });
+        }});
+    }
+
+void
+addDiagHermitian(std::vector<Benchmark>& B, long n)
+    {
+    B.push_back({format("diagHermitian/%d",n),[=]()
+        {
+        auto M = std::make_shared<Matrix>(randomSymmetric(n));
+        return Benchmark::Run([=](Result&)
+            {
+            Matrix U;
+            Vector d;
+            diagHermitian(*M,U,d);
+            });
+        }});
+    }
+
+//Contraction of an MPS-like tensor with an
+//environment-like tensor with bond dimension m
+void
+addDenseContract(std::vector<Benchmark>& B, long m, long k, long d)
+    {
+    B.push_back({format("contract/dense/m%d_k%d_d%d",m,k,d),[=]()
+        {
+        auto l = Index("l",m),
+             r = Index("r",m),
+             s = Index("s",d),
+             h = Index("h",k);
+        auto L = std::make_shared<ITensor>(randomTensor(l,prime(l),h));
+        auto psi = std::make_shared<ITensor>(randomTensor(l,s,r));
+        return Benchmark::Run([=](Result&) { auto C = (*L)*(*psi); });
+        }});
+    }
+
+//Same as addDenseContract for IQTensors whose
+//indices have nsector sectors of dimension m/nsector
+void
+addQDenseContract(std::vector<Benchmark>& B, long m, long k, int nsector)
+    {
+    B.push_back({format("contract/qdense/m%d_k%d_sectors%d",m,k,nsector),[=]()
+        {
+        auto sectors = [](std::string const& name, long size, int nsec)
+            {
+            auto st = IQIndex::storage();
+            for(auto q : range(nsec))
+                {
+                auto qn = QN(2*(q-nsec/2));
+                st.emplace_back(Index(format("%s%d",name,q),std::max(1l,size/nsec)),qn);
+                }
+            return IQIndex(name,std::move(st));
+            };
+        auto l = sectors("l",m,nsector),
+             r = sectors("r",m,nsector),
+             h = sectors("h",k,3);
+        auto s = IQIndex("s",Index("s+",1),QN(+2),
+                             Index("s0",1),QN( 0),
+                             Index("s-",1),QN(-2));
+        auto L = std::make_shared<IQTensor>(randomTensor(QN(),l,dag(prime(l)),h));
+        auto psi = std::make_shared<IQTensor>(randomTensor(QN(),dag(l),s,r));
+        return Benchmark::Run([=](Result&) { auto C = (*L)*(*psi); });
+        }});
+    }
+
+//Spin 1 Heisenberg chain and sweeps of sample/dmrg.cc
+//and sample/iqdmrg.cc
+template<typename Tensor>
+void
+addDMRG(std::vector<Benchmark>& B, std::string const& name, int N)
+    {
+    B.push_back({format("%s/spinone/N%d",name,N),[=]()
+        {
+        return Benchmark::Run([=](Result& res)
+            {
+            auto sites = SpinOne(N);
+            auto ampo = AutoMPO(sites);
+            for(int j = 1; j < N; ++j)
+                {
+                ampo += 0.5,"S+",j,"S-",j+1;
+                ampo += 0.5,"S-",j,"S+",j+1;
+                ampo +=     "Sz",j,"Sz",j+1;
+                }
+            auto H = MPOt<Tensor>(ampo);
+            auto state = InitState(sites);
+            for(int i = 1; i <= N; ++i) state.set(i,i%2 == 1 ? "Up" : "Dn");
+            auto psi = MPSt<Tensor>(state);
+            auto sweeps = Sweeps(5);
+            sweeps.maxm() = 10,20,100,100,200;
+            sweeps.cutoff() = 1E-10;
+            sweeps.niter() = 2;
+            sweeps.noise() = 1E-7,1E-8,0.0;
+            auto energy = dmrg(psi,H,sweeps,{"Quiet",true,"PrintEigs",false});
+            res.checks.emplace_back("energy",energy);
+            });
+        },true});
+    }
+
+std::vector<Benchmark>
+allBenchmarks()
+    {
+    auto B = std::vector<Benchmark>();
+    for(auto n : {64l,256l,1024l}) addGemm(B,n,n,n,false);
+    addGemm(B,400,20,400,false);
+    addGemm(B,256,256,256,true);
+
+    addPermute(B,{100,2,100},{2,0,1});
+    addPermute(B,{200,3,3,200},{3,1,0,2});
+    addPermute(B,{1600,400},{1,0});
+    addPermute(B,{40,2,2,40,20},{4,3,0,2,1});
+    addTransform(B,{200,3,3,200},{3,1,0,2});
+    addTransform(B,{1600,400},{1,0});
+
+    addSVD(B,100,100,DensityMatrixSVD,"DensityMatrix");
+    addSVD(B,400,400,DensityMatrixSVD,"DensityMatrix");
+    addSVD(B,400,400,GesddSVD,"gesdd");
+    addSVD(B,800,200,GesddSVD,"gesdd");
+
+    addDiagHermitian(B,100);
+    addDiagHermitian(B,400);
+
+    addDenseContract(B,100,5,3);
+    addDenseContract(B,400,5,3);
+    addQDenseContract(B,200,5,5);
+    addQDenseContract(B,800,5,9);
+
+    addDMRG<ITensor>(B,"dmrg",40);
+    addDMRG<IQTensor>(B,"iqdmrg",100);
+    return B;
+    }
+
+Result
+run(Benchmark const& b, int nrepeat, int seed)
+    {
+    auto res = Result();
+    res.name = b.name;
+    seedRNG(seed);
+    auto f = b.setup();
+    if(b.once) nrepeat = 1;
+    else       f(res);
+    auto times = std::vector<Real>();
+    for(int r = 0; r < nrepeat; ++r)
+        {
+        res.checks.clear();
+        auto start = Clock::now();
+        f(res);
+        times.push_back(std::chrono::duration<Real>(Clock::now()-start).count());
+        }
+    std::sort(times.begin(),times.end());
+    res.best = times.front();
+    res.median = times[times.size()/2];
+    res.repeats = nrepeat;
+    return res;
+    }
+
+void
+writeJSON(std::ostream& s, std::vector<Result> const& results)
+    {
+    s << "{\"suite\":\"itensor\",\"benchmarks\":[\n";
+    for(auto& r : results)
+        {
+        s << format("{\"name\":\"%s\",\"time\":%.6e,\"median\":%.6e,\"repeats\":%d",
+                    r.name,r.best,r.median,r.repeats);
+        for(auto& c : r.checks) s << format(",\"%s\":%.12e",c.first,c.second);
+        s << "}" << (&r == &results.back() ? "\n" : ",\n");
+        }
+    s << "]}\n";
+    }
+
+//Best times by name from a file written by writeJSON
+std::map<std::string,Real>
+readBaseline(std::string const& fname)
+    {
+    std::ifstream f(fname);
+    if(!f) Error("Couldn't open baseline file " + fname);
+    std::stringstream ss;
+    ss << f.rdbuf();
+    auto s = ss.str();
+    auto res = std::map<std::string,Real>();
+    auto key = std::string("{\"name\":\"");
+    for(auto p = s.find(key); p != std::string::npos; p = s.find(key,p))
+        {
+        p += key.size();
+        auto e = s.find('"',p);
+        auto name = s.substr(p,e-p);
+        auto t = s.find("\"time\":",e);
+        if(t == std::string::npos) break;
+        res[name] = std::strtod(s.c_str()+t+7,nullptr);
+        }
+    return res;
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    int nrepeat = 5;
+    std::string filter,
+                outfile = "suite.json",
+                basefile;
+    Real tol = 0.1;
+    bool list = false;
+    for(int n = 1; n < argc; ++n)
+        {
+        auto arg = std::string(argv[n]);
+        auto next = [&]()
+            {
+            if(n+1 >= argc) Error("Missing value for " + arg);
+            return std::string(argv[++n]);
+            };
+        if(arg == "-r")      nrepeat = std::atoi(next().c_str());
+        else if(arg == "-f") filter = next();
+        else if(arg == "-o") outfile = next();
+        else if(arg == "-b") basefile = next();
+        else if(arg == "-t") tol = std::atof(next().c_str());
+        else if(arg == "-l") list = true;
+        else
+            {
+            printfln("Unknown argument %s",arg);
+            return 2;
+            }
+        }
+
+    auto baseline = std::map<std::string,Real>();
+    if(!basefile.empty()) baseline = readBaseline(basefile);
+
+    auto results = std::vector<Result>();
+    int nslower = 0;
+    if(!list) printfln("%-40s %12s %12s %12s %8s","benchmark","time (s)","median (s)","baseline","ratio");
+    for(auto& b : allBenchmarks())
+        {
+        if(!filter.empty() && b.name.find(filter) == std::string::npos) continue;
+        if(list)
+            {
+            println(b.name);
+            continue;
+            }
+        auto r = run(b,nrepeat,1);
+        results.push_back(r);
+        auto line = format("%-40s %12.4E %12.4E",r.name,r.best,r.median);
+        auto it = baseline.find(r.name);
+        if(it != baseline.end() && it->second > 0)
+            {
+            auto ratio = r.best/it->second;
+            auto slower = (ratio > 1+tol);
+            if(slower) ++nslower;
+            line += format(" %12.4E %8.3f%s",it->second,ratio,slower ? "  SLOWER" : "");
+            }
+        println(line);
+        }
+    if(list) return 0;
+
+    std::ofstream f(outfile);
+    writeJSON(f,results);
+    printfln("\nWrote %s",outfile);
+
+    if(!baseline.empty())
+        {
+        printfln("%d of %d benchmarks slower than baseline by more than %.0f%%",
+                 nslower,results.size(),100*tol);
+        }
+    return nslower > 0 ? 1 : 0;
+    }
@@ -0,0 +1,95 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+//
+// Compares the time and accuracy of the SVD methods
+// selectable by the "SVDMethod" arg: the default
+// density-matrix algorithm and LAPACK gesdd/gesvd.
+//
+// Test matrices have a known, exponentially decaying
+// spectrum like the wavefunctions factorized in DMRG.
+// "recon" is the relative error of U*D*V^T and
+// "sval err" the largest error of a singular value
+// relative to the largest singular value.
+//
+// Usage: ./svd [nrepeat]
+//
+#include <cstdlib>
+#include "itensor/util/cputime.h"
+#include "itensor/util/print_macro.h"
+#include "itensor/tensor/algs.h"
+#include "itensor/util/range.h"
+
+using namespace itensor;
+
+//Random matrix with orthonormal columns
+Matrix
+randomIsometry(long nrow, long ncol)
+    {
+    auto A = Matrix(nrow,ncol);
+    randomize(A);
+    Matrix U,V;
+    Vector d;
+    SVD(A,U,d,V,GesvdSVD);
+    return U;
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    int nrepeat = 5;
+    if(argc > 1) nrepeat = std::atoi(argv[1]);
+
+    //{nrows, ncols}
+    std::vector<std::array<long,2>> shapes =
+        {{{50,50}},
+         {{100,200}},
+         {{200,200}},
+         {{400,400}},
+         {{800,200}}};
+
+    auto methods = {std::make_pair(DensityMatrixSVD,"DensityMatrix"),
+                    std::make_pair(GesddSVD,"gesdd"),
+                    std::make_pair(GesvdSVD,"gesvd")};
+
+    printfln("%-10s %-14s %12s %10s %10s","m x n","method","time (s)","recon","sval err");
+    for(auto& s : shapes)
+        {
+        auto m = s[0],
+             n = s[1];
+        auto nsv = std::min(m,n);
+        auto exact = Vector(nsv);
+        for(auto j : range(nsv)) exact(j) = std::pow(0.9,j);
+        auto DD = Matrix(nsv,nsv);
+        diagonal(DD) &= exact;
+        auto L = randomIsometry(m,nsv);
+        auto R = randomIsometry(n,nsv);
+        auto M = Matrix(L*DD*transpose(R));
+
+        for(auto& meth : methods)
+            {
+            Matrix U,V;
+            Vector d;
+            auto t = cpu_time();
+            for(int r = 0; r < nrepeat; ++r)
+                {
+                SVD(M,U,d,V,meth.first);
+                }
+            auto time = t.sincemark().wall/nrepeat;
+
+            diagonal(DD) &= d;
+            auto recon = norm(U*DD*transpose(V)-M)/norm(M);
+            Real svalerr = 0;
+            for(auto j : range(nsv))
+                {
+                svalerr = std::max(svalerr,std::abs(d(j)-exact(j)));
+                }
+
+            printfln("%-10s %-14s %12.3E %10.2E %10.2E",
+                     format("%dx%d",m,n),meth.second,time,recon,svalerr/exact(0));
+            }
+        }
+
+    return 0;
+    }
@@ -0,0 +1,114 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+//
+// Compares the native zgemm path used by gemm(MatRefc<Cplx>,...)
+// against emulating a complex matrix product with four dgemm
+// calls on separated real and imaginary buffers (the method
+// used when ITENSOR_USE_ZGEMM is not defined).
+//
+// Usage: ./zgemm [nrepeat]
+//
+#include <cstdlib>
+#include "itensor/util/cputime.h"
+#include "itensor/util/print_macro.h"
+#include "itensor/tensor/mat.h"
+#include "itensor/tensor/lapack_wrap.h"
+
+using namespace itensor;
+
+//C = A*B via four real dgemm calls plus copies
+void
+emulatedZgemm(CMatrixRefc A,
+              CMatrixRefc B,
+              CMatrixRef C,
+              std::vector<Real> & buf)
+    {
+    auto m = nrows(A),
+         k = ncols(A),
+         n = ncols(B);
+    buf.resize(2*(m*k+k*n+m*n));
+    auto* Ar = buf.data();
+    auto* Ai = Ar+m*k;
+    auto* Br = Ai+m*k;
+    auto* Bi = Br+k*n;
+    auto* Cr = Bi+k*n;
+    auto* Ci = Cr+m*n;
+    auto split = [](Cplx const* z, size_t size, Real* re, Real* im)
+        {
+        for(size_t j = 0; j < size; ++j)
+            {
+            re[j] = z[j].real();
+            im[j] = z[j].imag();
+            }
+        };
+    split(A.data(),m*k,Ar,Ai);
+    split(B.data(),k*n,Br,Bi);
+    gemm_wrapper(false,false,m,n,k,+1.,Ar,Br,0.,Cr);
+    gemm_wrapper(false,false,m,n,k,-1.,Ai,Bi,1.,Cr);
+    gemm_wrapper(false,false,m,n,k,+1.,Ai,Br,0.,Ci);
+    gemm_wrapper(false,false,m,n,k,+1.,Ar,Bi,1.,Ci);
+    auto* pC = C.data();
+    for(size_t j = 0; j < m*n; ++j)
+        {
+        pC[j] = Cplx(Cr[j],Ci[j]);
+        }
+    }
+
+int
+main(int argc, char* argv[])
+    {
+    int nrepeat = 20;
+    if(argc > 1) nrepeat = std::atoi(argv[1]);
+
+    //Block sizes typical of DMRG with m=50..800 and d=2..4:
+    //{nrows, ninner, ncols}
+    std::vector<std::array<long,3>> shapes =
+        {{{50,100,50}},
+         {{100,200,100}},
+         {{200,400,200}},
+         {{400,800,400}},
+         {{800,800,800}},
+         {{400,1600,100}}};
+
+    printfln("%-16s %12s %12s %8s %10s","m x k x n","zgemm (s)","4xdgemm (s)","speedup","max diff");
+    std::vector<Real> buf;
+    for(auto& s : shapes)
+        {
+        auto m = s[0],
+             k = s[1],
+             n = s[2];
+        auto A = CMatrix(m,k);
+        auto B = CMatrix(k,n);
+        auto C1 = CMatrix(m,n);
+        auto C2 = CMatrix(m,n);
+        randomize(A);
+        randomize(B);
+
+        auto t1 = cpu_time();
+        for(int r = 0; r < nrepeat; ++r)
+            {
+            gemm(makeRefc(A),makeRefc(B),makeRef(C1),1.,0.);
+            }
+        auto native = t1.sincemark().wall/nrepeat;
+
+        auto t2 = cpu_time();
+        for(int r = 0; r < nrepeat; ++r)
+            {
+            emulatedZgemm(makeRefc(A),makeRefc(B),makeRef(C2),buf);
+            }
+        auto emulated = t2.sincemark().wall/nrepeat;
+
+        Real maxdiff = 0;
+        for(size_t j = 0; j < C1.size(); ++j)
+            {
+            maxdiff = std::max(maxdiff,std::abs(C1.data()[j]-C2.data()[j]));
+            }
+
+        printfln("%-16s %12.3E %12.3E %8.2f %10.2E",
+                 format("%dx%dx%d",m,k,n),native,emulated,emulated/native,maxdiff);
+        }
+
+    return 0;
+    }
@@ -117,6 +117,7 @@ truncate(Vector & P,
     long origm = P.size();
     long n = origm-1;
     Real docut = 0;
+    auto discarded = std::max(0.,args.getReal("DiscardedWeight",0.));
 
     //Special case if P's are zero
     if(P(0) == 0.0)
@@ -128,7 +129,8 @@ truncate(Vector & P,
     if(origm == 1) 
         {
         docut = P(0)/2.;
-        return std::make_tuple(0,0);
+        auto scale = (doRelCutoff && !absoluteCutoff) ? P(0)+discarded : 1.;
+        return std::make_tuple(discarded/scale,0.);
         }
 
     //Zero out any negative weight
@@ -138,7 +140,7 @@ truncate(Vector & P,
         P(zn) = 0;
         }
 
-    Real truncerr = 0;
+    Real truncerr = discarded;
     //Always truncate down to at least m==maxm (m==n+1)
     while(n >= maxm)
         {
@@ -161,7 +163,7 @@ truncate(Vector & P,
         //if doRelCutoff, use normalized P's when truncating
         if(doRelCutoff) 
             {
-            scale = sumels(P);
+            scale = sumels(P)+discarded;
             if(scale == 0.0) scale = 1.0;
             }
 
@@ -197,6 +199,18 @@ truncate(Vector & P,
     return std::make_tuple(truncerr,docut);
     } // truncate
 
+long
+randomizedSVDRank(long nrow,
+                  long ncol,
+                  long maxm,
+                  Args const& args)
+    {
+    if(!args.getBool("RandomizedSVD",false)) return 0;
+    auto nsv = std::min(nrow,ncol);
+    auto rank = maxm+args.getInt("SVDOversample",10);
+    return (4*rank <= nsv) ? rank : 0;
+    }
+
 void
 showEigs(Vector const& P,
          Real truncerr,
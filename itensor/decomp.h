@@ -18,6 +18,11 @@ namespace itensor {
 // Factors a tensor AA such that AA=U*D*V
 // with D diagonal, real, and non-negative.
 //
+// With the arg "RandomizedSVD" set to true, when
+// truncating to a "Maxm" much smaller than the matrix
+// dimensions only the leading singular values are
+// computed (see randomizedSVDRank below).
+//
 template<class Tensor>
 Spectrum 
 svd(Tensor AA, Tensor& U, Tensor& D, Tensor& V, 
@@ -46,6 +51,47 @@ factor(Tensor const& T,
        Tensor      & B,
        Args const& args = Args::global());
 
+//
+// QR decomposition
+//
+// Factors a tensor T such that T=Q*R, where Q is
+// an isometry: contracting Q with dag(Q) over all
+// indices but the one shared with R gives the identity.
+// The indices of T present on Q initially end up on Q,
+// the rest on R; if Q is default-initialized, the
+// indices of T present on R end up on R instead.
+//
+// The common index of Q and R has dimension
+// min(dim of Q's indices, dim of R's indices). Its
+// name is set by the arg "IndexName" (default "qr")
+// and its type by "IndexType" (default Link).
+//
+// Unlike svd, qr never truncates, but is much cheaper.
+//
+template<class Tensor>
+void
+qr(Tensor const& T,
+   Tensor      & Q,
+   Tensor      & R,
+   Args const& args = Args::global());
+
+//
+// LQ decomposition
+//
+// Factors a tensor T such that T=L*Q with Q an isometry,
+// i.e. the same as qr(T,Q,L,args). The indices of T
+// present on L initially end up on L.
+//
+template<class Tensor>
+void
+lq(Tensor const& T,
+   Tensor      & L,
+   Tensor      & Q,
+   Args const& args = Args::global())
+    {
+    qr(T,Q,L,args);
+    }
+
 //
 // Density Matrix Decomposition
 // 
@@ -98,6 +144,10 @@ denmatDecomp(Tensor const& AA,
 // Result is unitary tensor U and diagonal sparse tensor D
 // such that M == dag(U)*D*prime(U)
 //
+// If the arg "PositiveSemidefinite" is true (as for the
+// density matrices in denmatDecomp) truncations to a
+// small "Maxm" only compute the leading eigenvalues.
+//
 template<class I>
 Spectrum 
 diagHermitian(ITensorT<I> const& M, 
@@ -249,6 +299,50 @@ svd(Tensor AA,
     return spec;
     } //svd
 
+template<typename IndexT>
+void
+qrRank2(ITensorT<IndexT> const& A,
+        IndexT const& qi,
+        IndexT const& ri,
+        ITensorT<IndexT> & Q,
+        ITensorT<IndexT> & R,
+        Args const& args);
+
+template<class Tensor>
+void
+qr(Tensor const& T,
+   Tensor      & Q,
+   Tensor      & R,
+   Args const& args)
+    {
+    using IndexT = typename Tensor::index_type;
+
+    if(!Q && !R) 
+        Error("Q and R default-initialized in qr, must indicate at least one index on Q or R");
+
+    auto Qinds = stdx::reserve_vector<IndexT>(T.r()),
+         Rinds = stdx::reserve_vector<IndexT>(T.r());
+    auto &L = (Q ? Q : R);
+    auto &Linds = (Q ? Qinds : Rinds),
+         &Oinds = (Q ? Rinds : Qinds);
+    for(auto& I : T.inds())
+        { 
+        if(hasindex(L,I)) Linds.push_back(I);
+        else              Oinds.push_back(I);
+        }
+    if(Qinds.empty() || Rinds.empty())
+        Error("qr: Q and R must each get at least one index of T");
+
+    auto Qcomb = combiner(std::move(Qinds),{"IndexName","qc"});
+    auto Rcomb = combiner(std::move(Rinds),{"IndexName","rc"});
+    auto A = T*Qcomb*Rcomb;
+
+    qrRank2(A,commonIndex(A,Qcomb),commonIndex(A,Rcomb),Q,R,args);
+
+    Q = dag(Qcomb) * Q;
+    R = R * dag(Rcomb);
+    } //qr
+
 template<class Tensor, class BigMatrixT>
 Spectrum 
 denmatDecomp(Tensor const& AA, 
@@ -258,6 +352,7 @@ denmatDecomp(Tensor const& AA,
              BigMatrixT const& PH,
              Args args)
     {
+    PROFILE_SCOPE("denmatDecomp")
     using IndexT = typename Tensor::index_type;
 
     auto noise = args.getReal("Noise",0.);
@@ -283,7 +378,6 @@ denmatDecomp(Tensor const& AA,
         }
 
     //Apply combiner
-    START_TIMER(8)
     auto iname = args.getString("IndexName",mid ? mid.rawname() : "mid");
     auto cmb = combiner(std::move(cinds),iname);
     auto ci = cmb.inds().front();
@@ -297,13 +391,12 @@ denmatDecomp(Tensor const& AA,
     //Add noise term if requested
     if(noise > 0 && PH)
         {
+        PROFILE_SCOPE("noise term")
         rho += noise*PH.deltaRho(AA,cmb,dir);
         auto tr = (delta(dag(ci),prime(ci))*realPart(rho)).real();
         if(tr > 1E-16) rho *= 1./tr;
         }
 
-    STOP_TIMER(8)
-
     if(args.getBool("UseOrigM",false))
         {
         args.add("Cutoff",-1);
@@ -318,6 +411,7 @@ denmatDecomp(Tensor const& AA,
 
     Tensor U,D;
     args.add("Truncate",true);
+    args.add("PositiveSemidefinite",true);
     auto spec = diag_hermitian(rho,U,D,args);
 
     cmb.dag();
@@ -404,6 +498,9 @@ diagHermitian(ITensorT<I> const& M,
 
 
 //Return value is: (trunc_error,docut)
+//If P does not hold the whole spectrum, pass the weight
+//of the missing part as the arg "DiscardedWeight" so it
+//is counted in the truncation error
 std::tuple<Real,Real>
 truncate(Vector & P,
          long maxm,
@@ -413,6 +510,20 @@ truncate(Vector & P,
          bool doRelCutoff = false,
          Args const& args = Args::global());
 
+//Number of leading singular values to compute with
+//randomizedSVD when truncating an nrow x ncol matrix
+//to at most maxm, or 0 to compute all of them.
+//Recognized args:
+// "RandomizedSVD": if true (default false), use randomizedSVD
+//                  when maxm plus oversampling is at most
+//                  a quarter of min(nrow,ncol)
+// "SVDOversample": extra singular values computed (default 10)
+long
+randomizedSVDRank(long nrow,
+                  long ncol,
+                  long maxm,
+                  Args const& args = Args::global());
+
 template<typename V>
 MatRefc<V>
 toMatRefc(ITensor const& T, 
@@ -449,6 +560,26 @@ std::vector<Rank2Block<T>>
 doTask(GetBlocks<T> const& G, 
        QDense<T> const& d);
 
+//Block numbers ordered by decreasing cost
+//of factorizing each block, for handing
+//out to threads largest first
+template<typename T>
+std::vector<size_t>
+blocksByCost(std::vector<Rank2Block<T>> const& blocks)
+    {
+    auto cost = [&blocks](size_t b)
+        {
+        auto r = Real(nrows(blocks[b].M)),
+             c = Real(ncols(blocks[b].M));
+        return r*c*std::min(r,c);
+        };
+    auto order = std::vector<size_t>(blocks.size());
+    for(auto b : range(order)) order[b] = b;
+    std::stable_sort(order.begin(),order.end(),
+                     [&cost](size_t b1, size_t b2) { return cost(b1) > cost(b2); });
+    return order;
+    }
+
 void
 showEigs(Vector const& P,
          Real truncerr,
@@ -8,6 +8,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
 #include <ctime>
 #include <stdexcept>
 #include "itensor/types.h"
@@ -101,6 +102,15 @@ quickran()
 Cplx inline
 quickranCplx() { return Cplx(detail::quickran(),detail::quickran()); }
 
+//Seed for random generators made locally by algorithms
+//that may run inside parallel loops (set by seedRNG)
+inline std::atomic<int>&
+localRNGSeed()
+    {
+    static std::atomic<int> seed(std::time(NULL) + getpid());
+    return seed;
+    }
+
 template<typename Container>
 using const_correct_ptr = 
     typename std::conditional<std::is_const<Container>::value,
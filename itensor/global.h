@@ -16,7 +16,7 @@
 #include "itensor/util/error.h"
 #include "itensor/util/args.h"
 #include "itensor/real.h"
-#include "itensor/util/timers.h"
+#include "itensor/util/profiler.h"
 #include "itensor/detail/algs.h"
 
 namespace itensor {
@@ -132,6 +132,7 @@ seedRNG(int seed)
     {
     Global::random(seed);
     detail::seed_quickran(seed);
+    if(seed != 0) detail::localRNGSeed() = seed;
     }
 
 } //namespace itensor
@@ -26,6 +26,42 @@ using std::sqrt;
 using std::move;
 using std::tie;
 
+//Real part of the trace of a square matrix
+template<typename T>
+Real
+trace(MatRefc<T> const& M)
+    {
+    Real tr = 0;
+    for(auto j : range(nrows(M))) tr += std::real(M(j,j));
+    return tr;
+    }
+
+//For a positive semidefinite M the SVD is an eigendecomposition:
+//computes the leading ncols(U) eigenpairs with randomizedSVD
+//and returns the sum of the eigenvalues not computed
+template<typename T>
+Real
+leadingEigs(MatRefc<T> const& M,
+            MatRef<T> const& U,
+            VectorRef const& d,
+            size_t niter)
+    {
+    auto V = Mat<T>{};
+    randomizedSVD(M,U,d,V,ncols(U),niter);
+    //Use the Rayleigh quotients u^dag*M*u as eigenvalues so the
+    //returned weight is exactly what projecting onto U discards
+    auto MU = Mat<T>(nrows(M),ncols(U));
+    mult(M,U,MU);
+    for(auto j : range(d.size()))
+        {
+        auto u = column(U,j);
+        auto mu = column(MU,j);
+        d(j) = 0;
+        for(auto i : range(u.size())) d(j) += std::real(std::conj(u(i))*mu(i));
+        }
+    return std::max(0.,trace(M)-sumels(d));
+    }
+
 template<typename T>
 Spectrum
 diagHImpl(ITensor H, 
@@ -33,6 +69,7 @@ diagHImpl(ITensor H,
           ITensor& D,
           Args const& args)
     {
+    PROFILE_SCOPE("diagHermitian")
     auto cutoff = args.getReal("Cutoff",0.);
     auto maxm = args.getInt("Maxm",H.inds().front().m());
     auto minm = args.getInt("Minm",1);
@@ -71,7 +108,29 @@ diagHImpl(ITensor H,
     Vector DD;
     Mat<T> UU,iUU;
     auto R = toMatRefc<T>(H,active,prime(active));
-    diagHermitian(R,UU,DD);
+    //Density matrices truncated to maxm only need their
+    //leading eigenpairs: use randomizedSVD if requested and maxm
+    //is very small, else a partial diagonalization if maxm <= N/4
+    //(above that it is no faster than a full one)
+    auto N = long(nrows(R));
+    auto psd = do_truncate && args.getBool("PositiveSemidefinite",false);
+    auto rank = psd ? randomizedSVDRank(N,N,maxm,args) : 0;
+    Real discarded = 0;
+    if(rank > 0)
+        {
+        UU = Mat<T>(N,rank);
+        DD = Vector(rank);
+        discarded = leadingEigs(R,makeRef(UU),makeRef(DD),args.getInt("SVDPowerIter",2));
+        }
+    else if(psd && 4*long(maxm) <= N)
+        {
+        diagHermitian(R,UU,DD,maxm);
+        discarded = std::max(0.,trace(R)-sumels(DD));
+        }
+    else
+        {
+        diagHermitian(R,UU,DD);
+        }
     conjugate(UU);
 
     //Truncate
@@ -81,7 +140,9 @@ diagHImpl(ITensor H,
     if(do_truncate)
         {
         //if(DD(1) < 0) DD *= -1; //DEBUG
-        tie(truncerr,docut) = truncate(DD,maxm,minm,cutoff,absoluteCutoff,doRelCutoff,args);
+        auto targs = args;
+        targs.add("DiscardedWeight",discarded);
+        tie(truncerr,docut) = truncate(DD,maxm,minm,cutoff,absoluteCutoff,doRelCutoff,targs);
         m = DD.size();
         reduceCols(UU,m);
         }
@@ -132,7 +193,7 @@ diagHImpl(IQTensor    H,
           IQTensor  & D,
           Args const& args)
     {
-    SCOPED_TIMER(7)
+    PROFILE_SCOPE("diagHermitian")
     auto cutoff = args.getReal("Cutoff",0.);
     auto maxm = args.getInt("Maxm",MAX_INT);
     auto minm = args.getInt("Minm",1);
@@ -169,12 +230,30 @@ diagHImpl(IQTensor    H,
     auto blocks = doTask(GetBlocks<T>{H.inds(),ai,prime(ai,pdiff)},H.store());
     auto Nblock = blocks.size();
 
+    //Number of eigenpairs computed per block: for a density
+    //matrix only the leading maxm if the block is at least
+    //4*maxm, using randomizedSVD (with oversampling, if
+    //requested) for blocks much larger still
+    auto psd = do_truncate && args.getBool("PositiveSemidefinite",false);
+    auto niter = args.getInt("SVDPowerIter",2);
+    auto ranks = vector<long>(Nblock);
+    auto randomized = vector<char>(Nblock,0);
+    auto discarded = vector<Real>(Nblock,0.);
+    for(auto b : range(Nblock))
+        {
+        auto& M = blocks[b].M;
+        auto rank = psd ? randomizedSVDRank(nrows(M),ncols(M),maxm,args) : 0;
+        randomized[b] = (rank > 0);
+        if(rank > 0) ranks[b] = rank;
+        else         ranks[b] = (psd && 4*long(maxm) <= long(nrows(M))) ? maxm : nrows(M);
+        }
+
     size_t totaldsize = 0,
            totalUsize = 0;
     for(auto b : range(Nblock))
         {
-        totaldsize += nrows(blocks[b].M);
-        totalUsize += nrows(blocks[b].M)*ncols(blocks[b].M);
+        totaldsize += ranks[b];
+        totalUsize += nrows(blocks[b].M)*ranks[b];
         }
 
     auto Udata = vector<T>(totalUsize);
@@ -194,17 +273,42 @@ diagHImpl(IQTensor    H,
     for(auto b : range(Nblock))
         {
         auto& M = blocks[b].M;
-        auto& UU = Umats.at(b);
-        auto& d =  dvecs.at(b);
         auto rM = nrows(M),
-             cM = ncols(M);
-
-        d = makeVecRef(ddata.data()+totaldsize,rM);
-        UU = makeMatRef(Udata.data()+totalUsize,rM*cM,rM,cM);
+             cM = ranks[b];
+        dvecs[b] = makeVecRef(ddata.data()+totaldsize,cM);
+        Umats[b] = makeMatRef(Udata.data()+totalUsize,rM*cM,rM,cM);
+        totaldsize += cM;
+        totalUsize += rM*cM;
+        }
 
-        diagHermitian(M,UU,d);
-        conjugate(UU);
+    //Blocks are independent: diagonalize
+    //them in parallel, largest first
+    auto order = blocksByCost(blocks);
+    parallelFor(Nblock,getNThread(args),
+                [&](size_t j)
+                    {
+                    auto b = order[j];
+                    auto& M = blocks[b].M;
+                    PROFILE_SCOPE_BYTES("diagHermitian block",sizeof(T)*nrows(M)*ncols(M))
+                    if(randomized[b])
+                        {
+                        discarded[b] = leadingEigs(M,Umats[b],dvecs[b],niter);
+                        }
+                    else if(ranks[b] < long(nrows(M)))
+                        {
+                        diagHermitianRef(M,Umats[b],dvecs[b]);
+                        discarded[b] = std::max(0.,trace(M)-sumels(dvecs[b]));
+                        }
+                    else
+                        {
+                        diagHermitian(M,Umats[b],dvecs[b]);
+                        }
+                    conjugate(Umats[b]);
+                    });
 
+    for(auto b : range(Nblock))
+        {
+        auto& d =  dvecs.at(b);
         alleig.insert(alleig.end(),d.begin(),d.end());
         if(compute_qns)
             {
@@ -215,8 +319,6 @@ diagHImpl(IQTensor    H,
                 alleigqn.emplace_back(eig,q);
                 }
             }
-        totaldsize += rM;
-        totalUsize += rM*cM;
         }
 
 
@@ -233,8 +335,10 @@ diagHImpl(IQTensor    H,
     Real docut = -1;
     if(do_truncate)
         {
+        auto targs = args;
+        targs.add("DiscardedWeight",stdx::accumulate(discarded,0.));
         tie(truncerr,docut) = truncate(probs,maxm,minm,cutoff,
-                                       absoluteCutoff,doRelCutoff,args);
+                                       absoluteCutoff,doRelCutoff,targs);
         m = probs.size();
         alleigqn.resize(m);
         }
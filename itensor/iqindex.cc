@@ -154,6 +154,19 @@ IQIndex(storage_ptr const& p,
     {
     }
 
+IQIndex::
+IQIndex(Index const& index,
+        storage_ptr const& p,
+        Arrow dir)
+  : Index(index),
+    pd(p),
+    dir_(dir)
+    {
+#ifdef DEBUG
+    if(index.m() != totalM(p->store())) Error("IQIndex: size of Index and sum of sector sizes differ");
+#endif
+    }
+
 //const IQIndexDat::storage& IQIndex::
 //inds() const 
 //    { 
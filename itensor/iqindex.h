@@ -122,6 +122,13 @@ class IQIndex : public Index
             Arrow dir = Out, 
             int plev = 0);
 
+    // Constructor taking the Index part (id, name,
+    // prime level, type and total size) and a
+    // storage pointer, e.g. when reading from disk
+    IQIndex(Index const& index,
+            storage_ptr const& p,
+            Arrow dir);
+
     }; //class IQIndex
 
 //
@@ -245,6 +245,8 @@ doTask(Contract<Index> & C,
        Dense<T2> const& R,
        ManageStore & m)
     {
+    PROFILE_SCOPE("Contract<Index>")
+    auto tstart = ContractTrace::clock_type::now();
     //if(not C.needresult)
     //    {
     //    m.makeNewData<ITLazy>(C.Lis,m.parg1(),C.Ris,m.parg2());
@@ -283,24 +285,26 @@ doTask(Contract<Index> & C,
     auto tL = makeTenRef(L.data(),L.size(),&C.Lis);
     auto tR = makeTenRef(R.data(),R.size(),&C.Ris);
     auto rsize = area(C.Nis);
-    START_TIMER(4)
     auto nd = m.makeNewData<Dense<common_type<T1,T2>>>(rsize);
-    STOP_TIMER(4)
     auto tN = makeTenRef(nd->data(),nd->size(),&(C.Nis));
 
-#ifdef COLLECT_TSTATS
-    tstats(tL,Lind,tR,Rind,tN,Nind);
-#endif
-
-    START_TIMER(2)
     contract(tL,Lind,tR,Rind,tN,Nind);
-    STOP_TIMER(2)
 
 #ifdef USESCALE
-    START_TIMER(3)
     if(rsize > 1) C.scalefac = computeScalefac(*nd);
-    STOP_TIMER(3)
 #endif
+
+    if(contractTrace().active())
+        {
+        contractTrace().record(tstart,[&]()
+            {
+            auto t = TStats();
+            t.A = tstatsTens(C.Lis,Lind,isCplx(L));
+            t.B = tstatsTens(C.Ris,Rind,isCplx(R));
+            t.C = tstatsTens(C.Nis,Nind,isCplx(*nd));
+            return t;
+            });
+        }
     }
 template void doTask(Contract<Index>&,DenseReal const&,DenseReal const&,ManageStore&);
 template void doTask(Contract<Index>&,DenseCplx const&,DenseReal const&,ManageStore&);
@@ -3,6 +3,8 @@
 //    (See accompanying LICENSE file.)
 //
 //#include "itensor/util/range.h"
+#include <list>
+#include <mutex>
 #include "itensor/detail/gcounter.h"
 #include "itensor/detail/algs.h"
 #include "itensor/tensor/lapack_wrap.h"
@@ -10,6 +12,7 @@
 #include "itensor/tensor/contract.h"
 #include "itensor/itdata/qdense.h"
 #include "itensor/itdata/qutil.h"
+#include "itensor/util/tensorstats.h"
 #include "itensor/util/print_macro.h"
 
 using std::vector;
@@ -435,6 +438,204 @@ template void doTask(PlusEQ<IQIndex> const&, QDense<Cplx> const&, QDense<Real> c
 template void doTask(PlusEQ<IQIndex> const&, QDense<Cplx> const&, QDense<Cplx> const&, ManageStore&);
 
 
+//
+// Everything about a QDense*QDense contraction
+// which depends only on the indices and block
+// structure of A and B. Repeated contractions
+// with the same structure (such as the products
+// made at each step of a Davidson or Lanczos
+// solver) can reuse it, skipping the search
+// for matching blocks and the index analysis
+// of each block-block product.
+//
+struct QContractPlan
+    {
+    struct Pair
+        {
+        long aoffset = 0,
+             boffset = 0,
+             coffset = 0;
+        Range Arange,
+              Brange,
+              Crange;
+        std::shared_ptr<CProps> props;
+        };
+    Labels Lind,
+           Rind,
+           Cind;
+    IQIndexSet Nis;
+    std::vector<BlOf> Coffsets;
+    long Csize = 0;
+    std::vector<Pair> pairs;
+        //^ sorted by coffset
+    std::vector<BlockGroup> groups;
+        //^ ranges of pairs sharing a block of C
+    };
+
+using QContractKey = std::vector<long>;
+
+QContractKey
+makeQContractKey(Contract<IQIndex> const& Con,
+                 std::vector<BlOf> const& Aoffsets,
+                 std::vector<BlOf> const& Boffsets)
+    {
+    auto key = QContractKey{};
+    key.reserve(2+3*(Con.Lis.r()+Con.Ris.r())+2+Aoffsets.size()+Boffsets.size());
+    for(auto* is : {&Con.Lis,&Con.Ris})
+        {
+        key.push_back(is->r());
+        for(auto& I : *is)
+            {
+            key.push_back(static_cast<long>(I.id()));
+            key.push_back(I.primeLevel());
+            key.push_back(static_cast<long>(I.dir()));
+            }
+        }
+    for(auto* offsets : {&Aoffsets,&Boffsets})
+        {
+        key.push_back(offsets->size());
+        for(auto& bo : *offsets) key.push_back(bo.block);
+        }
+    return key;
+    }
+
+//
+// Most-recently-used list of contraction plans,
+// holding at most Global::args() "ContractPlanCacheSize"
+// plans (default 64; 0 disables caching)
+//
+class QContractPlanCache
+    {
+    public:
+    using plan_ptr = std::shared_ptr<const QContractPlan>;
+    private:
+    std::mutex mutex_;
+    std::list<std::pair<QContractKey,plan_ptr>> plans_;
+    ContractPlanStats stats_;
+    public:
+
+    plan_ptr
+    find(QContractKey const& key)
+        {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto it = plans_.begin(); it != plans_.end(); ++it)
+            {
+            if(it->first == key)
+                {
+                plans_.splice(plans_.begin(),plans_,it);
+                ++stats_.nhit;
+                return plans_.front().second;
+                }
+            }
+        ++stats_.nmiss;
+        return plan_ptr{};
+        }
+
+    ContractPlanStats
+    stats()
+        {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+        }
+
+    void
+    resetStats()
+        {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_ = ContractPlanStats{};
+        }
+
+    void
+    insert(QContractKey key, 
+           plan_ptr plan,
+           size_t maxsize)
+        {
+        std::lock_guard<std::mutex> lock(mutex_);
+        plans_.emplace_front(std::move(key),std::move(plan));
+        while(plans_.size() > maxsize) plans_.pop_back();
+        }
+    };
+
+QContractPlanCache&
+qcontractPlans()
+    {
+    static QContractPlanCache cache;
+    return cache;
+    }
+
+ContractPlanStats
+contractPlanStats() { return qcontractPlans().stats(); }
+
+void
+resetContractPlanStats() { qcontractPlans().resetStats(); }
+
+template<typename VA, typename VB, typename VC>
+std::shared_ptr<const QContractPlan>
+makeQContractPlan(Contract<IQIndex> const& Con,
+                  QDense<VA> const& A,
+                  QDense<VB> const& B,
+                  QDense<VC> const& C,
+                  Labels const& Lind,
+                  Labels const& Rind,
+                  Labels const& Cind)
+    {
+    auto plan = std::make_shared<QContractPlan>();
+    plan->Lind = Lind;
+    plan->Rind = Rind;
+    plan->Cind = Cind;
+    plan->Nis = Con.Nis;
+    plan->Coffsets = C.offsets;
+    plan->Csize = C.size();
+
+    auto costs = std::vector<Real>{};
+    auto record = 
+        [&plan,&costs,&Con,&A,&B,&C]
+        (DataRange<const VA> ablock, Labels const& Ablockind,
+         DataRange<const VB> bblock, Labels const& Bblockind,
+         DataRange<const VC> cblock, Labels const& Cblockind)
+        {
+        plan->pairs.emplace_back();
+        auto& p = plan->pairs.back();
+        p.aoffset = ablock.data()-A.data();
+        p.boffset = bblock.data()-B.data();
+        p.coffset = cblock.data()-C.data();
+        p.Arange.init(make_indexdim(Con.Lis,Ablockind));
+        p.Brange.init(make_indexdim(Con.Ris,Bblockind));
+        p.Crange.init(make_indexdim(Con.Nis,Cblockind));
+        if(!plan->Lind.empty() && !plan->Rind.empty())
+            {
+            p.props = computeCProps(p.Arange,plan->Lind,
+                                    p.Brange,plan->Rind,
+                                    p.Crange,plan->Cind);
+            }
+        costs.push_back(std::sqrt(Real(area(p.Arange))*Real(area(p.Brange))*Real(area(p.Crange))));
+        };
+    loopContractedBlocks(A,Con.Lis,B,Con.Ris,C,Con.Nis,record);
+
+    //Group pairs by destination block of C
+    auto order = std::vector<size_t>(plan->pairs.size());
+    for(auto n : range(order)) order[n] = n;
+    std::stable_sort(order.begin(),order.end(),
+                     [&plan](size_t n1, size_t n2)
+                     { return plan->pairs[n1].coffset < plan->pairs[n2].coffset; });
+    auto pairs = std::vector<QContractPlan::Pair>{};
+    pairs.reserve(order.size());
+    for(auto n : order)
+        {
+        auto& p = plan->pairs[n];
+        if(plan->groups.empty() || p.coffset != pairs[plan->groups.back().begin].coffset)
+            {
+            plan->groups.emplace_back();
+            plan->groups.back().begin = pairs.size();
+            }
+        plan->groups.back().end = pairs.size()+1;
+        plan->groups.back().cost += costs[n];
+        pairs.push_back(std::move(p));
+        }
+    plan->pairs = std::move(pairs);
+    return plan;
+    }
+
 template<typename VA, typename VB>
 void
 doTask(Contract<IQIndex>& Con,
@@ -442,64 +643,85 @@ doTask(Contract<IQIndex>& Con,
        QDense<VB> const& B,
        ManageStore& m)
     {
+    PROFILE_SCOPE("Contract<IQIndex>")
+    auto tstart = ContractTrace::clock_type::now();
     using VC = common_type<VA,VB>;
-    Labels Lind,
-          Rind;
-    computeLabels(Con.Lis,Con.Lis.r(),Con.Ris,Con.Ris.r(),Lind,Rind);
-    //compute new index set (Con.Nis):
-    Labels Cind;
-    const bool sortResult = false;
-    contractIS(Con.Lis,Lind,Con.Ris,Rind,Con.Nis,Cind,sortResult);
 
-    auto Cdiv = doTask(CalcDiv{Con.Lis},A)+doTask(CalcDiv{Con.Ris},B);
+    auto cachesize = Global::args().getInt("ContractPlanCacheSize",64);
+    auto key = QContractKey{};
+    auto plan = QContractPlanCache::plan_ptr{};
+    if(cachesize > 0)
+        {
+        key = makeQContractKey(Con,A.offsets,B.offsets);
+        plan = qcontractPlans().find(key);
+        }
 
-    //Allocate storage for C
-    START_TIMER(33)
-    auto nd = m.makeNewData<QDense<VC>>(Con.Nis,Cdiv);
-    STOP_TIMER(33)
+    QDense<VC>* nd = nullptr;
+    if(plan)
+        {
+        Con.Nis = plan->Nis;
+        nd = m.makeNewData<QDense<VC>>(plan->Coffsets,plan->Csize,0.);
+        }
+    else
+        {
+        PROFILE_SCOPE("make plan")
+        Labels Lind,
+               Rind;
+        computeLabels(Con.Lis,Con.Lis.r(),Con.Ris,Con.Ris.r(),Lind,Rind);
+        //compute new index set (Con.Nis):
+        Labels Cind;
+        const bool sortResult = false;
+        contractIS(Con.Lis,Lind,Con.Ris,Rind,Con.Nis,Cind,sortResult);
+
+        auto Cdiv = doTask(CalcDiv{Con.Lis},A)+doTask(CalcDiv{Con.Ris},B);
+
+        //Allocate storage for C
+        nd = m.makeNewData<QDense<VC>>(Con.Nis,Cdiv);
+
+        plan = makeQContractPlan(Con,A,B,*nd,Lind,Rind,Cind);
+        if(cachesize > 0) qcontractPlans().insert(std::move(key),plan,cachesize);
+        }
     auto& C = *nd;
 
     //Function to execute for each pair of
     //contracted blocks of A and B
     auto do_contract = 
-        [&Con,&Lind,&Rind,&Cind]
-        (DataRange<const VA> ablock, Labels const& Ablockind,
-         DataRange<const VB> bblock, Labels const& Bblockind,
-         DataRange<VC>       cblock, Labels const& Cblockind)
+        [&plan,&A,&B,&C](size_t n)
         {
-        Range Arange,
-              Brange,
-              Crange;
-        //Construct range objects for aref,bref,cref
-        //using IndexDim helper objects
-        Arange.init(make_indexdim(Con.Lis,Ablockind));
-        Brange.init(make_indexdim(Con.Ris,Bblockind));
-        Crange.init(make_indexdim(Con.Nis,Cblockind));
-
+        auto& p = plan->pairs[n];
         //"Wire up" TensorRef's pointing to blocks of A,B, and C
         //we are working with
-        auto aref = makeRef(ablock,&Arange);
-        auto bref = makeRef(bblock,&Brange);
-        auto cref = makeRef(cblock,&Crange);
+        auto aref = makeTenRef(A.data(),p.aoffset,A.size(),&p.Arange);
+        auto bref = makeTenRef(B.data(),p.boffset,B.size(),&p.Brange);
+        auto cref = makeTenRef(C.data(),p.coffset,C.size(),&p.Crange);
 
         //Compute cref += aref*bref
-        START_TIMER(2)
-        contract(aref,Lind,bref,Rind,cref,Cind,1.,1.);
-        STOP_TIMER(2)
+        if(p.props) contract(*p.props,aref,bref,cref,1.,1.);
+        else        contract(aref,plan->Lind,bref,plan->Rind,cref,plan->Cind,1.,1.);
         };
 
-    START_TIMER(20)
-    loopContractedBlocks(A,Con.Lis,
-                         B,Con.Ris,
-                         C,Con.Nis,
-                         do_contract);
-    STOP_TIMER(20)
+    //Number of threads used to compute
+    //block-block products (1 means serial)
+    auto nthread = getNThread();
+
+    runBlockGroups(plan->groups,nthread,do_contract);
 
 #ifdef USESCALE
-    START_TIMER(21)
     Con.scalefac = computeScalefac(C);
-    STOP_TIMER(21)
 #endif
+
+    if(contractTrace().active())
+        {
+        contractTrace().record(tstart,[&]()
+            {
+            auto t = TStats();
+            t.blocksparse = true;
+            t.A = tstatsTens(Con.Lis,plan->Lind,A.offsets,isCplx(A));
+            t.B = tstatsTens(Con.Ris,plan->Rind,B.offsets,isCplx(B));
+            t.C = tstatsTens(Con.Nis,plan->Cind,C.offsets,isCplx(C));
+            return t;
+            });
+        }
     }
 template void doTask(Contract<IQIndex>& Con,QDense<Real> const&,QDense<Real> const&,ManageStore&);
 template void doTask(Contract<IQIndex>& Con,QDense<Cplx> const&,QDense<Real> const&,ManageStore&);
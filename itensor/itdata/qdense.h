@@ -416,6 +416,20 @@ template<typename V>
 bool
 doTask(IsEmpty, QDense<V> const& d) { return d.offsets.empty(); }
 
+//Lookups of the cache of QDense contraction
+//plans (see "ContractPlanCacheSize")
+struct ContractPlanStats
+    {
+    size_t nhit = 0;  //contractions reusing a cached plan
+    size_t nmiss = 0; //contractions making a new plan
+    };
+
+ContractPlanStats
+contractPlanStats();
+
+void
+resetContractPlanStats();
+
 } //namespace itensor
 
 #endif
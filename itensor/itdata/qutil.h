@@ -5,7 +5,10 @@
 #ifndef __ITENSOR_QUTIL_H
 #define __ITENSOR_QUTIL_H
 
+#include <algorithm>
+#include <unordered_map>
 #include "itensor/indexset.h"
+#include "itensor/util/threadpool.h"
 
 namespace itensor {
 
@@ -97,18 +100,133 @@ getBlock(BlockSparse & d,
     return data_range_type{};
     }
 
+//
+// Block layout of a block-sparse storage
+// (such as QDense): the coordinates of each
+// block (its block index along each IQIndex,
+// as computed by computeBlockInd) are decoded
+// once from the offsets array, along with a
+// hashed map from block number to data offset
+//
+class BlockLayout
+    {
+    long rank_ = 0;
+    std::vector<long> coords_;
+        //^ coords_[n*rank_+j] is the block index
+        //  along IQIndex j of block n
+    std::vector<long> offsets_;
+    std::vector<long> strides_;
+    std::unordered_map<long,long> offset_of_;
+    public:
+
+    template<typename BlockSparse>
+    BlockLayout(BlockSparse const& d,
+                IQIndexSet const& is)
+      : rank_(is.r()),
+        strides_(is.r(),1)
+        {
+        for(auto j = 1l; j < rank_; ++j)
+            {
+            strides_[j] = strides_[j-1]*is[j-1].nindex();
+            }
+        coords_.reserve(rank_*d.offsets.size());
+        offsets_.reserve(d.offsets.size());
+        offset_of_.reserve(d.offsets.size());
+        auto block_ind = IntArray(rank_,0);
+        for(auto& bo : d.offsets)
+            {
+            if(rank_ > 0) computeBlockInd(bo.block,is,block_ind);
+            coords_.insert(coords_.end(),block_ind.begin(),block_ind.end());
+            offsets_.push_back(bo.offset);
+            offset_of_.emplace(bo.block,bo.offset);
+            }
+        }
+
+    size_t
+    nblock() const { return offsets_.size(); }
+
+    long
+    rank() const { return rank_; }
+
+    //Block index along IQIndex j of block n
+    long
+    coord(size_t n, long j) const { return coords_[n*rank_+j]; }
+
+    //Data offset of block n
+    long
+    offset(size_t n) const { return offsets_[n]; }
+
+    //Data offset of the block at coordinates
+    //block_ind, or -1 if it is not present
+    template<typename Indexable>
+    long
+    offsetOf(Indexable const& block_ind) const
+        {
+        if(rank_ == 0) return 0;
+        long b = 0;
+        for(auto j : range(rank_)) b += block_ind[j]*strides_[j];
+        auto it = offset_of_.find(b);
+        if(it == offset_of_.end()) return -1;
+        return it->second;
+        }
+
+    //Groups the blocks by their coordinates
+    //along the IQIndexes listed in "modes",
+    //returning a map from sectorKey(...,modes)
+    //to the blocks in that sector, in order
+    std::unordered_map<long,std::vector<size_t>>
+    sectors(IntArray const& modes) const
+        {
+        auto res = std::unordered_map<long,std::vector<size_t>>{};
+        for(auto n : range(nblock()))
+            {
+            res[sectorKey(coords_.data()+n*rank_,modes)].push_back(n);
+            }
+        return res;
+        }
+
+    //Number labeling the coordinates along "modes"
+    //of a block with coordinates block_ind
+    template<typename Indexable>
+    long
+    sectorKey(Indexable const& block_ind,
+              IntArray const& modes) const
+        {
+        long key = 0;
+        for(auto j : modes) key += block_ind[j]*strides_[j];
+        return key;
+        }
+    };
+
+//
+// True if BlockSparse lists its non-zero
+// blocks in an offsets array (as QDense does)
+//
+template<typename BlockSparse, typename = void>
+struct hasBlockOffsets : std::false_type { };
+
+template<typename BlockSparse>
+struct hasBlockOffsets<BlockSparse,decltype((void)std::declval<BlockSparse>().offsets)> 
+    : std::true_type { };
+
+namespace detail {
+
+//Version for B or C without an offsets array
+//(such as QDiag): loops over all possible blocks
+//of B matching each block of A, checking which exist
 template<typename BlockSparseA, 
          typename BlockSparseB,
          typename BlockSparseC,
          typename Callable>
 void
-loopContractedBlocks(BlockSparseA const& A,
+loopContractedBlocksImpl(BlockSparseA const& A,
                      IQIndexSet const& Ais,
                      BlockSparseB const& B,
                      IQIndexSet const& Bis,
                      BlockSparseC & C,
                      IQIndexSet const& Cis,
-                     Callable & callback)
+                     Callable & callback,
+                     std::false_type)
     {
     auto rA = Ais.r();
     auto rB = Bis.r();
@@ -146,11 +264,7 @@ loopContractedBlocks(BlockSparseA const& A,
     //Loop over blocks of A (labeled by elements of A.offsets)
     for(auto& aio : A.offsets)
         {
-        TIMER_START(19)
         //Reconstruct indices labeling this block of A, put into Ablock
-        //TODO: optimize away need to call computeBlockInd by
-        //      storing block indices directly in QDense
-        //      Taking 10% of running time in S=1 N=100 DMRG tests (maxm=100)
         computeBlockInd(aio.block,Ais,Ablockind);
         //Reset couB to run over indices of B (at first)
         couB.reset();
@@ -166,12 +280,9 @@ loopContractedBlocks(BlockSparseA const& A,
             //Begin computing elements of Cblock(=destination of this block-block contraction)
             if(AtoC[iA] != -1) Cblockind[AtoC[iA]] = ival;
             }
-        TIMER_STOP(19)
         //Loop over blocks of B which contract with current block of A
         for(;couB.notDone(); ++couB)
             {
-            TIMER_START(19)
-            //START_TIMER(33)
             //Check whether B contains non-zero block for this setting of couB
             //TODO: check whether block is present by storing all blocks
             //      but most have null pointers to data
@@ -190,7 +301,6 @@ loopContractedBlocks(BlockSparseA const& A,
             assert(cblock);
 
             auto ablock = makeDataRange(A.data(),aio.offset,A.size());
-            TIMER_STOP(19)
 
             callback(ablock,Ablockind,
                      bblock,Bblockind,
@@ -200,6 +310,182 @@ loopContractedBlocks(BlockSparseA const& A,
         } //for A.offsets
     }
 
+//Version for B and C having offsets arrays:
+//only visits the blocks of B in the same sector
+//as each block of A
+template<typename BlockSparseA, 
+         typename BlockSparseB,
+         typename BlockSparseC,
+         typename Callable>
+void
+loopContractedBlocksImpl(BlockSparseA const& A,
+                     IQIndexSet const& Ais,
+                     BlockSparseB const& B,
+                     IQIndexSet const& Bis,
+                     BlockSparseC & C,
+                     IQIndexSet const& Cis,
+                     Callable & callback,
+                     std::true_type)
+    {
+    auto rA = Ais.r();
+    auto rB = Bis.r();
+    auto rC = Cis.r();
+
+    auto AtoC = IntArray(rA,-1);
+    auto BtoC = IntArray(rB,-1);
+    for(auto ic : range(rC))
+        {
+        auto j = findindex(Ais,Cis[ic]);
+        if(j >= 0)
+            {
+            AtoC[j] = ic;
+            }
+        else
+            {
+            j = findindex(Bis,Cis[ic]);
+            BtoC[j] = ic;
+            }
+        }
+    //Contracted IQIndexes: contA[n] of A matches contB[n] of B
+    auto contA = IntArray{},
+         contB = IntArray{};
+    for(auto ia : range(rA))
+    for(auto ib : range(rB))
+        {
+        if(Ais[ia] == Bis[ib])
+            {
+            contA.push_back(ia);
+            contB.push_back(ib);
+            break;
+            }
+        }
+
+    auto Alayout = BlockLayout(A,Ais);
+    auto Blayout = BlockLayout(B,Bis);
+    auto Clayout = BlockLayout(C,Cis);
+    //Blocks of B, grouped by their coordinates along
+    //the contracted indices. Since B's coordinates
+    //along contB are labeled using strides of B,
+    //contBkey below computes the same key from
+    //a block of A.
+    auto Bsectors = Blayout.sectors(contB);
+    auto contBkey = IntArray(rB,0);
+
+    auto Ablockind = IntArray(rA,0);
+    auto Bblockind = IntArray(rB,0);
+    auto Cblockind = IntArray(rC,0);
+    //Loop over blocks of A
+    for(auto na : range(Alayout.nblock()))
+        {
+        for(auto iA : range(rA))
+            {
+            Ablockind[iA] = Alayout.coord(na,iA);
+            //Begin computing elements of Cblock(=destination of this block-block contraction)
+            if(AtoC[iA] != -1) Cblockind[AtoC[iA]] = Ablockind[iA];
+            }
+        for(auto n : range(contA)) contBkey[contB[n]] = Ablockind[contA[n]];
+        auto sector = Bsectors.find(Blayout.sectorKey(contBkey,contB));
+        if(sector == Bsectors.end()) continue;
+
+        auto ablock = makeDataRange(A.data(),Alayout.offset(na),A.size());
+
+        //Loop over blocks of B which contract with current block of A
+        for(auto nb : sector->second)
+            {
+            //Finish making Cblockind and Bblockind
+            for(auto iB : range(rB))
+                {
+                Bblockind[iB] = Blayout.coord(nb,iB);
+                if(BtoC[iB] != -1) Cblockind[BtoC[iB]] = Bblockind[iB];
+                }
+            auto bblock = makeDataRange(B.data(),Blayout.offset(nb),B.size());
+
+            auto coff = Clayout.offsetOf(Cblockind);
+            assert(coff >= 0);
+            auto cblock = makeDataRange(C.data(),coff,C.size());
+
+            callback(ablock,Ablockind,
+                     bblock,Bblockind,
+                     cblock,Cblockind);
+
+            } //for nb
+        } //for na
+    }
+
+} //namespace detail
+
+//
+// Calls callback for each pair of blocks of A and B
+// which are contracted with each other, passing
+// the corresponding block of C (which must exist)
+//
+template<typename BlockSparseA, 
+         typename BlockSparseB,
+         typename BlockSparseC,
+         typename Callable>
+void
+loopContractedBlocks(BlockSparseA const& A,
+                     IQIndexSet const& Ais,
+                     BlockSparseB const& B,
+                     IQIndexSet const& Bis,
+                     BlockSparseC & C,
+                     IQIndexSet const& Cis,
+                     Callable & callback)
+    {
+    //Exclusive time of this region is the
+    //bookkeeping of finding the block pairs
+    PROFILE_SCOPE("loopContractedBlocks")
+    using use_layout = std::integral_constant<bool,hasBlockOffsets<BlockSparseB>::value
+                                                && hasBlockOffsets<BlockSparseC>::value>;
+    detail::loopContractedBlocksImpl(A,Ais,B,Bis,C,Cis,callback,use_layout{});
+    }
+
+//
+// Range [begin,end) of block-pair tasks which
+// all write to the same block of C
+//
+struct BlockGroup
+    {
+    size_t begin = 0,
+           end = 0;
+    Real cost = 0;
+    };
+
+//
+// Calls f(n) for every task n of every group,
+// using up to nthread threads of the shared pool.
+// All tasks of a group run in order on the same
+// thread. Groups are handed out most expensive
+// first to whichever thread becomes free.
+//
+template<typename Callable>
+void
+runBlockGroups(std::vector<BlockGroup> groups,
+               int nthread,
+               Callable const& f)
+    {
+    if(nthread <= 1 || groups.size() <= 1)
+        {
+        for(auto& g : groups)
+        for(auto n = g.begin; n < g.end; ++n)
+            {
+            f(n);
+            }
+        return;
+        }
+
+    std::sort(groups.begin(),groups.end(),
+              [](BlockGroup const& g1, BlockGroup const& g2) { return g1.cost > g2.cost; });
+    parallelFor(groups.size(),nthread,
+                [&groups,&f](size_t j)
+                    {
+                    auto& g = groups[j];
+                    for(auto n = g.begin; n < g.end; ++n)
+                        {
+                        f(n);
+                        }
+                    });
+    }
 
 } //namespace itensor
 
@@ -7,6 +7,7 @@
 #include "itensor/util/range.h"
 #include "itensor/iqtensor.h"
 #include "itensor/tensor/algs.h"
+#include "itensor/util/threadpool.h"
 
 
 namespace itensor {
@@ -38,6 +39,69 @@ davidson(BigMatrixT const& A,
          std::vector<Tensor>& phi,
          Args const& args = Args::global());
 
+//
+// Work done by a call to blockDavidson
+//
+struct EigenSolverStats
+    {
+    int niter = 0;     //number of block iterations
+    long nmatvec = 0;  //number of calls to A.product
+    int nrestart = 0;  //number of subspace restarts
+    };
+
+//
+// Block Davidson algorithm for the N eigenvectors
+// with smallest eigenvalues of the Hermitian matrix A,
+// given N initial guesses phi.
+// Each iteration adds one correction vector per
+// unconverged eigenvector and applies A to all
+// of them at once, on up to "NThread" threads.
+// If A provides a diag() method its diagonal is used
+// as a preconditioner (disable with "Precondition=false").
+// Other named args: "MaxIter", "MinIter", "ErrGoal",
+// "MaxBasis" (subspace size before restarting)
+// and "DebugLevel".
+// Returns the N smallest eigenvalues.
+//
+template <class BigMatrixT, class Tensor> 
+std::vector<Real>
+blockDavidson(BigMatrixT const& A, 
+              std::vector<Tensor>& phi,
+              EigenSolverStats & stats,
+              Args const& args = Args::global());
+
+template <class BigMatrixT, class Tensor> 
+std::vector<Real>
+blockDavidson(BigMatrixT const& A, 
+              std::vector<Tensor>& phi,
+              Args const& args = Args::global());
+
+template <class BigMatrixT, class Tensor> 
+Real
+blockDavidson(BigMatrixT const& A, 
+              Tensor& phi,
+              Args const& args = Args::global());
+
+//
+// Use the Lanczos method to compute
+// phi -> exp(t*A)*phi for the Hermitian matrix A
+// (BigMatrixT objects must implement the method product).
+// The Krylov dimension grows until the estimated
+// error falls below "ErrGoal" or reaches "MaxIter";
+// if the error is still too large the time t
+// is split into smaller steps, each allowed its
+// share of "ErrGoal". Throws an ITError if a step
+// shorter than "MinStep" times t (default 1E-4)
+// would be needed; raise "MaxIter" in that case.
+// Returns the estimated error of the result.
+//
+template<typename BigMatrixT, typename Tensor>
+Real
+applyExp(BigMatrixT const& A,
+         Tensor& phi,
+         Cplx t,
+         Args const& args = Args::global());
+
 //
 // Use GMRES to iteratively solve A x = b for x.
 // (BigMatrixT objects must implement the methods product and size.)
@@ -76,6 +140,7 @@ davidson(BigMatrixT const& A,
          std::vector<Tensor>& phi,
          Args const& args)
     {
+    PROFILE_SCOPE("davidson")
     auto maxiter_ = args.getInt("MaxIter",2);
     auto errgoal_ = args.getReal("ErrGoal",1E-14);
     auto debug_level_ = args.getInt("DebugLevel",-1);
@@ -418,6 +483,475 @@ davidson(BigMatrixT const& A,
     return eigs;
     }
 
+namespace detail {
+
+template<typename BigMatrixT, typename Tensor>
+auto
+getDiagImpl(stdx::choice<1>, BigMatrixT const& A, Tensor & D)
+    -> stdx::if_compiles_return<bool,decltype(A.diag())>
+    {
+    D = A.diag();
+    return true;
+    }
+
+template<typename BigMatrixT, typename Tensor>
+bool
+getDiagImpl(stdx::choice<2>, BigMatrixT const& A, Tensor & D)
+    {
+    return false;
+    }
+
+//Sets D to the diagonal of A and returns true
+//if A has a diag() method
+template<typename BigMatrixT, typename Tensor>
+bool
+getDiag(BigMatrixT const& A, Tensor & D)
+    {
+    return getDiagImpl(stdx::select_overload{},A,D);
+    }
+
+//The diagonal of a block-sparse operator does not have
+//a well-defined divergence, so it can't be an IQTensor
+template<typename BigMatrixT>
+bool
+getDiag(BigMatrixT const& A, IQTensor & D)
+    {
+    return false;
+    }
+
+//Computes AX[j] = A*X[j] for j = first,...,X.size()-1
+template<typename BigMatrixT, typename Tensor>
+void
+blockProduct(BigMatrixT const& A,
+             std::vector<Tensor> const& X,
+             std::vector<Tensor> & AX,
+             size_t first,
+             int nthread)
+    {
+    AX.resize(X.size());
+    parallelFor(X.size()-first,nthread,
+                [&A,&X,&AX,first](size_t j) { A.product(X[first+j],AX[first+j]); });
+    }
+
+//Orthogonalizes q against V[0],...,V[n-1] (two passes of
+//Gram-Schmidt) and normalizes it. Returns false if q is
+//numerically in the span of the V's.
+template<typename Tensor>
+bool
+orthonormalize(Tensor & q,
+               std::vector<Tensor> const& V,
+               size_t n)
+    {
+    auto nrm0 = norm(q);
+    if(nrm0 == 0) return false;
+    for(int pass = 0; pass < 2; ++pass)
+    for(auto k : range(n))
+        {
+        auto z = (dag(V[k])*q).cplx();
+        q += (-z)*V[k];
+        }
+    auto nrm = norm(q);
+    if(nrm < 1E-10*nrm0) return false;
+    q *= 1./nrm;
+    q.scaleTo(1.);
+    return true;
+    }
+
+//Davidson preconditioner: r(i) -> r(i)/(lambda-Adiag(i))
+template<typename Tensor>
+void
+precondition(Tensor & r,
+             Tensor const& Adiag,
+             Real lambda)
+    {
+    auto cond = Adiag;
+    cond.apply([lambda](Real d)
+        {
+        auto den = lambda-d;
+        if(std::fabs(den) < 1E-6) den = (den < 0 ? -1E-6 : 1E-6);
+        return 1./den;
+        });
+    r /= cond;
+    }
+
+} //namespace detail
+
+template <class BigMatrixT, class Tensor> 
+std::vector<Real>
+blockDavidson(BigMatrixT const& A, 
+              std::vector<Tensor>& phi,
+              EigenSolverStats & stats,
+              Args const& args)
+    {
+    PROFILE_SCOPE("blockDavidson")
+    auto maxiter = args.getInt("MaxIter",2);
+    auto miniter = args.getInt("MinIter",1);
+    auto errgoal = args.getReal("ErrGoal",1E-14);
+    auto debug_level = args.getInt("DebugLevel",-1);
+    auto nthread = getNThread(args);
+
+    Real Approx0 = 1E-12;
+
+    stats = EigenSolverStats{};
+
+    auto nget = phi.size();
+    if(nget == 0) Error("No initial vectors passed to blockDavidson.");
+    auto maxsize = size_t(A.size());
+    if(area(phi.front().inds()) != maxsize)
+        {
+        println("area(phi.front().inds()) = ",area(phi.front().inds()));
+        println("A.size() = ",A.size());
+        Error("blockDavidson: size of initial vectors should match linear matrix size");
+        }
+    if(nget > maxsize) Error("blockDavidson: more eigenvectors requested than size of matrix");
+
+    auto maxbasis = size_t(args.getInt("MaxBasis",nget*(maxiter+1)));
+    maxbasis = std::min(std::max(maxbasis,2*nget),maxsize);
+
+    Tensor Adiag;
+    auto use_diag = args.getBool("Precondition",true) && detail::getDiag(A,Adiag);
+
+    //V: orthonormal basis, AV[k] = A*V[k], M = dag(V)*A*V
+    auto V = std::vector<Tensor>{};
+    auto AV = std::vector<Tensor>{};
+    V.reserve(maxbasis);
+    auto M = CMatrix(maxbasis,maxbasis);
+
+    for(auto j : range(nget))
+        {
+        auto q = phi[j];
+        int ntry = 0;
+        while(!detail::orthonormalize(q,V,V.size()))
+            {
+            if(++ntry > 3) Error("blockDavidson: could not make initial vectors independent");
+            randomize(q);
+            }
+        V.push_back(std::move(q));
+        }
+
+    //Apply A to V[first],...,V.back() and add
+    //the corresponding columns to M
+    auto expand = [&](size_t first)
+        {
+        detail::blockProduct(A,V,AV,first,nthread);
+        stats.nmatvec += V.size()-first;
+        for(auto j : range(first,V.size()))
+        for(auto k : range(j+1))
+            {
+            M(k,j) = (dag(V[k])*AV[j]).cplx();
+            M(j,k) = std::conj(M(k,j));
+            }
+        };
+    expand(0);
+
+    auto eigs = std::vector<Real>(nget,NAN);
+    auto last_eigs = std::vector<Real>(nget,1000.);
+    auto X = std::vector<Tensor>(nget);
+    auto AX = std::vector<Tensor>(nget);
+    Real maxqnorm = NAN;
+
+    for(int ii = 0; ; ++ii)
+        {
+        auto nV = V.size();
+
+        //Rayleigh-Ritz: diagonalize -M so that
+        //eigenvalues come out in increasing order
+        auto Mref = subMatrix(M,0,nV,0,nV);
+        Mref *= -1;
+        CMatrix U;
+        Vector D;
+        diagHermitian(Mref,U,D);
+        Mref *= -1;
+        D *= -1;
+
+        //Ritz vectors and residuals
+        auto Q = std::vector<Tensor>{};
+        auto Qeig = std::vector<Real>{};
+        maxqnorm = 0.;
+        bool all_converged = true;
+        for(auto j : range(nget))
+            {
+            eigs[j] = D(j);
+            X[j] = U(0,j)*V[0];
+            AX[j] = U(0,j)*AV[0];
+            for(auto k : range(1,nV))
+                {
+                X[j] += U(k,j)*V[k];
+                AX[j] += U(k,j)*AV[k];
+                }
+            if(U(0,j).real() < 0)
+                {
+                X[j] *= -1;
+                AX[j] *= -1;
+                }
+            auto q = AX[j] - eigs[j]*X[j];
+            auto qnorm = norm(q);
+            maxqnorm = std::max(maxqnorm,qnorm);
+            bool converged = (qnorm < errgoal && std::fabs(eigs[j]-last_eigs[j]) < errgoal)
+                             || qnorm < std::max(Approx0,errgoal*1E-3);
+            last_eigs[j] = eigs[j];
+            if(!converged)
+                {
+                all_converged = false;
+                Q.push_back(std::move(q));
+                Qeig.push_back(eigs[j]);
+                }
+            }
+
+        if(debug_level >= 2 || (ii == 0 && debug_level >= 1))
+            {
+            printf("I %d q %.0E E",ii,maxqnorm);
+            for(auto eig : eigs) printf(" %.10f",eig);
+            println();
+            }
+
+        if((all_converged && ii >= miniter) || ii >= maxiter || nV >= maxsize)
+            {
+            if(debug_level >= 3)
+                {
+                if(all_converged) printfln("Exiting blockDavidson because errgoal=%.0E reached",errgoal);
+                else if(ii >= maxiter) println("Exiting blockDavidson because ii == maxiter");
+                else println("Exiting blockDavidson: max Hilbert space size reached");
+                }
+            break;
+            }
+
+        //Restart from the lowest Ritz vectors if the
+        //corrections would not fit in the basis
+        if(nV+Q.size() > maxbasis)
+            {
+            auto nkeep = std::min(std::max(nget,maxbasis/2),maxbasis-Q.size());
+            nkeep = std::max(nkeep,nget);
+            if(debug_level >= 3) printfln("Restarting blockDavidson with %d vectors",nkeep);
+            auto newV = std::vector<Tensor>(nkeep);
+            auto newAV = std::vector<Tensor>(nkeep);
+            for(auto j : range(nkeep))
+                {
+                if(j < nget)
+                    {
+                    newV[j] = X[j];
+                    newAV[j] = AX[j];
+                    continue;
+                    }
+                newV[j] = U(0,j)*V[0];
+                newAV[j] = U(0,j)*AV[0];
+                for(auto k : range(1,nV))
+                    {
+                    newV[j] += U(k,j)*V[k];
+                    newAV[j] += U(k,j)*AV[k];
+                    }
+                }
+            V.swap(newV);
+            AV.swap(newAV);
+            for(auto j : range(nkeep))
+            for(auto k : range(nkeep))
+                {
+                M(k,j) = (j == k) ? Cplx(D(j),0.) : Cplx(0.,0.);
+                }
+            nV = nkeep;
+            ++stats.nrestart;
+            }
+
+        //Precondition and orthogonalize the residuals
+        //to form the new basis vectors
+        for(auto n : range(Q))
+            {
+            if(V.size() >= maxbasis) break;
+            auto& q = Q[n];
+            if(use_diag) detail::precondition(q,Adiag,Qeig[n]);
+            if(detail::orthonormalize(q,V,V.size()))
+                {
+                V.push_back(std::move(q));
+                }
+            else if(debug_level >= 2) 
+                {
+                println("blockDavidson: correction vector not independent, dropping it");
+                }
+            }
+        if(V.size() == nV)
+            {
+            if(debug_level >= 3) println("Exiting blockDavidson: no new directions");
+            break;
+            }
+
+        expand(nV);
+        ++stats.niter;
+        }
+
+    for(auto j : range(nget))
+        {
+        phi[j] = X[j];
+        if(phi[j].scale().logNum() > 2) phi[j].scaleTo(1.);
+        }
+
+    if(debug_level > 0)
+        {
+        printf("I %d q %.0E E",stats.niter,maxqnorm);
+        for(auto eig : eigs) printf(" %.10f",eig);
+        printfln(" (%d products)",stats.nmatvec);
+        }
+
+    return eigs;
+    }
+
+template <class BigMatrixT, class Tensor> 
+std::vector<Real>
+blockDavidson(BigMatrixT const& A, 
+              std::vector<Tensor>& phi,
+              Args const& args)
+    {
+    auto stats = EigenSolverStats{};
+    return blockDavidson(A,phi,stats,args);
+    }
+
+template <class BigMatrixT, class Tensor> 
+Real
+blockDavidson(BigMatrixT const& A, 
+              Tensor& phi,
+              Args const& args)
+    {
+    auto v = std::vector<Tensor>(1);
+    v.front() = phi;
+    auto eigs = blockDavidson(A,v,args);
+    phi = v.front();
+    return eigs.front();
+    }
+
+namespace detail {
+
+//Given the n x n Lanczos matrix T (diagonal alpha,
+//off-diagonal beta), sets c = exp(t*T)*e_0
+void
+inline
+expLanczos(std::vector<Real> const& alpha,
+           std::vector<Real> const& beta,
+           size_t n,
+           Cplx t,
+           std::vector<Cplx> & c)
+    {
+    auto T = Matrix(n,n);
+    for(auto j : range(n))
+        {
+        T(j,j) = alpha[j];
+        if(j+1 < n)
+            {
+            T(j,j+1) = beta[j];
+            T(j+1,j) = beta[j];
+            }
+        }
+    Matrix U;
+    Vector D;
+    diagHermitian(T,U,D);
+    c.assign(n,0.);
+    for(auto k : range(n))
+        {
+        auto f = std::exp(t*D(k))*U(0,k);
+        for(auto j : range(n)) c[j] += U(j,k)*f;
+        }
+    }
+
+} //namespace detail
+
+template<typename BigMatrixT, typename Tensor>
+Real
+applyExp(BigMatrixT const& A,
+         Tensor& phi,
+         Cplx t,
+         Args const& args)
+    {
+    auto maxiter = args.getInt("MaxIter",30);
+    auto miniter = args.getInt("MinIter",2);
+    auto errgoal = args.getReal("ErrGoal",1E-12);
+    auto minstep = args.getReal("MinStep",1E-4);
+    auto debug_level = args.getInt("DebugLevel",-1);
+
+    auto maxdim = std::max(size_t(1),std::min(size_t(maxiter),size_t(A.size())));
+
+    auto V = std::vector<Tensor>{};
+    V.reserve(maxdim+1);
+    auto alpha = std::vector<Real>{};
+    auto beta = std::vector<Real>{};
+    auto c = std::vector<Cplx>{};
+    Tensor w;
+
+    Real toterr = 0.;
+    long nmatvec = 0;
+    //Fraction of t still to be applied
+    Real remaining = 1.;
+    while(remaining > 0.)
+        {
+        auto nrm0 = norm(phi);
+        if(nrm0 == 0.) break;
+
+        V.clear();
+        alpha.clear();
+        beta.clear();
+        V.push_back(phi/nrm0);
+
+        auto tau = remaining;
+        Real err = NAN;
+        size_t n = 0;
+        for(auto j : range(maxdim))
+            {
+            A.product(V[j],w);
+            ++nmatvec;
+            alpha.push_back((dag(V[j])*w).cplx().real());
+            //Full reorthogonalization (twice is enough)
+            for(int pass = 0; pass < 2; ++pass)
+            for(auto k : range(j+1))
+                {
+                w += (-(dag(V[k])*w).cplx())*V[k];
+                }
+            beta.push_back(norm(w));
+            n = j+1;
+
+            detail::expLanczos(alpha,beta,n,tau*t,c);
+            //Size of the component exp(tau*t*A) would 
+            //give along the next Krylov vector
+            err = nrm0*beta[j]*std::abs(c[j]);
+
+            auto happy = beta[j] < 1E-14*nrm0;
+            if(happy || (err < tau*errgoal && long(n) >= miniter) || n == maxdim) break;
+            V.push_back(w/beta[j]);
+            }
+
+        //Krylov space too small for remaining time:
+        //shorten the step until its error is within
+        //its share tau*errgoal of the error goal
+        while(err > tau*errgoal)
+            {
+            if(tau/2 < minstep)
+                {
+                throw ITError(format("applyExp: error %.2E of step %.2E of t too large "
+                                     "with Krylov dimension %d; increase MaxIter",err,tau,n));
+                }
+            tau /= 2;
+            detail::expLanczos(alpha,beta,n,tau*t,c);
+            err = nrm0*beta[n-1]*std::abs(c[n-1]);
+            }
+
+        phi = (nrm0*c[0])*V[0];
+        for(auto j : range(1,n))
+            {
+            phi += (nrm0*c[j])*V[j];
+            }
+
+        toterr += err;
+        remaining -= tau;
+        if(remaining < 1E-12) remaining = 0.;
+        if(debug_level >= 2)
+            {
+            printfln("applyExp: step %.4f of t, Krylov dim %d, error %.2E",tau,n,err);
+            }
+        }
+
+    if(debug_level > 0)
+        {
+        printfln("applyExp: %d products, error %.2E",nmatvec,toterr);
+        }
+    return toterr;
+    }
+
 namespace gmres_details {
 
 template<class Matrix, class Tensor, class T>
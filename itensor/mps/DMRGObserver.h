@@ -7,6 +7,7 @@
 #include "itensor/mps/mps.h"
 #include "itensor/mps/observer.h"
 #include "itensor/spectrum.h"
+#include "itensor/util/opcount.h"
 
 namespace itensor {
 
@@ -36,6 +37,12 @@ class DMRGObserver : public Observer
     void virtual
     lastSpectrum(Spectrum const& spec) { last_spec_ = spec; }
 
+    void virtual
+    writeState(std::ostream& s) const;
+
+    void virtual
+    readState(std::istream& s);
+
     MPSt<Tensor> const& 
     psi() const { return psi_; }
     
@@ -54,6 +61,7 @@ class DMRGObserver : public Observer
     bool done_;
     Real last_energy_;
     Spectrum last_spec_;
+    OpCounts last_ops_;  //Op counts at the start of the sweep
 
     /////////////
 
@@ -69,7 +77,8 @@ DMRGObserver(MPSt<Tensor> const& psi, Args const& args)
     max_eigs(-1),
     max_te(-1),
     done_(false),
-    last_energy_(1000)
+    last_energy_(1000),
+    last_ops_(opCounter().counts())
     //default_ops_(psi.sites().defaultOps())
     { 
     }
@@ -140,6 +149,12 @@ measure(Args const& args)
         println("    Largest truncation error: ",(max_te > 0 ? max_te : 0.));
         max_te = -1;
         printfln("    Energy after sweep %s is %.12f",swstr,energy);
+        if(opCounter().enabled())
+            {
+            auto ops = opCounter().counts();
+            println("    ",showRates(ops-last_ops_));
+            last_ops_ = ops;
+            }
         }
 
     }
@@ -186,6 +201,27 @@ checkDone(Args const& args)
     
     return done_;
     }
+template<class Tensor>
+void inline DMRGObserver<Tensor>::
+writeState(std::ostream& s) const
+    {
+    itensor::write(s,max_eigs);
+    itensor::write(s,max_te);
+    itensor::write(s,done_);
+    itensor::write(s,last_energy_);
+    last_spec_.write(s);
+    }
+
+template<class Tensor>
+void inline DMRGObserver<Tensor>::
+readState(std::istream& s)
+    {
+    itensor::read(s,max_eigs);
+    itensor::read(s,max_te);
+    itensor::read(s,done_);
+    itensor::read(s,last_energy_);
+    last_spec_.read(s);
+    }
 
 } //namespace itensor
 
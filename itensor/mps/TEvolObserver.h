@@ -6,6 +6,7 @@
 #define __ITENSOR_TEVOLOBSERVER_H
 #include "itensor/util/readwrite.h"
 #include "itensor/mps/observer.h"
+#include "itensor/util/opcount.h"
 
 namespace itensor {
 
@@ -38,6 +39,7 @@ class TEvolObserver : public Observer
 
     bool done_,
          show_percent_;
+    OpCounts last_ops_;  //Op counts at the start of the time step
 
     //
     /////////////
@@ -48,7 +50,8 @@ inline TEvolObserver::
 TEvolObserver(const Args& args) 
     : 
     done_(false),
-    show_percent_(args.getBool("ShowPercent",true))
+    show_percent_(args.getBool("ShowPercent",true)),
+    last_ops_(opCounter().counts())
     { 
     }
 
@@ -57,7 +60,14 @@ void inline TEvolObserver::
 measure(const Args& args)
     {
     const Real t = args.getReal("Time");
-    if(show_percent_)
+    if(opCounter().enabled())
+        {
+        //Printed instead of the percentage
+        auto ops = opCounter().counts();
+        printfln("    Time %.5f: %s",t,showRates(ops-last_ops_));
+        last_ops_ = ops;
+        }
+    else if(show_percent_)
         {
         const Real ttotal = args.getReal("TotalTime");
         Real percentdone = (100.*t)/ttotal;
@@ -985,6 +985,7 @@ partitionHTerms(SiteSet const& sites,
                 vector<IQMatEls> & tempMPO,
                 bool checkqns = true)
     {
+    PROFILE_SCOPE("partitionHTerms")
     auto N = sites.N();
 
     // TODO: This version of calcQN uses a "qnmap" to improve
@@ -1038,16 +1039,13 @@ partitionHTerms(SiteSet const& sites,
         SiteTermProd left, onsite, right;
         decomposeTerm(n, ht.ops, left, onsite, right);
         
-        TIMER_START(10)
         QN lqn,sqn;
         if(checkqns)
             {
             lqn = calcQN(left);
             sqn = calcQN(onsite);
             }
-        TIMER_STOP(10)
         
-        TIMER_START(11)
         int j=-1,k=-1;
 
         // qbs.at(i) are the blocks at the link between sites i+1 and i+2
@@ -1090,13 +1088,11 @@ partitionHTerms(SiteSet const& sites,
             {
             rewriteFermionic(onsite, leftF);
             }
-        TIMER_STOP(11)
         
         //
         // Add only unique IQMPOMatElems to tempMPO
         // TODO: assumes terms are unique I think!
         // 
-        TIMER_START(12)
         auto& tn = tempMPO.at(n-1);
         auto el = IQMPOMatElem(lqn, lqn+sqn, j, k, HTerm(c, onsite));
 
@@ -1116,7 +1112,6 @@ partitionHTerms(SiteSet const& sites,
         auto it = tn.find(el);
         if(it == tn.end()) tn.insert(move(el));
 
-        TIMER_STOP(12)
         }
     }
 
@@ -1375,6 +1370,7 @@ MPOt<Tensor>
 svdMPO(AutoMPO const& am, 
          Args const& args)
     {
+    PROFILE_SCOPE("svdMPO")
     bool isExpH = false;
     Cplx tau = 0.;
 
@@ -10,7 +10,9 @@
 #include "itensor/mps/localmpo_mps.h"
 #include "itensor/mps/sweeps.h"
 #include "itensor/mps/DMRGObserver.h"
+#include "itensor/mps/dmrgcheckpoint.h"
 #include "itensor/util/cputime.h"
+#include "itensor/util/multalloc.h"
 
 
 namespace itensor {
@@ -50,6 +52,45 @@ dmrg(MPSt<Tensor>& psi,
     return energy;
     }
 
+//
+//Resume DMRG with an MPO from a checkpoint written
+//by an earlier call given the "CheckpointFile" arg.
+//psi is replaced by the checkpointed MPS; H, sweeps
+//and args should be the same as for that call.
+//Checkpoints keep being written to ckpt's file
+//unless "CheckpointFile" is set to another one.
+//
+template <class Tensor>
+Real
+dmrg(MPSt<Tensor>& psi, 
+     const MPOt<Tensor>& H, 
+     const Sweeps& sweeps,
+     const DMRGCheckpoint& ckpt,
+     const Args& args = Global::args())
+    {
+    LocalMPO<Tensor> PH(H,args);
+    DMRGObserver<Tensor> obs(psi,args);
+    Real energy = DMRGWorker(psi,PH,sweeps,obs,ckpt,args);
+    return energy;
+    }
+
+//
+//Resume DMRG with an MPO and custom DMRGObserver
+//
+template <class Tensor>
+Real
+dmrg(MPSt<Tensor>& psi, 
+     const MPOt<Tensor>& H, 
+     const Sweeps& sweeps, 
+     DMRGObserver<Tensor>& obs,
+     const DMRGCheckpoint& ckpt,
+     const Args& args = Global::args())
+    {
+    LocalMPO<Tensor> PH(H,args);
+    Real energy = DMRGWorker(psi,PH,sweeps,obs,ckpt,args);
+    return energy;
+    }
+
 //
 //DMRG with an MPO and boundary tensors LH, RH
 // LH - H1 - H2 - ... - HN - RH
@@ -193,18 +234,108 @@ DMRGWorker(MPSt<Tensor>& psi,
            DMRGObserver<Tensor>& obs,
            Args args = Global::args())
     {
+    return DMRGWorker(psi,PH,sweeps,obs,DMRGCheckpoint(),args);
+    }
+
+//
+//If ckpt is not empty, continues from the checkpoint
+//
+//Named Args recognized for checkpointing:
+// CheckpointFile - write checkpoints of psi, PH, the sweep
+//                  position and observer state to this file
+// CheckpointInterval - minimum wall time in seconds
+//                      between checkpoints (default 3600);
+//                      0 saves at every step, waiting for
+//                      the previous checkpoint to be written
+//
+//Named Args recognized for profiling:
+// ProfileFile - enable the profiler (see util/profiler.h) during
+//               this call and append its statistics to this
+//               file as one line of JSON at the end of each sweep
+//               (the environment variable ITENSOR_PROFILE
+//               has the same effect)
+// EventTraceFile - record a timeline of the profiled regions
+//                  at each bond (see util/eventtrace.h) and
+//                  write it to this file when dmrg returns
+// EventTraceSize - maximum number of events kept (default 2^18)
+// EventTraceDepth - only record regions nested at most this
+//                   deep (by default all are recorded)
+// CountOps - count the flops and bytes of gemms, permutations
+//            and decompositions (see util/opcount.h); the
+//            observer prints their rates after each sweep
+//
+template <class Tensor, class LocalOpT>
+Real
+DMRGWorker(MPSt<Tensor>& psi,
+           LocalOpT& PH,
+           const Sweeps& sweeps,
+           DMRGObserver<Tensor>& obs,
+           const DMRGCheckpoint& ckpt,
+           Args args = Global::args())
+    {
     const bool quiet = args.getBool("Quiet",false);
     const int debug_level = args.getInt("DebugLevel",(quiet ? 0 : 1));
+    //"EigenSolver" can be "Davidson" (default) or "BlockDavidson"
+    const bool block_solver = (args.getString("EigenSolver","Davidson") == "BlockDavidson");
 
     const int N = psi.N();
     Real energy = NAN;
 
-    psi.position(1);
+    if(ckpt)
+        {
+        psi.readTensorFile(ckpt.file,{"Lazy",false});
+        PH.restoreEdges(ckpt.edges<Tensor>());
+        std::istringstream os(ckpt.observer);
+        obs.readState(os);
+        energy = ckpt.energy;
+        if(!quiet)
+            {
+            printfln("Resuming from checkpoint \"%s\" at Sweep=%d, HS=%d, Bond=%d",
+                     ckpt.file,ckpt.sweep,ckpt.halfsweep,ckpt.bond);
+            }
+        }
+    else
+        {
+        psi.position(1);
+        }
+
+    DMRGCheckpointer<Tensor> checkpoint(args.getString("CheckpointFile",ckpt.file),args);
+    //Saves the state before step (sw,ha,b)
+    auto saveCheckpoint = [&](int sw, int ha, int b)
+        {
+        auto c = DMRGCheckpoint();
+        c.sweep = sw;
+        c.halfsweep = ha;
+        c.bond = b;
+        c.energy = energy;
+        std::ostringstream os;
+        obs.writeState(os);
+        c.observer = os.str();
+        checkpoint.write(std::move(c),psi,PH);
+        };
+
+    //With "MaxMemoryGB" the edge tensors and MPS tensors
+    //share a memory budget: least recently used ones are
+    //spilled to "WriteDir" only if it is exceeded.
+    //This replaces "WriteM".
+    auto spill = std::shared_ptr<SpillManager>();
+    if(args.defined("MaxMemoryGB"))
+        {
+        spill = std::make_shared<SpillManager>(size_t(args.getReal("MaxMemoryGB")*1E9));
+        PH.memoryBudget(spill,args);
+        psi.memoryBudget(spill,args);
+        }
+
+    ProfileSession profile(args.getString("ProfileFile",""));
+    OpCountSession count_ops(args.getBool("CountOps",false));
+    EventTraceSession trace(args.getString("EventTraceFile",""),
+                            args.getInt("EventTraceSize",EventTracer::default_capacity),
+                            args.getInt("EventTraceDepth",-1));
 
     args.add("DebugLevel",debug_level);
     args.add("DoNormalize",true);
     
-    for(int sw = 1; sw <= sweeps.nsweep(); ++sw)
+    for(int sw = ckpt.sweep; sw <= sweeps.nsweep(); ++sw)
         {
         cpu_time sw_time;
         args.add("Sweep",sw);
@@ -215,7 +346,8 @@ DMRGWorker(MPSt<Tensor>& psi,
         args.add("Noise",sweeps.noise(sw));
         args.add("MaxIter",sweeps.niter(sw));
 
-        if(!PH.doWrite()
+        if(!spill
+           && !PH.doWrite()
            && args.defined("WriteM")
            && sweeps.maxm(sw) >= args.getInt("WriteM"))
             {
@@ -229,8 +361,13 @@ DMRGWorker(MPSt<Tensor>& psi,
             PH.doWrite(true,args);
             }
 
-        for(int b = 1, ha = 1; ha <= 2; sweepnext(b,ha,N))
+        auto resuming = (ckpt && sw == ckpt.sweep);
+        for(int b = (resuming ? ckpt.bond : 1), 
+                ha = (resuming ? ckpt.halfsweep : 1); 
+            ha <= 2; sweepnext(b,ha,N))
             {
+            eventTracer().setPosition(sw,b);
+            PROFILE_SCOPE_BYTES("dmrg step",storageBytes(psi.A(b))+storageBytes(psi.A(b+1)))
             if(!quiet)
                 {
                 printfln("Sweep=%d, HS=%d, Bond=%d/%d",sw,ha,b,(N-1));
@@ -240,7 +377,18 @@ DMRGWorker(MPSt<Tensor>& psi,
 
             auto phi = psi.A(b)*psi.A(b+1);
 
-            energy = davidson(PH,phi,args);
+            if(block_solver)
+                {
+                auto stats = EigenSolverStats{};
+                auto v = std::vector<Tensor>{{phi}};
+                energy = blockDavidson(PH,v,stats,args).front();
+                phi = v.front();
+                args.add("NMatVec",stats.nmatvec);
+                }
+            else
+                {
+                energy = davidson(PH,phi,args);
+                }
             
             auto spec = psi.svdBond(b,phi,(ha==1?Fromleft:Fromright),PH,args);
 
@@ -265,16 +413,45 @@ DMRGWorker(MPSt<Tensor>& psi,
 
             obs.measure(args);
 
+            if(checkpoint.due() && !(ha == 2 && b == 1))
+                {
+                auto nb = b, nha = ha;
+                sweepnext(nb,nha,N);
+                saveCheckpoint(sw,nha,nb);
+                }
+
             } //for loop over b
 
         auto sm = sw_time.sincemark();
         printfln("    Sweep %d/%d CPU time = %s (Wall time = %s)",
                   sw,sweeps.nsweep(),showtime(sm.time),showtime(sm.wall));
+        if(spill)
+            {
+            printfln("    Memory used = %.3g GB (peak %.3g GB), spilled to disk = %.3g GB",
+                     spill->liveBytes()/1E9,spill->peakBytes()/1E9,spill->spilledBytes()/1E9);
+            }
+        if(profiler().enabled()) profiler().dump(format("Sweep %d",sw));
+
+        //Scratch memory kept by the threads is
+        //not counted in the memory budget
+        trimScratch();
 
-        if(obs.checkDone(args)) break;
+        if(obs.checkDone(args)) 
+            {
+            if(checkpoint) saveCheckpoint(sweeps.nsweep()+1,1,1);
+            break;
+            }
+
+        if(checkpoint.due() || (checkpoint && sw == sweeps.nsweep())) 
+            {
+            saveCheckpoint(sw+1,1,1);
+            }
     
         } //for loop over sw
-    
+
+    checkpoint.wait();
+
+    psi.memoryBudget(nullptr);
     psi.normalize();
 
     return energy;
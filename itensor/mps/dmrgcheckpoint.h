@@ -0,0 +1,245 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_DMRGCHECKPOINT_H
+#define __ITENSOR_DMRGCHECKPOINT_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <future>
+#include "itensor/tensorfile.h"
+#include "itensor/mps/localmpo.h"
+
+namespace itensor {
+
+//
+// Position and state of a DMRG calculation saved
+// by dmrg when the "CheckpointFile" arg is given.
+//
+// A checkpoint is a TensorFile holding the MPS (readable
+// with MPSt::readTensorFile), the valid edge tensors of the
+// projected Hamiltonian, and the sweep position of the next
+// step together with the energy and observer state.
+//
+// Passing DMRGCheckpoint(fname) to dmrg resumes the
+// calculation exactly where the checkpoint was taken.
+//
+class DMRGCheckpoint
+    {
+    public:
+    std::string file;
+    //Next step to do
+    int sweep = 1,
+        halfsweep = 1,
+        bond = 1;
+    Real energy = NAN;
+    //Saved by Observer::writeState
+    std::string observer;
+
+    DMRGCheckpoint() { }
+
+    //Reads the sweep position and observer state
+    //from the checkpoint file fname
+    explicit
+    DMRGCheckpoint(std::string const& fname)
+      : file(fname)
+        {
+        TensorFile f(fname);
+        if(!f.hasAttribute("DMRG"))
+            {
+            throw ITError(format("File \"%s\" is not a DMRG checkpoint",fname));
+            }
+        std::istringstream s(f.attribute("DMRG"));
+        itensor::read(s,sweep);
+        itensor::read(s,halfsweep);
+        itensor::read(s,bond);
+        itensor::read(s,energy);
+        itensor::read(s,observer);
+        }
+
+    explicit operator bool() const { return !file.empty(); }
+
+    //Edge tensors saved by LocalOpT::saveEdges
+    template<class Tensor>
+    std::vector<EdgeTensors<Tensor>>
+    edges() const
+        {
+        TensorFile f(file);
+        std::istringstream s(f.attribute("Edges"));
+        auto nset = 0;
+        itensor::read(s,nset);
+        auto E = std::vector<EdgeTensors<Tensor>>(nset);
+        for(auto n : range(nset))
+            {
+            auto size = 0;
+            itensor::read(s,E[n].LHlim);
+            itensor::read(s,E[n].RHlim);
+            itensor::read(s,size);
+            E[n].PH.resize(size);
+            for(auto j : range(size))
+                {
+                auto name = format("PH%d_%03d",n,j);
+                if(f.has(name)) E[n].PH[j] = f.read<Tensor>(name);
+                }
+            }
+        return E;
+        }
+    };
+
+//Writes c.file (replacing it only once the new
+//checkpoint is complete). Tensors held in files
+//are read one at a time while writing them.
+template<class Tensor>
+void
+writeCheckpoint(DMRGCheckpoint const& c,
+                MPSTensors<Tensor> const& psi,
+                std::vector<EdgeTensors<Tensor>> const& E)
+    {
+    auto tmpname = c.file + ".tmp";
+    TensorFileWriter w(tmpname);
+    try
+        {
+        psi.writeTensorFile(w);
+
+        std::ostringstream es;
+        itensor::write(es,int(E.size()));
+        for(auto n : range(E))
+            {
+            itensor::write(es,E[n].LHlim);
+            itensor::write(es,E[n].RHlim);
+            itensor::write(es,int(E[n].PH.size()));
+            for(auto j : range(E[n].PH))
+                {
+                auto name = format("PH%d_%03d",n,j);
+                if(j < E[n].PHfile.size() && !E[n].PHfile[j].empty())
+                    {
+                    w.write(name,readFromFile<Tensor>(E[n].PHfile[j]));
+                    }
+                else if(E[n].PH[j])
+                    {
+                    w.write(name,E[n].PH[j]);
+                    }
+                }
+            }
+        w.writeAttribute("Edges",es.str());
+
+        std::ostringstream ds;
+        itensor::write(ds,c.sweep);
+        itensor::write(ds,c.halfsweep);
+        itensor::write(ds,c.bond);
+        itensor::write(ds,c.energy);
+        itensor::write(ds,c.observer);
+        w.writeAttribute("DMRG",ds.str());
+        w.close();
+        }
+    catch(...)
+        {
+        //Leave no partial checkpoint behind
+        w.discard();
+        throw;
+        }
+
+    if(std::rename(tmpname.c_str(),c.file.c_str()) != 0)
+        {
+        throw ITError("Couldn't rename \"" + tmpname + "\" to \"" + c.file + "\"");
+        }
+    }
+
+//
+// Writes checkpoints on a background thread at
+// most every "CheckpointInterval" seconds (wall time).
+// A checkpoint falling due while the previous one is
+// still being written is skipped, unless the interval
+// is 0: then every step is saved, after waiting for
+// the previous checkpoint.
+//
+// Tensors kept on disk, such as those spilled under
+// a memory budget, are not loaded into memory: their
+// files are copied into a temporary directory in
+// "WriteDir" and read back one at a time by the
+// background thread.
+//
+template<class Tensor>
+class DMRGCheckpointer
+    {
+    using Clock = std::chrono::steady_clock;
+    std::string file_,
+                writedir_;
+    Real interval_ = 0;
+    Clock::time_point last_;
+    std::future<void> pending_;
+    public:
+
+    DMRGCheckpointer(std::string const& fname,
+                     Args const& args = Args::global())
+      : file_(fname),
+        writedir_(args.getString("WriteDir","./")),
+        interval_(args.getReal("CheckpointInterval",3600)),
+        last_(Clock::now())
+        { }
+
+    DMRGCheckpointer(DMRGCheckpointer const&) = delete;
+    DMRGCheckpointer& operator=(DMRGCheckpointer const&) = delete;
+
+    ~DMRGCheckpointer() { if(pending_.valid()) pending_.wait(); }
+
+    explicit operator bool() const { return !file_.empty(); }
+
+    bool
+    due() const
+        {
+        if(file_.empty()) return false;
+        //write() waits for the pending checkpoint
+        if(interval_ <= 0) return true;
+        if(pending_.valid()
+           && pending_.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+            return false;
+            }
+        auto elapsed = std::chrono::duration<Real>(Clock::now()-last_).count();
+        return elapsed >= interval_;
+        }
+
+    //Takes copies of the tensors of psi and the edge
+    //tensors of PH (cheap since tensor storage is shared
+    //until modified) and writes them in the background
+    template<class LocalOpT>
+    void
+    write(DMRGCheckpoint c,
+          MPSt<Tensor> const& psi,
+          LocalOpT const& PH)
+        {
+        wait();
+        c.file = file_;
+        auto copydir = std::make_shared<TempDir>("ckpt",writedir_);
+        auto A = psi.saveTensors(copydir->name());
+        auto E = PH.saveEdges(copydir->name());
+        pending_ = std::async(std::launch::async,
+                              [](DMRGCheckpoint const& c,
+                                 MPSTensors<Tensor> const& A,
+                                 std::vector<EdgeTensors<Tensor>> const& E,
+                                 std::shared_ptr<TempDir>)
+                                 {
+                                 //The copies are deleted when
+                                 //this task's TempDir is released
+                                 writeCheckpoint(c,A,E);
+                                 },
+                              std::move(c),std::move(A),std::move(E),std::move(copydir));
+        last_ = Clock::now();
+        }
+
+    //Waits for the pending checkpoint, rethrowing
+    //any error which occurred writing it
+    void
+    wait()
+        {
+        if(pending_.valid()) pending_.get();
+        }
+    };
+
+} //namespace itensor
+
+#endif
@@ -6,10 +6,31 @@
 #define __ITENSOR_LOCALMPO
 #include "itensor/mps/mpo.h"
 #include "itensor/mps/localop.h"
+#include "itensor/util/asyncfile.h"
+#include "itensor/mps/spillmanager.h"
 #include "itensor/util/print_macro.h"
 
 namespace itensor {
 
+//
+// Edge tensors of a LocalMPO valid at its
+// current position: PH[j] for j <= LHlim and
+// j >= RHlim (the others are null). Used to
+// checkpoint and restore DMRG calculations.
+//
+// If PHfile is not empty and PHfile[j] is not
+// empty, PH[j] is null and held by the file
+// PHfile[j] (written by writeToFile) instead.
+//
+template<class Tensor>
+struct EdgeTensors
+    {
+    std::vector<Tensor> PH;
+    std::vector<std::string> PHfile;
+    int LHlim = 0,
+        RHlim = 0;
+    };
+
 //
 // The LocalMPO class projects an MPO 
 // into the reduced Hilbert space of
@@ -188,9 +209,29 @@ class LocalMPO
             {
             initWrite(args); 
             }
+        if(!val) io_.reset();
         do_write_ = val; 
         }
 
+    //Instead of doWrite(true), keep edge tensors in
+    //memory but spill least recently used ones to disk
+    //when tensors tracked by m exceed its budget.
+    //Passing nullptr loads all tensors back.
+    void
+    memoryBudget(std::shared_ptr<SpillManager> const& m,
+                 Args const& args = Args::global());
+
+    //Copies of a LocalMPO with a memory budget
+    //load the tensors spilled by the original,
+    //then spill to their own directory
+    LocalMPO(LocalMPO const& other);
+    LocalMPO(LocalMPO && other);
+
+    LocalMPO&
+    operator=(LocalMPO const& other);
+    LocalMPO&
+    operator=(LocalMPO && other);
+
     std::string const&
     writeDir() const { return writedir_; }
 
@@ -200,6 +241,18 @@ class LocalMPO
     int
     rightLim() const { return RHlim_; }
 
+    //Copies of the valid edge tensors, one entry per
+    //LocalMPO. Tensors written to disk are loaded, or
+    //if copydir is given their files are copied into
+    //copydir instead (see EdgeTensors::PHfile).
+    std::vector<EdgeTensors<Tensor>>
+    saveEdges(std::string const& copydir = "") const;
+
+    //Replaces the edge tensors by ones
+    //returned by saveEdges()
+    void
+    restoreEdges(std::vector<EdgeTensors<Tensor>> E);
+
     private:
 
     /////////////////
@@ -216,6 +269,15 @@ class LocalMPO
 
     bool do_write_ = false;
     std::string writedir_ = "./";
+    //Directory used by memoryBudget, declared
+    //before io_ so pending writes finish first
+    std::shared_ptr<TempDir> spilldir_;
+    //Background I/O for doWrite(true)
+    std::shared_ptr<AsyncFileStore<Tensor>> io_;
+    int lastb_ = 0;
+    //Used by memoryBudget
+    SpillHandle spill_;
+    std::vector<bool> spilled_;
 
     const MPSt<Tensor>* Psi_;
 
@@ -239,6 +301,24 @@ class LocalMPO
     void
     initWrite(Args const& args);
 
+    void
+    writePH(int j);
+
+    void
+    readPH(int j);
+
+    void
+    prefetchPH(int j);
+
+    bool
+    spillPH(int j);
+
+    void
+    loadPH(int j);
+
+    void
+    dropPH(int j);
+
     std::string
     PHFName(int j) const
         {
@@ -395,6 +475,7 @@ inline void LocalMPO<Tensor>::
 position(int b, const MPSType& psi)
     {
     if(!(*this)) Error("LocalMPO is null");
+    PROFILE_SCOPE("LocalMPO::position")
 
     makeL(psi,b-1);
     makeR(psi,b+nc_);
@@ -413,6 +494,12 @@ position(int b, const MPSType& psi)
         {
         lop_.update(Op_->A(b),Op_->A(b+1),L(),R());
         }
+
+    //Start loading the edge tensor needed
+    //at the next bond in the same direction
+    if(b > lastb_) prefetchPH(b+nc_+1);
+    else if(b < lastb_) prefetchPH(b-2);
+    lastb_ = b;
     }
 
 template <class Tensor>
@@ -431,6 +518,7 @@ inline void LocalMPO<Tensor>::
 shift(int j, Direction dir, const Tensor& A)
     {
     if(!(*this)) Error("LocalMPO is null");
+    PROFILE_SCOPE_BYTES("LocalMPO::shift",storageBytes(A))
 
 #ifdef DEBUG
     if(nc_ != 2)
@@ -480,6 +568,7 @@ template <class MPSType>
 inline void LocalMPO<Tensor>::
 makeL(const MPSType& psi, int k)
     {
+    PROFILE_SCOPE("LocalMPO::makeL")
     if(!PH_.empty())
         {
         if(Op_ == 0) //Op is actually an MPS
@@ -518,6 +607,7 @@ template <class MPSType>
 inline void LocalMPO<Tensor>::
 makeR(const MPSType& psi, int k)
     {
+    PROFILE_SCOPE("LocalMPO::makeR")
     if(!PH_.empty())
         {
         if(Op_ == 0) //Op is actually an MPS
@@ -561,6 +651,17 @@ template <class Tensor>
 void inline LocalMPO<Tensor>::
 setLHlim(int val)
     {
+    if(spill_)
+        {
+        //Left edge tensors past val are out of date,
+        //unless makeR already replaced them
+        for(auto j = val+1; j <= LHlim_ && j < RHlim_; ++j) dropPH(j);
+        //Just made by makeL, any file of it is out of date
+        if(val > LHlim_) spilled_.at(val) = false;
+        LHlim_ = val;
+        loadPH(LHlim_);
+        return;
+        }
     if(!do_write_)
         {
         LHlim_ = val;
@@ -569,8 +670,7 @@ setLHlim(int val)
 
     if(LHlim_ != val && PH_.at(LHlim_))
         {
-        writeToFile(PHFName(LHlim_),PH_.at(LHlim_));
-        PH_.at(LHlim_) = Tensor();
+        writePH(LHlim_);
         }
     LHlim_ = val;
     if(LHlim_ < 1) 
@@ -581,8 +681,7 @@ setLHlim(int val)
         }
     if(!PH_.at(LHlim_))
         {
-        std::string fname = PHFName(LHlim_);
-        readFromFile(fname,PH_.at(LHlim_));
+        readPH(LHlim_);
         }
     }
 
@@ -590,6 +689,17 @@ template <class Tensor>
 void inline LocalMPO<Tensor>::
 setRHlim(int val)
     {
+    if(spill_)
+        {
+        //Right edge tensors before val are out of date,
+        //unless makeL already replaced them
+        for(auto j = std::max(RHlim_,LHlim_+1); j < val; ++j) dropPH(j);
+        //Just made by makeR, any file of it is out of date
+        if(val < RHlim_) spilled_.at(val) = false;
+        RHlim_ = val;
+        loadPH(RHlim_);
+        return;
+        }
     if(!do_write_)
         {
         RHlim_ = val;
@@ -598,8 +708,7 @@ setRHlim(int val)
 
     if(RHlim_ != val && PH_.at(RHlim_))
         {
-        writeToFile(PHFName(RHlim_),PH_.at(RHlim_));
-        PH_.at(RHlim_) = Tensor();
+        writePH(RHlim_);
         }
     RHlim_ = val;
     if(RHlim_ > Op_->N()) 
@@ -610,8 +719,7 @@ setRHlim(int val)
         }
     if(!PH_.at(RHlim_))
         {
-        std::string fname = PHFName(RHlim_);
-        readFromFile(fname,PH_.at(RHlim_));
+        readPH(RHlim_);
         }
     }
 
@@ -621,6 +729,246 @@ initWrite(Args const& args)
     {
     auto basedir = args.getString("WriteDir","./");
     writedir_ = mkTempDir("PH",basedir);
+    if(args.getBool("AsyncIO",true))
+        {
+        io_ = std::make_shared<AsyncFileStore<Tensor>>();
+        }
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+writePH(int j)
+    {
+    PROFILE_SCOPE_BYTES("LocalMPO::writePH",storageBytes(PH_.at(j)))
+    if(io_) io_->write(PHFName(j),std::move(PH_.at(j)));
+    else    writeToFile(PHFName(j),PH_.at(j));
+    PH_.at(j) = Tensor();
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+readPH(int j)
+    {
+    PROFILE_SCOPE("LocalMPO::readPH")
+    if(io_) PH_.at(j) = io_->read(PHFName(j));
+    else    readFromFile(PHFName(j),PH_.at(j));
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+prefetchPH(int j)
+    {
+    if(!io_ || j < 1 || j > Op_->N()) return;
+    auto ondisk = spill_ ? bool(spilled_.at(j)) : (do_write_ && !PH_.at(j));
+    if(ondisk) io_->prefetch(PHFName(j));
+    }
+
+template <class Tensor>
+inline LocalMPO<Tensor>::
+LocalMPO(LocalMPO const& other)
+    : LocalMPO()
+    {
+    *this = other;
+    }
+
+template <class Tensor>
+inline LocalMPO<Tensor>::
+LocalMPO(LocalMPO && other)
+    : LocalMPO()
+    {
+    *this = std::move(other);
+    }
+
+template <class Tensor> inline
+LocalMPO<Tensor>& LocalMPO<Tensor>::
+operator=(LocalMPO const& other)
+    {
+    if(this == &other) return *this;
+    spill_.reset();
+    spilled_.clear();
+    Op_ = other.Op_;
+    PH_ = other.PH_;
+    LHlim_ = other.LHlim_;
+    RHlim_ = other.RHlim_;
+    nc_ = other.nc_;
+    lop_ = other.lop_;
+    do_write_ = other.do_write_;
+    writedir_ = other.writedir_;
+    io_ = other.io_;
+    spilldir_.reset();
+    lastb_ = other.lastb_;
+    Psi_ = other.Psi_;
+    if(other.spill_)
+        {
+        if(other.io_) other.io_->flush();
+        for(auto j : range(PH_.size()))
+            {
+            if(other.spilled_.at(j)) readFromFile(other.PHFName(j),PH_.at(j));
+            }
+        io_.reset();
+        writedir_ = "./";
+        memoryBudget(other.spill_.manager(),
+                     {"WriteDir",other.spilldir_->location(),
+                      "AsyncIO",bool(other.io_)});
+        }
+    return *this;
+    }
+
+template <class Tensor> inline
+LocalMPO<Tensor>& LocalMPO<Tensor>::
+operator=(LocalMPO && other)
+    {
+    if(this == &other) return *this;
+    spill_ = std::move(other.spill_);
+    spilled_ = std::move(other.spilled_);
+    Op_ = other.Op_;
+    PH_ = std::move(other.PH_);
+    LHlim_ = other.LHlim_;
+    RHlim_ = other.RHlim_;
+    nc_ = other.nc_;
+    lop_ = std::move(other.lop_);
+    do_write_ = other.do_write_;
+    writedir_ = std::move(other.writedir_);
+    io_ = std::move(other.io_);
+    spilldir_ = std::move(other.spilldir_);
+    lastb_ = other.lastb_;
+    Psi_ = other.Psi_;
+    //The spiller still refers to other
+    spill_.rebind([this](int j) { return spillPH(j); });
+    return *this;
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+memoryBudget(std::shared_ptr<SpillManager> const& m,
+             Args const& args)
+    {
+    if(Psi_ != 0) Error("Memory budget not yet supported for LocalMPO initialized with an MPS");
+    if(do_write_) Error("Memory budget not supported if doWrite(true)");
+    if(!m)
+        {
+        if(!spill_) return;
+        for(auto j : range(PH_.size()))
+            {
+            if(spilled_.at(j)) readPH(j);
+            }
+        spill_.reset();
+        io_.reset();
+        spilldir_.reset();
+        writedir_ = "./";
+        spilled_.clear();
+        return;
+        }
+    if(!spill_)
+        {
+        spilldir_ = std::make_shared<TempDir>("PH",args.getString("WriteDir","./"));
+        writedir_ = spilldir_->name();
+        if(args.getBool("AsyncIO",true))
+            {
+            io_ = std::make_shared<AsyncFileStore<Tensor>>();
+            }
+        spilled_.assign(PH_.size(),false);
+        }
+    spill_ = SpillHandle(m,[this](int j) { return spillPH(j); });
+    for(auto j : range(PH_.size()))
+        {
+        if(PH_.at(j)) spill_.track(j,storageBytes(PH_.at(j)));
+        }
+    spill_.enforce();
+    }
+
+template <class Tensor>
+bool inline LocalMPO<Tensor>::
+spillPH(int j)
+    {
+    if(j == LHlim_ || j == RHlim_) return false;
+    if(j > LHlim_ && j < RHlim_)
+        {
+        //Out of date, no need to write
+        PH_.at(j) = Tensor();
+        return true;
+        }
+    writePH(j);
+    spilled_.at(j) = true;
+    return true;
+    }
+
+//Brings edge tensor j into memory
+//if spilled and tracks its size
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+loadPH(int j)
+    {
+    if(spilled_.at(j))
+        {
+        readPH(j);
+        spilled_.at(j) = false;
+        }
+    if(PH_.at(j)) spill_.track(j,storageBytes(PH_.at(j)));
+    spill_.enforce();
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+dropPH(int j)
+    {
+    PH_.at(j) = Tensor();
+    spilled_.at(j) = false;
+    spill_.untrack(j);
+    }
+
+template <class Tensor>
+std::vector<EdgeTensors<Tensor>> inline LocalMPO<Tensor>::
+saveEdges(std::string const& copydir) const
+    {
+    if(io_) io_->flush();
+    auto E = EdgeTensors<Tensor>();
+    E.LHlim = LHlim_;
+    E.RHlim = RHlim_;
+    E.PH.resize(PH_.size());
+    auto dir = std::string();
+    for(auto j : range(PH_.size()))
+        {
+        if(j > size_t(LHlim_) && j < size_t(RHlim_)) continue;
+        if(PH_.at(j)) 
+            {
+            E.PH.at(j) = PH_.at(j);
+            }
+        else
+        if(spill_ ? bool(spilled_.at(j)) : (do_write_ && fileExists(PHFName(j))))
+            {
+            if(copydir.empty())
+                {
+                readFromFile(PHFName(j),E.PH.at(j));
+                continue;
+                }
+            //Each LocalMPO copies into its own directory
+            if(dir.empty()) dir = mkTempDir("PH",copydir);
+            E.PHfile.resize(PH_.size());
+            E.PHfile.at(j) = format("%s/PH_%03d",dir,j);
+            copyFile(PHFName(j),E.PHfile.at(j));
+            }
+        }
+    return std::vector<EdgeTensors<Tensor>>(1,std::move(E));
+    }
+
+template <class Tensor>
+void inline LocalMPO<Tensor>::
+restoreEdges(std::vector<EdgeTensors<Tensor>> E)
+    {
+    if(do_write_ || spill_) Error("restoreEdges not supported if writing to disk");
+    if(E.size() != 1 || E.front().PH.size() != PH_.size())
+        {
+        Error("Edge tensors do not match size of LocalMPO");
+        }
+    auto& e = E.front();
+    PH_ = std::move(e.PH);
+    for(auto j : range(e.PHfile))
+        {
+        if(!e.PHfile[j].empty()) readFromFile(e.PHfile[j],PH_.at(j));
+        }
+    LHlim_ = e.LHlim;
+    RHlim_ = e.RHlim;
     }
 
 } //namespace itensor
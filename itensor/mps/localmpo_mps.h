@@ -80,6 +80,31 @@ class LocalMPO_MPS
     void
     doWrite(bool val, Args const& args = Args::global()) { lmpo_.doWrite(val,args); }
 
+    void
+    memoryBudget(std::shared_ptr<SpillManager> const& m,
+                 Args const& args = Args::global())
+        {
+        lmpo_.memoryBudget(m,args);
+        }
+
+    //Edges of the MPO first, then
+    //those of each MPS in psis
+    std::vector<EdgeTensors<Tensor>>
+    saveEdges(std::string const& copydir = "") const
+        {
+        auto E = lmpo_.saveEdges(copydir);
+        for(auto& M : lmps_) E.push_back(M.saveEdges(copydir).front());
+        return E;
+        }
+
+    void
+    restoreEdges(std::vector<EdgeTensors<Tensor>> E)
+        {
+        if(E.size() != 1+lmps_.size()) Error("Number of edge tensor sets does not match LocalMPO_MPS");
+        lmpo_.restoreEdges({std::move(E.front())});
+        for(auto n : range(lmps_)) lmps_[n].restoreEdges({std::move(E.at(1+n))});
+        }
+
     };
 
 template <class Tensor>
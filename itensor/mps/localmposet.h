@@ -5,6 +5,7 @@
 #ifndef __ITENSOR_LOCALMPOSET
 #define __ITENSOR_LOCALMPOSET
 #include "itensor/mps/localmpo.h"
+#include "itensor/util/threadpool.h"
 
 namespace itensor {
 
@@ -98,6 +99,28 @@ class LocalMPOSet
         for(auto& lm : lmpo_) lm.doWrite(val,args);
         }
 
+    void
+    memoryBudget(std::shared_ptr<SpillManager> const& m,
+                 Args const& args = Args::global())
+        {
+        for(auto& lm : lmpo_) lm.memoryBudget(m,args);
+        }
+
+    std::vector<EdgeTensors<Tensor>>
+    saveEdges(std::string const& copydir = "") const
+        {
+        auto E = std::vector<EdgeTensors<Tensor>>();
+        for(auto& lm : lmpo_) E.push_back(lm.saveEdges(copydir).front());
+        return E;
+        }
+
+    void
+    restoreEdges(std::vector<EdgeTensors<Tensor>> E)
+        {
+        if(E.size() != lmpo_.size()) Error("Number of edge tensor sets does not match LocalMPOSet");
+        for(auto n : range(lmpo_)) lmpo_[n].restoreEdges({std::move(E[n])});
+        }
+
     };
 
 template <class Tensor>
@@ -137,6 +160,20 @@ void inline LocalMPOSet<Tensor>::
 product(Tensor const& phi, 
         Tensor & phip) const
     {
+    auto nthread = getNThread();
+    if(nthread > 1 && lmpo_.size() > 1)
+        {
+        //Each product runs as a task of the shared pool;
+        //the sum is taken in order so the result does
+        //not depend on the number of threads
+        auto phis = std::vector<Tensor>(lmpo_.size());
+        parallelFor(lmpo_.size(),nthread,
+                    [this,&phi,&phis](size_t n) { lmpo_[n].product(phi,phis[n]); });
+        phip = std::move(phis.front());
+        for(auto n : range(1,phis.size())) phip += phis[n];
+        return;
+        }
+
     lmpo_.front().product(phi,phip);
 
     Tensor phi_n;
@@ -0,0 +1,289 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include "itensor/mps/localop.h"
+#include "itensor/tensor/contract.h"
+#include "itensor/util/multalloc.h"
+
+namespace itensor {
+
+namespace detail {
+
+//
+// Fixed contraction sequence phi*T1*T2*...
+// for dense tensors with given index sets.
+// Each step contracts the previous result X
+// with the next operand T into Y.
+//
+struct LocalProductPlan
+    {
+    struct Step
+        {
+        Range Trange,
+              Yrange;
+        std::shared_ptr<CProps> props;
+        };
+    IndexSet phis;
+    std::vector<IndexSet> opis;
+    Range phirange;
+    std::vector<Step> steps;
+    IndexSet Nis;
+    //Size of each of the two buffers
+    //holding intermediate results
+    size_t bufsize = 0;
+    };
+
+} //namespace detail
+
+using detail::LocalProductPlan;
+
+namespace {
+
+struct DenseData
+    {
+    Real const* r = nullptr;
+    Cplx const* z = nullptr;
+    };
+
+struct GetDenseData { };
+
+const char*
+typeNameOf(GetDenseData const&) { return "GetDenseData"; }
+
+DenseData
+doTask(GetDenseData, DenseReal const& d)
+    {
+    auto p = DenseData{};
+    p.r = d.data();
+    return p;
+    }
+
+DenseData
+doTask(GetDenseData, DenseCplx const& d)
+    {
+    auto p = DenseData{};
+    p.z = d.data();
+    return p;
+    }
+
+bool
+isDense(ITensor const& T)
+    {
+    if(!T.store()) return false;
+    auto type = doTask(StorageType{},T.store());
+    return type == StorageType::DenseReal || type == StorageType::DenseCplx;
+    }
+
+bool
+sameInds(IndexSet const& is1, IndexSet const& is2)
+    {
+    if(is1.r() != is2.r()) return false;
+    for(auto j : range(is1.r()))
+        {
+        if(is1[j] != is2[j]) return false;
+        }
+    return true;
+    }
+
+Range
+denseRange(IndexSet const& is)
+    {
+    auto RB = RangeBuilder(is.r());
+    for(auto& I : is) RB.nextIndex(I.m());
+    return RB.build();
+    }
+
+//Returns nullptr if some step would produce
+//a scalar, which the plan does not handle
+std::shared_ptr<LocalProductPlan>
+makeLocalProductPlan(IndexSet const& phis,
+                     std::vector<ITensor const*> const& ops)
+    {
+    auto plan = std::make_shared<LocalProductPlan>();
+    plan->phis = phis;
+    plan->phirange = denseRange(phis);
+    plan->steps.resize(ops.size());
+
+    auto Xis = phis;
+    for(auto k : range(ops))
+        {
+        auto& Tis = ops[k]->inds();
+        plan->opis.push_back(Tis);
+
+        Labels Xind,
+               Tind,
+               Yind;
+        IndexSet Yis;
+        computeLabels(Xis,Xis.r(),Tis,Tis.r(),Xind,Tind);
+        contractIS(Xis,Xind,Tis,Tind,Yis,Yind);
+        if(Yis.r() == 0) return nullptr;
+
+        auto& Xrange = (k == 0) ? plan->phirange : plan->steps[k-1].Yrange;
+        auto& s = plan->steps[k];
+        s.Trange = denseRange(Tis);
+        s.Yrange = denseRange(Yis);
+        s.props = computeCProps(Xrange,Xind,s.Trange,Tind,s.Yrange,Yind);
+        if(k+1 < ops.size()) plan->bufsize = std::max(plan->bufsize,size_t(area(Yis)));
+        Xis = std::move(Yis);
+        }
+    plan->Nis = std::move(Xis);
+    return plan;
+    }
+
+bool
+matches(LocalProductPlan const& plan,
+        IndexSet const& phis,
+        std::vector<ITensor const*> const& ops)
+    {
+    if(plan.opis.size() != ops.size()) return false;
+    if(!sameInds(plan.phis,phis)) return false;
+    for(auto k : range(ops))
+        {
+        if(!sameInds(plan.opis[k],ops[k]->inds())) return false;
+        }
+    return true;
+    }
+
+void
+contractStep(LocalProductPlan::Step const& s,
+             Range const& Xrange,
+             Real const* x,
+             DenseData t,
+             Real* y)
+    {
+    auto X = makeTenRef(x,area(Xrange),&Xrange);
+    auto T = makeTenRef(t.r,area(s.Trange),&s.Trange);
+    auto Y = makeTenRef(y,area(s.Yrange),&s.Yrange);
+    contract(*s.props,X,T,Y,1.,0.);
+    }
+
+void
+contractStep(LocalProductPlan::Step const& s,
+             Range const& Xrange,
+             Cplx const* x,
+             DenseData t,
+             Cplx* y)
+    {
+    auto X = makeTenRef(x,area(Xrange),&Xrange);
+    auto Y = makeTenRef(y,area(s.Yrange),&s.Yrange);
+    if(t.r)
+        {
+        auto T = makeTenRef(t.r,area(s.Trange),&s.Trange);
+        contract(*s.props,X,T,Y,1.,0.);
+        }
+    else
+        {
+        auto T = makeTenRef(t.z,area(s.Trange),&s.Trange);
+        contract(*s.props,X,T,Y,1.,0.);
+        }
+    }
+
+//Intermediate results alternate between two
+//buffers; the last step writes into out
+template<typename V>
+void
+runPlan(LocalProductPlan const& plan,
+        V const* phi,
+        std::vector<DenseData> const& ops,
+        V* out)
+    {
+    auto buf = ScratchBuf<V>(2*plan.bufsize);
+    V* Y[2] = {buf.data(),buf.data()+plan.bufsize};
+    auto* x = phi;
+    auto* Xrange = &plan.phirange;
+    for(auto k : range(plan.steps))
+        {
+        auto& s = plan.steps[k];
+        auto* y = (k+1 == plan.steps.size()) ? out : Y[k%2];
+        contractStep(s,*Xrange,x,ops[k],y);
+        x = y;
+        Xrange = &s.Yrange;
+        }
+    }
+
+} //namespace
+
+namespace detail {
+
+bool
+fusedProduct(ITensor const* L,
+             ITensor const& Op1,
+             ITensor const& Op2,
+             ITensor const* R,
+             ITensor const& phi,
+             ITensor & phip,
+             std::shared_ptr<const LocalProductPlan> & plan)
+    {
+#ifdef USESCALE
+    return false;
+#else
+    //Same order as the generic LocalOp::product
+    auto ops = std::vector<ITensor const*>{};
+    if(L)
+        {
+        ops = {L,&Op1,&Op2};
+        if(R) ops.push_back(R);
+        }
+    else
+        {
+        if(R) ops.push_back(R);
+        ops.push_back(&Op2);
+        ops.push_back(&Op1);
+        }
+
+    if(phi.r() == 0 || !isDense(phi)) return false;
+    for(auto* T : ops)
+        {
+        if(T->r() == 0 || !isDense(*T)) return false;
+        }
+
+    //Products may run concurrently (e.g. in blockDavidson),
+    //so the plan pointer is only read and replaced atomically
+    auto P = std::atomic_load(&plan);
+    if(!P || !matches(*P,phi.inds(),ops))
+        {
+        P = makeLocalProductPlan(phi.inds(),ops);
+        if(!P) return false;
+        std::atomic_store(&plan,P);
+        }
+
+    auto phid = doTask(GetDenseData{},phi.store());
+    auto opd = std::vector<DenseData>(ops.size());
+    auto iscplx = bool(phid.z);
+    for(auto k : range(ops))
+        {
+        opd[k] = doTask(GetDenseData{},ops[k]->store());
+        if(opd[k].z) iscplx = true;
+        }
+
+    auto size = area(P->Nis);
+    if(!iscplx)
+        {
+        auto out = std::vector<Real>(size);
+        runPlan(*P,phid.r,opd,out.data());
+        phip = ITensor(P->Nis,DenseReal(std::move(out)));
+        }
+    else
+        {
+        auto out = std::vector<Cplx>(size);
+        if(phid.z)
+            {
+            runPlan(*P,phid.z,opd,out.data());
+            }
+        else
+            {
+            auto phiz = ScratchBuf<Cplx>(area(P->phirange));
+            std::copy(phid.r,phid.r+phiz.size(),phiz.data());
+            runPlan<Cplx>(*P,phiz.data(),opd,out.data());
+            }
+        phip = ITensor(P->Nis,DenseCplx(std::move(out)));
+        }
+    phip.mapprime(1,0);
+    return true;
+#endif
+    }
+
+} //namespace detail
+
+} //namespace itensor
@@ -29,6 +29,40 @@ namespace itensor {
 //  they will not be used.)
 //
 
+namespace detail {
+
+struct LocalProductPlan;
+
+//Computes phip = L*Op1*Op2*R*phi (with primes
+//mapped back to 0) for dense ITensors using a
+//contraction plan computed on the first call and
+//reused while the index structure is unchanged.
+//Returns false, leaving phip unchanged, if the
+//tensors are not all dense.
+bool
+fusedProduct(ITensor const* L,
+             ITensor const& Op1,
+             ITensor const& Op2,
+             ITensor const* R,
+             ITensor const& phi,
+             ITensor & phip,
+             std::shared_ptr<const LocalProductPlan> & plan);
+
+//Block-sparse contractions already reuse
+//cached plans (see qdense.cc)
+bool inline
+fusedProduct(IQTensor const* L,
+             IQTensor const& Op1,
+             IQTensor const& Op2,
+             IQTensor const* R,
+             IQTensor const& phi,
+             IQTensor & phip,
+             std::shared_ptr<const LocalProductPlan> & plan)
+    {
+    return false;
+    }
+
+} //namespace detail
 
 template <class Tensor>
 class LocalOp
@@ -38,6 +72,7 @@ class LocalOp
     Tensor const* L_;
     Tensor const* R_;
     mutable long size_;
+    mutable std::shared_ptr<const detail::LocalProductPlan> plan_;
     public:
 
     using IndexT = typename Tensor::index_type;
@@ -180,6 +215,7 @@ update(const Tensor& Op1, const Tensor& Op2)
     L_ = nullptr;
     R_ = nullptr;
     size_ = -1;
+    plan_.reset();
     }
 
 template <class Tensor>
@@ -214,10 +250,15 @@ product(Tensor const& phi,
         Tensor      & phip) const
     {
     if(!(*this)) Error("LocalOp is null");
+    PROFILE_SCOPE("LocalOp::product")
 
     auto& Op1 = *Op1_;
     auto& Op2 = *Op2_;
 
+    auto* pL = LIsNull() ? nullptr : L_;
+    auto* pR = RIsNull() ? nullptr : R_;
+    if(detail::fusedProduct(pL,Op1,Op2,pR,phi,phip,plan_)) return;
+
     if(LIsNull())
         {
         phip = phi;
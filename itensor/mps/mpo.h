@@ -62,6 +62,8 @@ class MPOt : private MPSt<Tensor>
 
     using Parent::read;
     using Parent::write;
+    using Parent::writeTensorFile;
+    using Parent::readTensorFile;
 
     Real
     logRefNorm() const { return logrefNorm_; }
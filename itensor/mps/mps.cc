@@ -5,6 +5,8 @@
 #include <map>
 #include "itensor/mps/mps.h"
 #include "itensor/mps/localop.h"
+#include "itensor/tensorfile.h"
+#include "itensor/util/asyncfile.h"
 #include "itensor/util/print_macro.h"
 
 namespace itensor {
@@ -111,8 +113,17 @@ MPSt(MPSt const& other)
     sites_(other.sites_),
     atb_(other.atb_),
     writedir_(other.writedir_),
-    do_write_(other.do_write_)
+    do_write_(other.do_write_),
+    file_(other.file_),
+    unloaded_(other.unloaded_)
     { 
+    if(other.spill_)
+        {
+        //Copies hold all tensors in memory
+        other.loadAll();
+        A_ = other.A_;
+        }
+    if(other.io_) other.io_->flush();
     copyWriteDir();
     }
 template MPSt<ITensor>::
@@ -124,6 +135,9 @@ template <class Tensor>
 MPSt<Tensor>& MPSt<Tensor>::
 operator=(MPSt const& other)
     { 
+    if(this == &other) return *this;
+    if(spill_) cleanupSpill();
+    if(other.spill_) other.loadAll();
     N_ = other.N_;
     A_ = other.A_;
     l_orth_lim_ = other.l_orth_lim_;
@@ -132,7 +146,11 @@ operator=(MPSt const& other)
     atb_ = other.atb_;
     writedir_ = other.writedir_;
     do_write_ = other.do_write_;
+    file_ = other.file_;
+    unloaded_ = other.unloaded_;
 
+    if(other.io_) other.io_->flush();
+    io_.reset();
     copyWriteDir();
     return *this;
     }
@@ -146,6 +164,7 @@ MPSt<T>::
 ~MPSt()
     {
     cleanupWrite();
+    cleanupSpill();
     }
 template MPSt<ITensor>::~MPSt();
 template MPSt<IQTensor>::~MPSt();
@@ -186,10 +205,12 @@ doWrite(bool val, Args const& args)
 
     if(val == true)
         {
+        if(spill_) Error("doWrite not supported with a memory budget");
         initWrite(args); 
         }
     else
         {
+        if(io_) io_->flush();
         read(writedir_);
         cleanupWrite();
         }
@@ -204,6 +225,10 @@ template <class Tensor>
 void MPSt<Tensor>::
 read(std::istream & s)
     {
+    //Sites not loaded yet from a lazily read
+    //file would overwrite the ones read here
+    file_.reset();
+    unloaded_.clear();
     itensor::read(s,N_);
     A_.resize(N_+2);
     for(auto j : range(A_))
@@ -236,6 +261,7 @@ write(std::ostream& s) const
     {
     if(do_write_)
         Error("MPSt::write not yet supported if doWrite(true)");
+    loadAll();
 
     itensor::write(s,N());
     for(auto j : range(A_.size()))
@@ -254,6 +280,8 @@ template <class Tensor>
 void MPSt<Tensor>::
 read(std::string const& dirname)
     {
+    file_.reset();
+    unloaded_.clear();
     l_orth_lim_ = 0;
     r_orth_lim_ = N_+1;
 
@@ -294,6 +322,20 @@ template <class Tensor>
 void MPSt<Tensor>::
 setBond(int b) const
     {
+    loadSite(b);
+    loadSite(b+1);
+    if(spill_)
+        {
+        //Record sizes of tensors changed at the old
+        //bond; the new bond is most recently used
+        trackA(atb_);
+        trackA(atb_+1);
+        atb_ = b;
+        trackA(b);
+        trackA(b+1);
+        spill_.enforce();
+        return;
+        }
     if(b == atb_) return;
     if(!do_write_)
         {
@@ -307,47 +349,50 @@ setBond(int b) const
     //to requested value b, writing any non-Null tensors to
     //disk along the way
     //
+    auto next = 0;
     while(b > atb_)
         {
         if(A_.at(atb_))
             {
-            writeToFile(AFName(atb_),A_.at(atb_));
+            writeA(atb_);
             A_.at(atb_) = Tensor();
             }
         if(A_.at(atb_+1))
             {
-            writeToFile(AFName(atb_+1),A_.at(atb_+1));
+            writeA(atb_+1);
             if(atb_+1 != b) A_.at(atb_+1) = Tensor();
             }
         ++atb_;
+        next = b+2;
         }
     while(b < atb_)
         {
         if(A_.at(atb_))
             {
-            writeToFile(AFName(atb_),A_.at(atb_));
+            writeA(atb_);
             if(atb_ != b+1) A_.at(atb_) = Tensor();
             }
         if(A_.at(atb_+1))
             {
-            writeToFile(AFName(atb_+1),A_.at(atb_+1));
+            writeA(atb_+1);
             A_.at(atb_+1) = Tensor();
             }
         --atb_;
+        next = b-1;
         }
     assert(atb_ == b);
     //
     //Load tensors at bond b into RAM if
     //they aren't loaded already
     //
-    if(!A_.at(b))
-        {
-        readFromFile(AFName(b),A_.at(b));
-        }
+    if(!A_.at(b)) readA(b);
+    if(!A_.at(b+1)) readA(b+1);
 
-    if(!A_.at(b+1))
+    //Start loading the site needed next
+    //if moving on in the same direction
+    if(io_ && next >= 1 && next <= N_ && !A_.at(next))
         {
-        readFromFile(AFName(b+1),A_.at(b+1));
+        io_->prefetch(AFName(next));
         }
 
     //if(b == 1)
@@ -365,10 +410,111 @@ void MPSt<ITensor>::setBond(int b) const;
 template
 void MPSt<IQTensor>::setBond(int b) const;
 
+template <class Tensor>
+void MPSt<Tensor>::
+writeA(int j) const
+    {
+    PROFILE_SCOPE_BYTES("MPS::writeA",storageBytes(A_.at(j)))
+    if(io_) io_->write(AFName(j),A_.at(j));
+    else    writeToFile(AFName(j),A_.at(j));
+    }
+template
+void MPSt<ITensor>::writeA(int j) const;
+template
+void MPSt<IQTensor>::writeA(int j) const;
+
+template <class Tensor>
+void MPSt<Tensor>::
+readA(int j) const
+    {
+    PROFILE_SCOPE("MPS::readA")
+    if(io_) A_.at(j) = io_->read(AFName(j));
+    else    readFromFile(AFName(j),A_.at(j));
+    }
+template
+void MPSt<ITensor>::readA(int j) const;
+template
+void MPSt<IQTensor>::readA(int j) const;
+
+template <class Tensor>
+void MPSt<Tensor>::
+trackA(int j) const
+    {
+    if(!spill_ || j < 1 || j > N_ || !A_.at(j)) return;
+    spill_.track(j,storageBytes(A_.at(j)));
+    }
+template
+void MPSt<ITensor>::trackA(int j) const;
+template
+void MPSt<IQTensor>::trackA(int j) const;
+
+template <class Tensor>
+bool MPSt<Tensor>::
+spillA(int j) const
+    {
+    if(j == atb_ || j == atb_+1) return false;
+    writeA(j);
+    A_.at(j) = Tensor();
+    spilled_.at(j) = true;
+    return true;
+    }
+template
+bool MPSt<ITensor>::spillA(int j) const;
+template
+bool MPSt<IQTensor>::spillA(int j) const;
+
+template <class Tensor>
+void MPSt<Tensor>::
+memoryBudget(std::shared_ptr<SpillManager> const& m,
+             Args const& args)
+    {
+    if(do_write_) Error("Memory budget not supported if doWrite(true)");
+    if(!m)
+        {
+        if(!spill_) return;
+        loadAll();
+        cleanupSpill();
+        return;
+        }
+    if(!spill_)
+        {
+        writedir_ = mkTempDir("psi",args.getString("WriteDir","./"));
+        if(args.getBool("AsyncIO",true))
+            {
+            io_ = std::make_shared<AsyncFileStore<Tensor>>();
+            }
+        spilled_.assign(A_.size(),false);
+        }
+    spill_ = SpillHandle(m,[this](int j) { return spillA(j); });
+    for(auto j : range1(N_)) trackA(j);
+    spill_.enforce();
+    }
+template
+void MPSt<ITensor>::memoryBudget(std::shared_ptr<SpillManager> const& m, Args const& args);
+template
+void MPSt<IQTensor>::memoryBudget(std::shared_ptr<SpillManager> const& m, Args const& args);
+
+template <class Tensor>
+void MPSt<Tensor>::
+cleanupSpill()
+    {
+    if(!spill_) return;
+    spill_.reset();
+    io_.reset();
+    removeTree(writedir_);
+    writedir_ = "./";
+    spilled_.clear();
+    }
+template
+void MPSt<ITensor>::cleanupSpill();
+template
+void MPSt<IQTensor>::cleanupSpill();
+
 template <class Tensor>
 void MPSt<Tensor>::
 setSite(int j) const
     {
+    loadSite(j);
     if(!do_write_)
         {
         atb_ = (j > atb_ ? j-1 : j);
@@ -398,6 +544,176 @@ void MPSt<ITensor>::setSite(int j) const;
 template
 void MPSt<IQTensor>::setSite(int j) const;
 
+template <class Tensor>
+void MPSt<Tensor>::
+loadSite(int j) const
+    {
+    if(spill_ && j >= 0 && j < int(spilled_.size()) && spilled_[j])
+        {
+        readA(j);
+        spilled_[j] = false;
+        trackA(j);
+        return;
+        }
+    if(!file_ || j < 0 || j >= int(unloaded_.size()) || !unloaded_[j]) return;
+    A_.at(j) = file_->read<Tensor>(format("A_%03d",j));
+    unloaded_[j] = false;
+    trackA(j);
+    if(std::none_of(unloaded_.begin(),unloaded_.end(),[](bool u) { return u; }))
+        {
+        file_.reset();
+        unloaded_.clear();
+        }
+    }
+template
+void MPSt<ITensor>::loadSite(int j) const;
+template
+void MPSt<IQTensor>::loadSite(int j) const;
+
+template <class Tensor>
+void MPSt<Tensor>::
+loadAll() const
+    {
+    for(auto j : range(A_.size())) loadSite(j);
+    }
+template
+void MPSt<ITensor>::loadAll() const;
+template
+void MPSt<IQTensor>::loadAll() const;
+
+template <class Tensor>
+void MPSt<Tensor>::
+writeTensorFile(std::string const& fname) const
+    {
+    //Write to a temporary file first: sites not loaded
+    //yet may be read from fname itself
+    auto tmpname = fname + ".tmp";
+    TensorFileWriter w(tmpname);
+    try
+        {
+        writeTensorFile(w);
+        w.close();
+        }
+    catch(...)
+        {
+        w.discard();
+        throw;
+        }
+    if(std::rename(tmpname.c_str(),fname.c_str()) != 0)
+        {
+        throw ITError("Couldn't rename \"" + tmpname + "\" to \"" + fname + "\"");
+        }
+    }
+template
+void MPSt<ITensor>::writeTensorFile(std::string const& fname) const;
+template
+void MPSt<IQTensor>::writeTensorFile(std::string const& fname) const;
+
+template <class Tensor>
+void MPSt<Tensor>::
+writeTensorFile(TensorFileWriter & w) const
+    {
+    for(auto j : range(A_.size()))
+        {
+        w.write(format("A_%03d",j),A(j));
+        }
+    w.write("leftLim",ITensor(l_orth_lim_));
+    w.write("rightLim",ITensor(r_orth_lim_));
+    }
+template
+void MPSt<ITensor>::writeTensorFile(TensorFileWriter & w) const;
+template
+void MPSt<IQTensor>::writeTensorFile(TensorFileWriter & w) const;
+
+template <class Tensor>
+MPSTensors<Tensor> MPSt<Tensor>::
+saveTensors(std::string const& copydir) const
+    {
+    if(io_) io_->flush();
+    auto S = MPSTensors<Tensor>();
+    S.A.resize(A_.size());
+    S.Afile.resize(A_.size());
+    S.leftLim = l_orth_lim_;
+    S.rightLim = r_orth_lim_;
+    for(auto j : range(A_.size()))
+        {
+        auto copyname = format("%s/A_%03d",copydir,j);
+        if(A_.at(j))
+            {
+            S.A.at(j) = A_.at(j);
+            }
+        else
+        if(spill_ ? bool(spilled_.at(j)) : (do_write_ && fileExists(AFName(j))))
+            {
+            copyFile(AFName(j),copyname);
+            S.Afile.at(j) = copyname;
+            }
+        else
+        if(file_ && unloaded_.at(j))
+            {
+            writeToFile(copyname,file_->read<Tensor>(format("A_%03d",j)));
+            S.Afile.at(j) = copyname;
+            }
+        }
+    return S;
+    }
+template
+MPSTensors<ITensor> MPSt<ITensor>::saveTensors(std::string const& copydir) const;
+template
+MPSTensors<IQTensor> MPSt<IQTensor>::saveTensors(std::string const& copydir) const;
+
+template <class Tensor>
+void MPSTensors<Tensor>::
+writeTensorFile(TensorFileWriter & w) const
+    {
+    for(auto j : range(A))
+        {
+        auto name = format("A_%03d",j);
+        if(!Afile.at(j).empty()) w.write(name,readFromFile<Tensor>(Afile.at(j)));
+        else                     w.write(name,A.at(j));
+        }
+    w.write("leftLim",ITensor(leftLim));
+    w.write("rightLim",ITensor(rightLim));
+    }
+template
+void MPSTensors<ITensor>::writeTensorFile(TensorFileWriter & w) const;
+template
+void MPSTensors<IQTensor>::writeTensorFile(TensorFileWriter & w) const;
+
+template <class Tensor>
+void MPSt<Tensor>::
+readTensorFile(std::string const& fname,
+               Args const& args)
+    {
+    if(do_write_) Error("readTensorFile not supported if doWrite(true)");
+
+    auto file = std::make_shared<TensorFile const>(fname);
+    auto N = 0;
+    while(file->has(format("A_%03d",N+2))) ++N;
+    if(N == 0 || !file->has("A_000"))
+        {
+        throw ITError(format("File \"%s\" does not hold an MPS or MPO",fname));
+        }
+    if(sites_ && sites_.N() != N)
+        {
+        Error(format("File \"%s\" has %d sites, expected %d",fname,N,sites_.N()));
+        }
+
+    N_ = N;
+    A_.assign(N_+2,Tensor());
+    atb_ = 1;
+    l_orth_lim_ = int(file->read<ITensor>("leftLim").real());
+    r_orth_lim_ = int(file->read<ITensor>("rightLim").real());
+    file_ = std::move(file);
+    unloaded_.assign(A_.size(),true);
+
+    if(!args.getBool("Lazy",true)) loadAll();
+    }
+template
+void MPSt<ITensor>::readTensorFile(std::string const& fname, Args const& args);
+template
+void MPSt<IQTensor>::readTensorFile(std::string const& fname, Args const& args);
+
 
 template <class Tensor>
 void MPSt<Tensor>::
@@ -614,6 +930,7 @@ mapprime(int oldp, int newp, IndexType type)
     { 
     if(do_write_)
         Error("mapprime not supported if doWrite(true)");
+    loadAll();
     for(int i = 1; i <= N_; ++i) 
         A_[i].mapprime(oldp,newp,type); 
     }
@@ -628,6 +945,7 @@ primelinks(int oldp, int newp)
     { 
     if(do_write_)
         Error("primelinks not supported if doWrite(true)");
+    loadAll();
     for(int i = 1; i <= N_; ++i) 
         A_[i].mapprime(oldp,newp,Link); 
     }
@@ -642,6 +960,7 @@ noprimelink()
     { 
     if(do_write_)
         Error("noprimelink not supported if doWrite(true)");
+    loadAll();
     for(int i = 1; i <= N_; ++i) 
         A_[i].noprime(Link); 
     }
@@ -678,6 +997,23 @@ struct Sqrt
     operator()(Real val) const { return std::sqrt(std::fabs(val)); }
     };
 
+namespace {
+//Whether svd would truncate given these args
+bool
+truncates(Args const& args)
+    {
+    if(args.defined("Truncate")) return args.getBool("Truncate");
+    return args.defined("Cutoff") 
+        || args.defined("Maxm")
+        || args.getBool("UseOrigM",false);
+    }
+} //namespace
+
+//Moves the orthogonality center from A1 to A2 (dir==Fromleft)
+//or from A2 to A1 (dir==Fromright). Uses the QR decomposition,
+//keeping the name of the bond index, unless the args ask for
+//truncation or "UseQR" is false; the returned Spectrum is
+//only computed in the latter (SVD) case.
 template<class Tensor>
 Spectrum
 orthMPS(Tensor& A1, Tensor& A2, Direction dir, const Args& args)
@@ -693,6 +1029,15 @@ orthMPS(Tensor& A1, Tensor& A2, Direction dir, const Args& args)
         Print(L.inds());
         }
 
+    if(args.getBool("UseQR",true) && not truncates(args))
+        {
+        Tensor Q,F(bnd);
+        qr(L,Q,F,{"IndexName",bnd.rawname(),"IndexType",Link});
+        L = Q;
+        R *= F;
+        return Spectrum();
+        }
+
     Tensor A,B(bnd);
     Tensor D;
     auto spec = svd(L,A,D,B,args);
@@ -773,6 +1118,17 @@ void MPSt<Tensor>::
 orthogonalize(Args const& args)
     {
     if(doWrite()) Error("Cannot call orthogonalize when doWrite()==true");
+    loadAll();
+
+    if(not args.getBool("Truncate",true))
+        {
+        //Only restore the gauge: a sweep of
+        //QR decompositions from the right
+        l_orth_lim_ = 0;
+        r_orth_lim_ = N_+1;
+        position(1,{"Truncate",false});
+        return;
+        }
 
     auto cutoff = args.getReal("Cutoff",1E-13);
     auto dargs = Args{"Cutoff",cutoff};
@@ -970,6 +1326,7 @@ template <class Tensor>
 bool MPSt<Tensor>::
 isComplex() const
     { 
+    loadAll();
     for(auto j : range1(N_))
         {
         if(itensor::isComplex(A_[j])) return true;
@@ -987,6 +1344,9 @@ initWrite(const Args& args)
     {
     if(!do_write_)
         {
+        //Null tensors below must mean "on disk"
+        loadAll();
+
         std::string write_dir_parent = args.getString("WriteDir","./");
         writedir_ = mkTempDir("psi",write_dir_parent);
 
@@ -1012,6 +1372,10 @@ initWrite(const Args& args)
 
         writeToFile(writedir_+"/sites",sites_);
 
+        if(args.getBool("AsyncIO",true))
+            {
+            io_ = std::make_shared<AsyncFileStore<T>>();
+            }
         do_write_ = true;
         }
     }
@@ -1033,6 +1397,10 @@ copyWriteDir()
         string cmdstr = "cp -r " + old_writedir + "/* " + writedir_;
         println("Copying MPS with doWrite()==true. Issuing command: ",cmdstr);
         system(cmdstr.c_str());
+        if(Global::args().getBool("AsyncIO",true))
+            {
+            io_ = std::make_shared<AsyncFileStore<T>>();
+            }
         }
     }
 template
@@ -1047,6 +1415,8 @@ cleanupWrite()
     {
     if(do_write_)
         {
+        //Finish pending writes before removing the files
+        io_.reset();
         const string cmdstr = "rm -fr " + writedir_;
         system(cmdstr.c_str());
         do_write_ = false;
@@ -1063,6 +1433,8 @@ swap(MPSt<T>& other)
     {
     if(N_ != other.N_)
         Error("Require same system size to swap MPS");
+    if(spill_ || other.spill_)
+        Error("swap not supported with a memory budget");
     A_.swap(other.A_);
     std::swap(l_orth_lim_,other.l_orth_lim_);
     std::swap(r_orth_lim_,other.r_orth_lim_);
@@ -1070,6 +1442,9 @@ swap(MPSt<T>& other)
     std::swap(atb_,other.atb_);
     std::swap(writedir_,other.writedir_);
     std::swap(do_write_,other.do_write_);
+    std::swap(file_,other.file_);
+    std::swap(unloaded_,other.unloaded_);
+    std::swap(io_,other.io_);
     }
 template
 void MPSt<ITensor>::swap(MPSt<ITensor>& other);
@@ -6,6 +6,7 @@
 #define __ITENSOR_MPS_H
 #include "itensor/decomp.h"
 #include "itensor/mps/siteset.h"
+#include "itensor/mps/spillmanager.h"
 
 namespace itensor {
 
@@ -14,6 +15,33 @@ class MPOt;
 
 class InitState;
 
+class TensorFile;
+class TensorFileWriter;
+
+template<class T>
+class AsyncFileStore;
+
+//
+// Site tensors of an MPS taken by MPSt::saveTensors
+// to be written out later, possibly on another thread.
+// A[j] is null if Afile[j] names a file (written by
+// writeToFile) holding the tensor instead.
+//
+template<class Tensor>
+struct MPSTensors
+    {
+    std::vector<Tensor> A;
+    std::vector<std::string> Afile;
+    int leftLim = 0,
+        rightLim = 0;
+
+    //Adds the tensors to w in the format of
+    //MPSt::writeTensorFile, reading each tensor
+    //held in a file only while writing it
+    void
+    writeTensorFile(TensorFileWriter & w) const;
+    };
+
 //
 // class MPSt
 // (the lowercase t stands for "template")
@@ -47,6 +75,20 @@ class MPSt
     int atb_;
     std::string writedir_;
     bool do_write_;
+    //Background I/O used if doWrite(true)
+    mutable
+    std::shared_ptr<AsyncFileStore<Tensor>> io_;
+    //Used by memoryBudget
+    mutable
+    SpillHandle spill_;
+    mutable
+    std::vector<bool> spilled_;
+    //Set by readTensorFile with {"Lazy",true}:
+    //file holding the sites not loaded yet
+    mutable
+    std::shared_ptr<TensorFile const> file_;
+    mutable
+    std::vector<bool> unloaded_;
     public:
     using TensorT = Tensor;
     using IndexT = typename Tensor::index_type;
@@ -136,9 +178,16 @@ class MPSt
 
     //Move the orthogonality center to site i 
     //(leftLim() == i-1, rightLim() == i+1, orthoCenter() == i)
+    //Unless args request truncation ("Cutoff", "Maxm" or
+    //"Truncate") this uses QR decompositions, which are
+    //much cheaper than SVDs; set "UseQR" to false to use SVDs.
     void 
     position(int i, Args const& args = Args::global());
 
+    //Brings the MPS into right-orthogonal form with the
+    //orthogonality center at site 1, truncating to
+    //"Cutoff" (default 1E-13) and "Maxm". With
+    //{"Truncate",false} only does a sweep of QR decompositions.
     void 
     orthogonalize(Args const& args = Args::global());
 
@@ -154,6 +203,15 @@ class MPSt
     std::string const&
     writeDir() const { return writedir_; }
 
+    //Keep site tensors in memory but spill least recently
+    //used ones to the "WriteDir" directory when tensors
+    //tracked by m exceed its budget. The tensors of the
+    //current bond are never spilled. Passing nullptr
+    //loads all tensors back.
+    void
+    memoryBudget(std::shared_ptr<SpillManager> const& m,
+                 Args const& args = Args::global());
+
     //Read from a directory containing individual tensors,
     //as created when doWrite(true) is called.
     void 
@@ -165,6 +223,29 @@ class MPSt
     void 
     write(std::ostream& s) const;
 
+    //Write all tensors to a single file in the
+    //TensorFile format (see itensor/tensorfile.h)
+    void
+    writeTensorFile(std::string const& fname) const;
+
+    //Add the tensors to a TensorFile being written
+    void
+    writeTensorFile(TensorFileWriter & w) const;
+
+    //Copies of the site tensors (sharing storage) for
+    //writing out later. Tensors on disk, such as those
+    //spilled under a memory budget, are not loaded:
+    //their files are copied into the directory copydir.
+    MPSTensors<Tensor>
+    saveTensors(std::string const& copydir) const;
+
+    //Read tensors written by writeTensorFile.
+    //If "Lazy" is true (default) each site tensor
+    //is only loaded from the file when first used.
+    void
+    readTensorFile(std::string const& fname,
+                   Args const& args = Args::global());
+
     protected:
 
     //
@@ -181,9 +262,26 @@ class MPSt
     void
     setSite(int j) const;
 
+    //Loads site j if still in file_
+    void
+    loadSite(int j) const;
+
+    void
+    loadAll() const;
+
     void
     initWrite(const Args& args = Args::global());
     void
+    writeA(int j) const;
+    void
+    readA(int j) const;
+    void
+    trackA(int j) const;
+    bool
+    spillA(int j) const;
+    void
+    cleanupSpill();
+    void
     copyWriteDir();
     void
     cleanupWrite();
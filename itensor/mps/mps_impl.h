@@ -22,6 +22,7 @@ Spectrum MPSt<Tensor>::
 svdBond(int b, const Tensor& AA, Direction dir, 
         const BigMatrixT& PH, const Args& args)
     {
+    PROFILE_SCOPE_BYTES("svdBond",storageBytes(AA))
     setBond(b);
     if(dir == Fromleft && b-1 > leftLim())
         {
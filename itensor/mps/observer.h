@@ -5,6 +5,7 @@
 #ifndef __ITENSOR_OBSERVER_H
 #define __ITENSOR_OBSERVER_H
 
+#include <iosfwd>
 #include "itensor/global.h"
 
 namespace itensor {
@@ -21,6 +22,14 @@ class Observer
     bool virtual
     checkDone(const Args& args = Global::args()) { return false; }
 
+    //Save and restore any state accumulated during
+    //a calculation, e.g. for DMRG checkpoints
+    void virtual
+    writeState(std::ostream& s) const { }
+
+    void virtual
+    readState(std::istream& s) { }
+
     virtual ~Observer() { }
 
     };
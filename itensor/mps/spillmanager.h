@@ -0,0 +1,266 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_SPILLMANAGER_H
+#define __ITENSOR_SPILLMANAGER_H
+
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include "itensor/iqtensor.h"
+
+namespace itensor {
+
+//
+// Keeps the tensors of several owners (e.g. the
+// edge tensors of a LocalMPO and the site tensors of
+// an MPS) within a memory budget.
+//
+// Owners track each tensor held in memory, with its
+// size; tracking again marks it most recently used.
+// enforce() asks the owners to spill least recently
+// used tensors to disk until the tracked bytes fit
+// in the budget. An owner can refuse to spill a
+// tensor it currently needs.
+//
+// Not thread safe: use from a single thread.
+//
+class SpillManager
+    {
+    public:
+    //Must move tensor j out of memory and return
+    //true, or return false if j is in use
+    using Spiller = std::function<bool(int)>;
+    private:
+    struct Item
+        {
+        int client;
+        int j;
+        size_t bytes;
+        };
+    using Key = std::pair<int,int>;
+    size_t max_bytes_ = 0,
+           live_bytes_ = 0,
+           peak_bytes_ = 0,
+           spilled_bytes_ = 0;
+    long nspill_ = 0;
+    int next_client_ = 0;
+    std::map<int,Spiller> clients_;
+    std::list<Item> lru_; //most recently used first
+    std::map<Key,std::list<Item>::iterator> items_;
+    public:
+
+    explicit
+    SpillManager(size_t max_bytes) : max_bytes_(max_bytes) { }
+
+    SpillManager(SpillManager const&) = delete;
+    SpillManager& operator=(SpillManager const&) = delete;
+
+    size_t
+    maxBytes() const { return max_bytes_; }
+
+    //Bytes of all tracked tensors
+    size_t
+    liveBytes() const { return live_bytes_; }
+
+    size_t
+    peakBytes() const { return peak_bytes_; }
+
+    //Total bytes spilled to disk so far
+    size_t
+    spilledBytes() const { return spilled_bytes_; }
+
+    long
+    numSpilled() const { return nspill_; }
+
+    int
+    addClient(Spiller f)
+        {
+        auto c = next_client_++;
+        clients_[c] = std::move(f);
+        return c;
+        }
+
+    //Replaces the spiller of client c
+    void
+    setSpiller(int c, Spiller f) { clients_.at(c) = std::move(f); }
+
+    void
+    removeClient(int c)
+        {
+        for(auto it = lru_.begin(); it != lru_.end();)
+            {
+            if(it->client == c) it = erase(it);
+            else                ++it;
+            }
+        clients_.erase(c);
+        }
+
+    void
+    track(int c, int j, size_t bytes)
+        {
+        untrack(c,j);
+        lru_.push_front(Item{c,j,bytes});
+        items_[Key(c,j)] = lru_.begin();
+        live_bytes_ += bytes;
+        peak_bytes_ = std::max(peak_bytes_,live_bytes_);
+        }
+
+    void
+    untrack(int c, int j)
+        {
+        auto it = items_.find(Key(c,j));
+        if(it != items_.end()) erase(it->second);
+        }
+
+    void
+    enforce()
+        {
+        auto it = lru_.end();
+        while(live_bytes_ > max_bytes_ && it != lru_.begin())
+            {
+            --it;
+            auto item = *it;
+            if(clients_.at(item.client)(item.j))
+                {
+                it = erase(it);
+                spilled_bytes_ += item.bytes;
+                ++nspill_;
+                }
+            }
+        }
+
+    private:
+
+    std::list<Item>::iterator
+    erase(std::list<Item>::iterator it)
+        {
+        live_bytes_ -= it->bytes;
+        items_.erase(Key(it->client,it->j));
+        return lru_.erase(it);
+        }
+    };
+
+//
+// Registration of one owner with a SpillManager,
+// unregistering it when destroyed. Copies are
+// not registered; moves transfer the registration,
+// after which the owner must rebind its spiller.
+//
+class SpillHandle
+    {
+    std::shared_ptr<SpillManager> m_;
+    int c_ = -1;
+    public:
+
+    SpillHandle() { }
+
+    SpillHandle(std::shared_ptr<SpillManager> const& m,
+                SpillManager::Spiller f)
+      : m_(m)
+        {
+        if(m_) c_ = m_->addClient(std::move(f));
+        }
+
+    SpillHandle(SpillHandle const&) { }
+
+    SpillHandle(SpillHandle && other)
+        {
+        std::swap(m_,other.m_);
+        std::swap(c_,other.c_);
+        }
+
+    SpillHandle&
+    operator=(SpillHandle const&) { reset(); return *this; }
+
+    SpillHandle&
+    operator=(SpillHandle && other)
+        {
+        reset();
+        std::swap(m_,other.m_);
+        std::swap(c_,other.c_);
+        return *this;
+        }
+
+    ~SpillHandle() { reset(); }
+
+    explicit operator bool() const { return bool(m_); }
+
+    std::shared_ptr<SpillManager> const&
+    manager() const { return m_; }
+
+    void
+    rebind(SpillManager::Spiller f) const { if(m_) m_->setSpiller(c_,std::move(f)); }
+
+    void
+    track(int j, size_t bytes) const { if(m_) m_->track(c_,j,bytes); }
+
+    void
+    untrack(int j) const { if(m_) m_->untrack(c_,j); }
+
+    void
+    enforce() const { if(m_) m_->enforce(); }
+
+    void
+    reset()
+        {
+        if(m_) m_->removeClient(c_);
+        m_.reset();
+        c_ = -1;
+        }
+    };
+
+struct StorageBytes { };
+
+inline const char*
+typeNameOf(StorageBytes const&) { return "StorageBytes"; }
+
+template<typename V>
+size_t
+vecBytes(std::vector<V> const& v) { return v.size()*sizeof(V); }
+
+template<typename T>
+size_t
+doTask(StorageBytes, Dense<T> const& d) { return vecBytes(d.store); }
+
+template<typename T>
+size_t
+doTask(StorageBytes, Diag<T> const& d) { return vecBytes(d.store); }
+
+template<typename T>
+size_t
+doTask(StorageBytes, QDense<T> const& d) { return vecBytes(d.store)+vecBytes(d.offsets); }
+
+template<typename T>
+size_t
+doTask(StorageBytes, QDiag<T> const& d) { return vecBytes(d.store); }
+
+template<typename T>
+size_t
+doTask(StorageBytes, QMixed<T> const& d) { return vecBytes(d.store); }
+
+template<typename T>
+size_t
+doTask(StorageBytes, Scalar<T> const& d) { return sizeof(T); }
+
+inline size_t
+doTask(StorageBytes, Combiner const& d) { return 0; }
+
+inline size_t
+doTask(StorageBytes, QCombiner const& d) { return 0; }
+
+//Approximate memory held by the
+//storage of T (0 if T is null)
+template<typename IndexT>
+size_t
+storageBytes(ITensorT<IndexT> const& T)
+    {
+    if(!T.store()) return 0;
+    return doTask(StorageBytes{},T.store());
+    }
+
+} //namespace itensor
+
+#endif
@@ -18,6 +18,13 @@ namespace itensor {
 //
 // Arguments recognized:
 //    "Verbose": if true, print useful information to stdout
+//    "EventTraceFile": record a timeline of each gate (see
+//                      util/eventtrace.h; the time step is
+//                      recorded as the sweep) to this file
+//    "EventTraceSize", "EventTraceDepth": see dmrg.h
+//    "CountOps": count the flops and bytes of gemms, permutations
+//                and decompositions (see util/opcount.h); the
+//                observer prints their rates after each time step
 //
 template <class Iterable, class Tensor>
 Real
@@ -64,6 +71,12 @@ gateTEvol(Iterable const& gatelist,
         printfln("Taking %d steps of timestep %.5f, total time %.5f",nt,tstep,ttotal);
         }
 
+    EventTraceSession trace(args.getString("EventTraceFile",""),
+                            args.getInt("EventTraceSize",EventTracer::default_capacity),
+                            args.getInt("EventTraceDepth",-1));
+
+    OpCountSession count_ops(args.getBool("CountOps",false));
+
     psi.position(gatelist.front().i1());
     Real tot_norm = norm(psi);
 
@@ -75,6 +88,8 @@ gateTEvol(Iterable const& gatelist,
             {
             auto i1 = g->i1();
             auto i2 = g->i2();
+            eventTracer().setPosition(tt,i1);
+            PROFILE_SCOPE_BYTES("gateTEvol gate",storageBytes(psi.A(i1))+storageBytes(psi.A(i2)))
             auto AA = psi.A(i1)*psi.A(i2)*g->gate();
             AA.mapprime(1,0,Site);
 
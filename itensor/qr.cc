@@ -0,0 +1,129 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include "itensor/util/stdx.h"
+#include "itensor/tensor/algs.h"
+#include "itensor/decomp.h"
+#include "itensor/util/print_macro.h"
+#include "itensor/itdata/qutil.h"
+
+namespace itensor {
+
+using std::vector;
+using std::move;
+
+template<typename T>
+void
+qrImpl(ITensor const& A,
+       Index const& qi,
+       Index const& ri,
+       ITensor & Q,
+       ITensor & R,
+       Args const& args)
+    {
+    auto name = args.getString("IndexName","qr");
+    auto itype = getIndexType(args,"IndexType",Link);
+
+    auto M = toMatRefc<T>(A,qi,ri);
+
+    Mat<T> QQ,RR;
+    QR(M,QQ,RR);
+
+    auto k = Index(name,ncols(QQ),itype);
+    Q = ITensor({qi,k},Dense<T>(move(QQ.storage())));
+    R = ITensor({k,ri},Dense<T>(move(RR.storage())),A.scale());
+    }
+
+template<typename T>
+void
+qrImpl(IQTensor const& A,
+       IQIndex const& qI,
+       IQIndex const& rI,
+       IQTensor & Q,
+       IQTensor & R,
+       Args const& args)
+    {
+    auto name = args.getString("IndexName","qr");
+    auto itype = getIndexType(args,"IndexType",Link);
+
+    auto blocks = doTask(GetBlocks<T>{A.inds(),qI,rI},A.store());
+
+    auto Nblock = blocks.size();
+    if(Nblock == 0) throw ResultIsZero("IQTensor has no blocks");
+
+    //The new index has one sector per block,
+    //carrying the QN of the block's row sector
+    auto Liq = IQIndex::storage{};
+    Liq.reserve(Nblock);
+    for(auto& B : blocks)
+        {
+        auto k = std::min(nrows(B.M),ncols(B.M));
+        Liq.emplace_back(Index("l",k,itype),qI.qn(1+B.i1));
+        }
+    auto L = IQIndex(name,move(Liq),qI.dir());
+
+    auto Qis = IQIndexSet(qI,dag(L));
+    auto Ris = IQIndexSet(L,rI);
+
+    auto Qstore = QDense<T>(Qis,QN());
+    auto Rstore = QDense<T>(Ris,div(A));
+
+    //Factorize each block directly into
+    //its blocks of Q and R, in parallel
+    auto Qmats = vector<MatRef<T>>(Nblock);
+    auto Rmats = vector<MatRef<T>>(Nblock);
+    for(auto b : range(Nblock))
+        {
+        auto& B = blocks[b];
+        auto k = L[b].m();
+
+        auto pQ = getBlock(Qstore,Qis,stdx::make_array(B.i1,long(b)));
+        assert(pQ.data() != nullptr);
+        Qmats[b] = makeMatRef(pQ.data(),pQ.size(),qI[B.i1].m(),k);
+
+        auto pR = getBlock(Rstore,Ris,stdx::make_array(long(b),B.i2));
+        assert(pR.data() != nullptr);
+        Rmats[b] = makeMatRef(pR.data(),pR.size(),k,rI[B.i2].m());
+        }
+
+    auto order = blocksByCost(blocks);
+    parallelFor(Nblock,getNThread(args),
+                [&](size_t j)
+                    {
+                    auto b = order[j];
+                    QRRef(blocks[b].M,Qmats[b],Rmats[b]);
+                    });
+
+    Q = IQTensor(Qis,move(Qstore));
+    R = IQTensor(Ris,move(Rstore),A.scale());
+    }
+
+template<typename IndexT>
+void
+qrRank2(ITensorT<IndexT> const& A,
+        IndexT const& qi,
+        IndexT const& ri,
+        ITensorT<IndexT> & Q,
+        ITensorT<IndexT> & R,
+        Args const& args)
+    {
+    if(A.r() != 2)
+        {
+        Print(A);
+        Error("A must be matrix-like (rank 2)");
+        }
+    if(isComplex(A))
+        {
+        return qrImpl<Cplx>(A,qi,ri,Q,R,args);
+        }
+    return qrImpl<Real>(A,qi,ri,Q,R,args);
+    }
+template void
+qrRank2(ITensor const&,Index const&,Index const&,
+        ITensor &,ITensor &,Args const&);
+template void
+qrRank2(IQTensor const&,IQIndex const&,IQIndex const&,
+        IQTensor &,IQTensor &,Args const&);
+
+} //namespace itensor
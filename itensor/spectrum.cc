@@ -55,30 +55,24 @@ qn(int n) const
 void Spectrum::
 read(std::istream& s)
     {
-    Error("Spectrum::read not currently implemented");
-    //s.read((char*)&truncerr_,sizeof(truncerr_));
-    //eigs_.read(s);
-    //size_t sz = 0;
-    //s.read((char*)&sz,sizeof(sz));
-    //qns_.resize(sz);
-    //for(size_t j = 0; j < sz; ++j)
-    //    {
-    //    s.read((char*)&qns_[j],sizeof(qns_[j]));
-    //    }
+    itensor::read(s,truncerr_);
+    auto sz = eigs_.size();
+    itensor::read(s,sz);
+    eigs_ = Vector(sz);
+    for(auto& el : eigs_) itensor::read(s,el);
+    itensor::read(s,sz);
+    qns_.resize(sz);
+    for(auto& q : qns_) itensor::read(s,q);
     }
 
 void Spectrum::
 write(std::ostream& s) const
     {
-    Error("Spectrum::read not currently implemented");
-    //s.write((char*)&truncerr_,sizeof(truncerr_));
-    //eigs_.write(s);
-    //size_t sz = qns_.size();
-    //s.write((char*)&sz,sizeof(sz));
-    //for(size_t j = 0; j < sz; ++j)
-    //    {
-    //    s.write((char*)&qns_[j],sizeof(qns_[j]));
-    //    }
+    itensor::write(s,truncerr_);
+    itensor::write(s,eigs_.size());
+    for(auto& el : eigs_) itensor::write(s,el);
+    itensor::write(s,qns_.size());
+    for(auto& q : qns_) itensor::write(s,q);
     }
 
 void Spectrum::
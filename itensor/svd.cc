@@ -36,9 +36,10 @@ svdImpl(ITensor const& A,
         ITensor & V,
         Args const& args)
     {
-    SCOPED_TIMER(7);
+    PROFILE_SCOPE("svd")
     auto do_truncate = args.getBool("Truncate");
     auto thresh = args.getReal("SVDThreshold",1E-3);
+    auto method = svdMethod(args.getString("SVDMethod","DensityMatrix"));
     auto cutoff = args.getReal("Cutoff",MIN_CUT);
     auto maxm = args.getInt("Maxm",MAX_M);
     auto minm = args.getInt("Minm",1);
@@ -56,9 +57,22 @@ svdImpl(ITensor const& A,
     Mat<T> UU,VV;
     Vector DD;
 
-    TIMER_START(6)
-    SVD(M,UU,DD,VV,thresh);
-    TIMER_STOP(6)
+    //When keeping only a few singular values compute just
+    //those, recording the weight of the rest of the spectrum
+    auto rank = do_truncate ? randomizedSVDRank(nrows(M),ncols(M),maxm,args) : 0;
+    Real discarded = 0;
+
+    if(rank > 0)
+        {
+        PROFILE_SCOPE_BYTES("randomizedSVD",sizeof(T)*nrows(M)*ncols(M))
+        randomizedSVD(M,UU,DD,VV,rank,args.getInt("SVDPowerIter",2));
+        discarded = std::max(0.,sqr(norm(M))-sqr(norm(DD)));
+        }
+    else
+        {
+        PROFILE_SCOPE_BYTES("SVD",sizeof(T)*nrows(M)*ncols(M))
+        SVD(M,UU,DD,VV,method,thresh);
+        }
 
     //conjugate VV so later we can just do
     //U*D*V to reconstruct ITensor A:
@@ -79,8 +93,10 @@ svdImpl(ITensor const& A,
     long m = DD.size();
     if(do_truncate)
         {
+        auto targs = args;
+        targs.add("DiscardedWeight",discarded);
         tie(truncerr,docut) = truncate(probs,maxm,minm,cutoff,
-                                       absoluteCutoff,doRelCutoff,args);
+                                       absoluteCutoff,doRelCutoff,targs);
         m = probs.size();
         resize(DD,m);
         reduceCols(UU,m);
@@ -142,8 +158,10 @@ svdImpl(IQTensor A,
         IQTensor & V,
         Args const& args)
     {
+    PROFILE_SCOPE("svd")
     auto do_truncate = args.getBool("Truncate");
     auto thresh = args.getReal("SVDThreshold",1E-3);
+    auto method = svdMethod(args.getString("SVDMethod","DensityMatrix"));
     auto cutoff = args.getReal("Cutoff",0);
     auto maxm = args.getInt("Maxm",MAX_INT);
     auto minm = args.getInt("Minm",1);
@@ -162,15 +180,77 @@ svdImpl(IQTensor A,
     auto Nblock = blocks.size();
     if(Nblock == 0) throw ResultIsZero("IQTensor has no blocks");
 
-    //TODO: optimize allocation/lookup of Umats,Vmats
-    //      etc. by allocating memory ahead of time (see algs.cc)
-    //      and making Umats a vector of MatrixRef's to this memory
-    auto Umats = vector<Mat<T>>(Nblock);
-    auto Vmats = vector<Mat<T>>(Nblock);
+    if(uI.m() == 0) throw ResultIsZero("uI.m() == 0");
+    if(vI.m() == 0) throw ResultIsZero("vI.m() == 0");
 
-    //TODO: allocate dvecs in a single allocation
-    //      make dvecs a vector<VecRef>
-    auto dvecs = vector<Vector>(Nblock);
+    //Number of singular values computed per block: if requested,
+    //blocks much larger than maxm use randomizedSVD to get only
+    //the leading ones
+    auto ranks = vector<long>(Nblock);
+    auto discarded = vector<Real>(Nblock,0.);
+    auto niter = args.getInt("SVDPowerIter",2);
+    for(auto b : range(Nblock))
+        {
+        auto& M = blocks[b].M;
+        auto rank = do_truncate ? randomizedSVDRank(nrows(M),ncols(M),maxm,args) : 0;
+        ranks[b] = rank > 0 ? rank : std::min(nrows(M),ncols(M));
+        }
+
+    //Lay out U, V and the singular values of
+    //all blocks in single allocations
+    size_t totalUsize = 0,
+           totalVsize = 0,
+           totaldsize = 0;
+    for(auto b : range(Nblock))
+        {
+        auto& M = blocks[b].M;
+        auto nsv = ranks[b];
+        totalUsize += nrows(M)*nsv;
+        totalVsize += ncols(M)*nsv;
+        totaldsize += nsv;
+        }
+    auto Udata = vector<T>(totalUsize);
+    auto Vdata = vector<T>(totalVsize);
+    auto ddata = vector<Real>(totaldsize);
+    auto Umats = vector<MatRef<T>>(Nblock);
+    auto Vmats = vector<MatRef<T>>(Nblock);
+    auto dvecs = vector<VectorRef>(Nblock);
+    totalUsize = 0;
+    totalVsize = 0;
+    totaldsize = 0;
+    for(auto b : range(Nblock))
+        {
+        auto& M = blocks[b].M;
+        auto nsv = ranks[b];
+        Umats[b] = makeMatRef(Udata.data()+totalUsize,nrows(M)*nsv,nrows(M),nsv);
+        Vmats[b] = makeMatRef(Vdata.data()+totalVsize,ncols(M)*nsv,ncols(M),nsv);
+        dvecs[b] = makeVecRef(ddata.data()+totaldsize,nsv);
+        totalUsize += nrows(M)*nsv;
+        totalVsize += ncols(M)*nsv;
+        totaldsize += nsv;
+        }
+
+    //Factorize the blocks in parallel, largest first
+    auto order = blocksByCost(blocks);
+    parallelFor(Nblock,getNThread(args),
+                [&](size_t j)
+                    {
+                    auto b = order[j];
+                    auto& M = blocks[b].M;
+                    PROFILE_SCOPE_BYTES("svd block",sizeof(T)*nrows(M)*ncols(M))
+                    if(ranks[b] < long(std::min(nrows(M),ncols(M))))
+                        {
+                        randomizedSVD(M,Umats[b],dvecs[b],Vmats[b],ranks[b],niter);
+                        discarded[b] = std::max(0.,sqr(norm(M))-sqr(norm(dvecs[b])));
+                        }
+                    else
+                        {
+                        SVD(M,Umats[b],dvecs[b],Vmats[b],method,thresh);
+                        }
+                    //conjugate VV so later we can just do
+                    //U*D*V to reconstruct ITensor A:
+                    conjugate(Vmats[b]);
+                    });
 
     auto alleig = stdx::reserve_vector<Real>(std::min(uI.m(),vI.m()));
 
@@ -180,22 +260,9 @@ svdImpl(IQTensor A,
         alleigqn = stdx::reserve_vector<EigQN>(std::min(uI.m(),vI.m()));
         }
 
-    if(uI.m() == 0) throw ResultIsZero("uI.m() == 0");
-    if(vI.m() == 0) throw ResultIsZero("vI.m() == 0");
-
     for(auto b : range(Nblock))
         {
-        auto& M = blocks[b].M;
-        auto& UU = Umats.at(b);
-        auto& VV = Vmats.at(b);
         auto& d =  dvecs.at(b);
-
-        SVD(M,UU,d,VV,thresh);
-
-        //conjugate VV so later we can just do
-        //U*D*V to reconstruct ITensor A:
-        conjugate(VV);
-
         alleig.insert(alleig.end(),d.begin(),d.end());
         if(compute_qn)
             {
@@ -224,8 +291,10 @@ svdImpl(IQTensor A,
     Real docut = -1;
     if(do_truncate)
         {
+        auto targs = args;
+        targs.add("DiscardedWeight",stdx::accumulate(discarded,0.));
         tie(truncerr,docut) = truncate(probs,maxm,minm,cutoff,
-                                       absoluteCutoff,doRelCutoff,args);
+                                       absoluteCutoff,doRelCutoff,targs);
         m = probs.size();
         alleigqn.resize(m);
         }
@@ -275,7 +344,7 @@ svdImpl(IQTensor A,
             continue; 
             }
 
-        resize(d,this_m);
+        d = subVector(d,0,this_m);
 
         Liq.emplace_back(Index("l",this_m,litype),uI.qn(1+B.i1));
         Riq.emplace_back(Index("r",this_m,ritype),vI.qn(1+B.i2));
@@ -315,8 +384,7 @@ svdImpl(IQTensor A,
         assert(pU.data() != nullptr);
         assert(uI[B.i1].m() == long(nrows(UU)));
         auto Uref = makeMatRef(pU,uI[B.i1].m(),L[n].m());
-        reduceCols(UU,L[n].m());
-        Uref &= UU;
+        Uref &= columns(UU,0,L[n].m());
 
         auto dind = stdx::make_array(n,n);
         auto pD = getBlock(Dstore,Dis,dind);
@@ -329,11 +397,10 @@ svdImpl(IQTensor A,
         assert(pV.data() != nullptr);
         assert(vI[B.i2].m() == long(nrows(VV)));
         auto Vref = makeMatRef(pV.data(),pV.size(),vI[B.i2].m(),R[n].m());
-        reduceCols(VV,R[n].m());
         //println("Doing Vref &= VV");
         //Print(Vref.range());
         //Print(VV.range());
-        Vref &= VV;
+        Vref &= columns(VV,0,R[n].m());
 
         /////////DEBUG
         //Matrix D(d.size(),d.size());
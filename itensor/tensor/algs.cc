@@ -3,10 +3,13 @@
 //    (See accompanying LICENSE file.)
 //
 #include <limits>
+#include <memory>
+#include <random>
 #include <stdexcept>
 #include <tuple>
 #include "itensor/tensor/lapack_wrap.h"
 #include "itensor/tensor/algs.h"
+#include "itensor/util/multalloc.h"
 #include "itensor/util/range.h"
 #include "itensor/global.h"
 
@@ -22,17 +25,115 @@ namespace detail {
     int
     hermitianDiag(int N, Real *Udata, Real *ddata)
         {
-        LAPACK_INT info = 0;
-        dsyev_wrapper('V','U',N,Udata,ddata,info);
-        return info;
+        return dsyevd_wrapper(N,Udata,ddata);
         }
     int
     hermitianDiag(int N, Cplx *Udata,Real *ddata)
         {
-        return zheev_wrapper(N,Udata,ddata);
+        //zheevr (MRRR) is several times faster than zheev
+        auto Z = ScratchBuf<Cplx>(N*N);
+        LAPACK_INT nfound = 0;
+        auto info = syevr_wrapper('A',N,Udata,0,0,0,0,nfound,ddata,Z.data());
+        std::copy(Z.data(),Z.data()+Z.size(),Udata);
+        return info;
+        }
+
+    //Random numbers in [0,1) from a generator local to
+    //one call: orthog and randomizedSVD run inside parallel
+    //loops over blocks, where the shared seed of quickran
+    //would be a data race. Seeding from seedRNG, a tag and
+    //the matrix shape keeps results reproducible however
+    //the blocks are scheduled.
+    class LocalRNG
+        {
+        unsigned tag_ = 0;
+        size_t nr_ = 0,
+               nc_ = 0;
+        std::unique_ptr<std::mt19937> rng_;
+        public:
+        LocalRNG(unsigned tag, size_t nr, size_t nc) 
+          : tag_(tag), nr_(nr), nc_(nc) 
+          { }
+
+        Real
+        operator()()
+            {
+            if(!rng_)
+                {
+                std::seed_seq seq{unsigned(localRNGSeed()),tag_,
+                                  unsigned(nr_),unsigned(nc_)};
+                rng_ = std::unique_ptr<std::mt19937>(new std::mt19937(seq));
+                }
+            return std::uniform_real_distribution<Real>(0.,1.)(*rng_);
+            }
+        };
+    void
+    randomizeLocal(VecRef<Real> const& v, LocalRNG & rng)
+        {
+        for(auto& el : v) el = rng();
+        }
+    void
+    randomizeLocal(VecRef<Cplx> const& v, LocalRNG & rng)
+        {
+        for(auto& el : v) 
+            {
+            auto re = rng();
+            el = Cplx(re,rng());
+            }
         }
 } //namespace detail
 
+template<typename T>
+size_t
+diagHermitianRef(MatRefc<T> const& M,
+                 MatRef<T>  const& U,
+                 VectorRef  const& d,
+                 Real minval)
+    {
+    LAPACK_INT N = ncols(M);
+    LAPACK_INT k = ncols(U);
+    if(N < 1) throw std::runtime_error("diagHermitian: 0 dimensional matrix");
+    if(N != LAPACK_INT(nrows(M))) throw std::runtime_error("diagHermitian: Input Matrix must be square");
+    if(LAPACK_INT(nrows(U)) != N || LAPACK_INT(d.size()) != k || k > N)
+        throw std::runtime_error("diagHermitian: wrong size of U or d");
+    if(!isContiguous(U)) throw std::runtime_error("diagHermitian: U must be contiguous");
+    if(k == 0) return 0;
+
+    //Diagonalize A = -M so the largest eigenvalues come first
+    auto Abuf = ScratchBuf<T>(N*N);
+    auto A = makeMatRef(Abuf.data(),Abuf.size(),N,N);
+    A &= M;
+    A *= -1;
+    auto w = ScratchBuf<Real>(N);
+    LAPACK_INT nfound = 0,
+               info = 0;
+    if(k < N)
+        {
+        info = syevr_wrapper('I',N,A.data(),0,0,1,k,nfound,w.data(),U.data());
+        }
+    else if(minval > -std::numeric_limits<Real>::max())
+        {
+        //Eigenvalues of A in (vl,-minval], with vl
+        //below the whole spectrum since |eig| <= norm(M)
+        auto vl = -(norm(M)+1.);
+        info = syevr_wrapper('V',N,A.data(),vl,-minval,0,0,nfound,w.data(),U.data());
+        }
+    else
+        {
+        info = syevr_wrapper('A',N,A.data(),0,0,0,0,nfound,w.data(),U.data());
+        }
+    if(info != 0) throw std::runtime_error("Error condition in diagHermitian");
+
+    size_t n = 0;
+    for(; n < size_t(nfound) && -w[n] >= minval; ++n)
+        {
+        d(n) = -w[n];
+        }
+    return n;
+    }
+template size_t diagHermitianRef(MatRefc<Real> const&,MatRef<Real> const&,VectorRef const&,Real);
+template size_t diagHermitianRef(MatRefc<Cplx> const&,MatRef<Cplx> const&,VectorRef const&,Real);
+
 //void
 //diagHermitian(MatrixRefc const& Mre,
 //              MatrixRefc const& Mim,
@@ -277,6 +378,7 @@ orthog(MatRef<V> M,
     {
     auto nkeep = std::min(nrows(M), ncols(M));
     auto dots = Vec<V>(nkeep);
+    auto rng = detail::LocalRNG(0,nrows(M),ncols(M));
     for(auto i : range(nkeep))
         {
         //normalize column i
@@ -284,7 +386,7 @@ orthog(MatRef<V> M,
         auto nrm = norm(coli);
         if(nrm == 0.0)
             {
-            randomize(coli);
+            detail::randomizeLocal(coli,rng);
             nrm = norm(coli);
             }
         coli /= nrm;
@@ -304,7 +406,7 @@ orthog(MatRef<V> M,
             if(nrm < 1E-3) --pass; //orthog is suspect
             if(nrm < 1E-10) // What if a subspace was zero in all vectors?
                 {
-                randomize(coli);
+                detail::randomizeLocal(coli,rng);
                 nrm = norm(coli);
                 }
             coli /= nrm;
@@ -448,16 +550,20 @@ SVDRefImpl(MatRefc<T> const& M,
 #endif
 
     //Form 'density matrix' rho
-    Mat<T> rho,
-           Mconj;
+    //(temporaries use the thread's scratch memory)
+    auto rhobuf = ScratchBuf<T>(Mr*Mr);
+    auto rho = makeMatRef(rhobuf.data(),rhobuf.size(),Mr,Mr);
+    auto Mconjbuf = ScratchBuf<T>(isCplx(M) ? Mr*Mc : 0);
+    auto Mconj = makeMatRef(Mconjbuf.data(),Mconjbuf.size(),Mr,isCplx(M) ? Mc : 0);
     if(isCplx(M)) 
         {
-        Mconj = conj(M);
-        rho = M * transpose(Mconj);
+        Mconj &= M;
+        conjugate(Mconj);
+        gemm(M,transpose(Mconj),rho,1.,0.);
         }
     else
         {
-        rho = M * transpose(M);
+        gemm(M,transpose(M),rho,1.,0.);
         }
 
     //Diagonalize rho: evals are squares of singular vals
@@ -541,8 +647,7 @@ SVDRefImpl(MatRefc<T> const& M,
      //   }
 
     //reuse rho's storage to avoid allocation
-    auto mv = move(rho);
-    reduceCols(mv,n);
+    auto mv = makeMatRef(rhobuf.data(),rhobuf.size(),Mr,n);
 
     auto u = columns(U,start,ncols(U));
     auto v = columns(V,start,ncols(V));
@@ -550,21 +655,26 @@ SVDRefImpl(MatRefc<T> const& M,
     //b should be close to diagonal
     //but may not be perfect - fix it up below
     mult(M,v,mv);
-    Mat<T> b;
-    if(isCplx(M)) b = conj(transpose(u))*mv;
-    else          b = transpose(u)*mv;
+    auto bbuf = ScratchBuf<T>(n*n);
+    auto b = makeMatRef(bbuf.data(),bbuf.size(),n,n);
+    if(isCplx(M)) b &= conj(transpose(u))*mv;
+    else          gemm(transpose(u),mv,b,1.,0.);
 
     auto d = subVector(D,start,Mr);
-    Mat<T> bu(n,n),
-           bv(n,n);
-    SVDRef(makeRef(b),makeRef(bu),d,makeRef(bv),thresh);
+    auto bubuf = ScratchBuf<T>(n*n),
+         bvbuf = ScratchBuf<T>(n*n);
+    auto bu = makeMatRef(bubuf.data(),bubuf.size(),n,n),
+         bv = makeMatRef(bvbuf.data(),bvbuf.size(),n,n);
+    SVDRef(b,bu,d,bv,thresh);
 
     //reuse mv's storage to avoid allocation
-    auto W = move(mv);
+    auto W = mv;
     mult(u,bu,W);
     u &= W;
 
-    auto X = v*bv;
+    auto Xbuf = ScratchBuf<T>(Mc*n);
+    auto X = makeMatRef(Xbuf.data(),Xbuf.size(),Mc,n);
+    gemm(v,bv,X,1.,0.);
     v &= X;
 
 #ifdef CHKSVD
@@ -587,6 +697,187 @@ SVDRef(MatRefc<T> const& M,
 template void SVDRef(MatRefc<Real> const&,MatRef<Real> const&, VectorRef const&, MatRef<Real> const&,Real);
 template void SVDRef(MatRefc<Cplx> const&,MatRef<Cplx> const&, VectorRef const&, MatRef<Cplx> const&,Real);
 
+SVDMethod
+svdMethod(std::string const& name)
+    {
+    if(name == "DensityMatrix") return DensityMatrixSVD;
+    if(name == "gesdd") return GesddSVD;
+    if(name == "gesvd") return GesvdSVD;
+    throw ITError("SVDMethod \""+name+"\" not recognized; use \"DensityMatrix\", \"gesdd\" or \"gesvd\"");
+    }
+
+//Returns false if LAPACK reports an error,
+//in which case U, D and V are not set
+template<typename T>
+bool
+lapackSVD(MatRefc<T> const& M,
+          MatRef<T>  const& U, 
+          VectorRef  const& D, 
+          MatRef<T>  const& V,
+          SVDMethod method)
+    {
+    LAPACK_INT Mr = nrows(M), 
+               Mc = ncols(M),
+               nsv = std::min(Mr,Mc);
+
+    //LAPACK needs a contiguous, column-major
+    //copy of M, which it overwrites
+    auto Abuf = ScratchBuf<T>(Mr*Mc);
+    auto ubuf = ScratchBuf<T>(Mr*nsv);
+    auto vtbuf = ScratchBuf<T>(nsv*Mc);
+    auto A = makeMatRef(Abuf.data(),Abuf.size(),Mr,Mc);
+    auto u = makeMatRef(ubuf.data(),ubuf.size(),Mr,nsv);
+    auto vt = makeMatRef(vtbuf.data(),vtbuf.size(),nsv,Mc);
+
+    auto info = LAPACK_INT(0);
+    if(method == GesddSVD)
+        {
+        A &= M;
+        info = gesdd_wrapper(Mr,Mc,A.data(),D.data(),u.data(),vt.data());
+        }
+    if(method == GesvdSVD || info != 0)
+        {
+        A &= M;
+        info = gesvd_wrapper(Mr,Mc,A.data(),D.data(),u.data(),vt.data());
+        }
+    if(info != 0) return false;
+
+    U &= u;
+    V &= transpose(vt);
+    if(isCplx(M)) conjugate(V);
+    return true;
+    }
+
+template<typename T>
+void
+SVDRef(MatRefc<T> const& M,
+       MatRef<T>  const& U, 
+       VectorRef  const& D, 
+       MatRef<T>  const& V,
+       SVDMethod method,
+       Real thresh)
+    {
+#ifdef DEBUG
+    auto nsv = std::min(nrows(M),ncols(M));
+    if(!(nrows(U)==nrows(M) && ncols(U)==nsv)) 
+        throw std::runtime_error("SVD (ref version), wrong size of U");
+    if(!(nrows(V)==ncols(M) && ncols(V)==nsv)) 
+        throw std::runtime_error("SVD (ref version), wrong size of V");
+    if(D.size()!=nsv)
+        throw std::runtime_error("SVD (ref version), wrong size of D");
+#endif
+    if(method != DensityMatrixSVD && lapackSVD(M,U,D,V,method)) return;
+    SVDRefImpl(M,U,D,V,thresh);
+    }
+template void SVDRef(MatRefc<Real> const&,MatRef<Real> const&, VectorRef const&, MatRef<Real> const&,SVDMethod,Real);
+template void SVDRef(MatRefc<Cplx> const&,MatRef<Cplx> const&, VectorRef const&, MatRef<Cplx> const&,SVDMethod,Real);
+
+template<typename T>
+void
+randomizedSVDRef(MatRefc<T> const& M,
+                 MatRef<T>  const& U, 
+                 VectorRef  const& D, 
+                 MatRef<T>  const& V,
+                 size_t niter)
+    {
+    auto Mr = nrows(M),
+         Mc = ncols(M),
+         k = D.size();
+#ifdef DEBUG
+    if(!(nrows(U)==Mr && ncols(U)==k)) 
+        throw std::runtime_error("randomizedSVD (ref version), wrong size of U");
+    if(!(nrows(V)==Mc && ncols(V)==k)) 
+        throw std::runtime_error("randomizedSVD (ref version), wrong size of V");
+    if(k > std::min(Mr,Mc))
+        throw std::runtime_error("randomizedSVD (ref version), D too large");
+#endif
+
+    auto Mconjbuf = ScratchBuf<T>(isCplx(M) ? Mr*Mc : 0);
+    auto Mconj = makeMatRef(Mconjbuf.data(),Mconjbuf.size(),Mr,isCplx(M) ? Mc : 0);
+    if(isCplx(M)) 
+        {
+        Mconj &= M;
+        conjugate(Mconj);
+        }
+    //Z = M^dag * Y
+    auto multAdj = [&](MatRef<T> const& Y, MatRef<T> const& Z)
+        {
+        if(isCplx(M)) gemm(transpose(Mconj),Y,Z,1.,0.);
+        else          gemm(transpose(M),Y,Z,1.,0.);
+        };
+
+    //Y: orthonormal basis for the range of M
+    //Z: orthonormal basis for the range of M^dag
+    auto Ybuf = ScratchBuf<T>(Mr*k),
+         Zbuf = ScratchBuf<T>(Mc*k);
+    auto Y = makeMatRef(Ybuf.data(),Ybuf.size(),Mr,k);
+    auto Z = makeMatRef(Zbuf.data(),Zbuf.size(),Mc,k);
+
+    auto omega = makeVecRef(Zbuf.data(),Zbuf.size());
+    auto rng = detail::LocalRNG(1,Mr,Mc);
+    detail::randomizeLocal(omega,rng);
+    gemm(M,Z,Y,1.,0.);
+    orthog(Y,2);
+    for(size_t it = 0; it < niter; ++it)
+        {
+        multAdj(Y,Z);
+        orthog(Z,2);
+        gemm(M,Z,Y,1.,0.);
+        orthog(Y,2);
+        }
+
+    //Within the range of Y, M = Y*B with B = Y^dag*M.
+    //SVD of B^dag = Z*D*Q^dag gives M = (Y*Q)*D*Z^dag.
+    multAdj(Y,Z);
+    auto Qbuf = ScratchBuf<T>(k*k);
+    auto Q = makeMatRef(Qbuf.data(),Qbuf.size(),k,k);
+    SVDRef(makeRefc(Z),V,D,Q,GesddSVD,SVD_THRESH);
+    gemm(Y,Q,U,1.,0.);
+    }
+template void randomizedSVDRef(MatRefc<Real> const&,MatRef<Real> const&, VectorRef const&, MatRef<Real> const&,size_t);
+template void randomizedSVDRef(MatRefc<Cplx> const&,MatRef<Cplx> const&, VectorRef const&, MatRef<Cplx> const&,size_t);
+
+template<typename T>
+void
+QRRef(MatRefc<T> const& M,
+      MatRef<T>  const& Q, 
+      MatRef<T>  const& R)
+    {
+    auto Mr = nrows(M), 
+         Mc = ncols(M),
+         k = std::min(Mr,Mc);
+#ifdef DEBUG
+    if(!(nrows(Q)==Mr && ncols(Q)==k)) 
+        throw std::runtime_error("QR (ref version), wrong size of Q");
+    if(!(nrows(R)==k && ncols(R)==Mc)) 
+        throw std::runtime_error("QR (ref version), wrong size of R");
+#endif
+    if(k == 0) return;
+
+    //LAPACK overwrites a contiguous,
+    //column-major copy of M
+    auto Abuf = ScratchBuf<T>(Mr*Mc);
+    auto taubuf = ScratchBuf<T>(k);
+    auto A = makeMatRef(Abuf.data(),Abuf.size(),Mr,Mc);
+    A &= M;
+
+    auto info = geqrf_wrapper(Mr,Mc,A.data(),taubuf.data());
+    if(info != 0) throw std::runtime_error("QR: LAPACK geqrf failed");
+
+    //R is the upper triangle of A
+    for(auto c : range(Mc))
+    for(auto r : range(k))
+        {
+        R(r,c) = (r <= c) ? A(r,c) : T(0);
+        }
+
+    info = orgqr_wrapper(Mr,k,k,A.data(),taubuf.data());
+    if(info != 0) throw std::runtime_error("QR: LAPACK orgqr failed");
+    Q &= columns(A,0,k);
+    }
+template void QRRef(MatRefc<Real> const&,MatRef<Real> const&,MatRef<Real> const&);
+template void QRRef(MatRefc<Cplx> const&,MatRef<Cplx> const&,MatRef<Cplx> const&);
+
 
 
 //void
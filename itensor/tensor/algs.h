@@ -5,6 +5,7 @@
 #ifndef __ITENSOR_MATRIX_ALGS__H_
 #define __ITENSOR_MATRIX_ALGS__H_
 
+#include <limits>
 #include "itensor/tensor/slicemat.h"
 
 namespace itensor {
@@ -41,6 +42,40 @@ diagHermitian(MatM && M,
               MatU && U,
               Vecd && d);
 
+//
+// Partial diagHermitian: computes only the largest
+// eigenvalues of M, in decreasing order, and their
+// eigenvectors - at most nkeep of them and only
+// those >= minval. U and d are resized to the
+// number found.
+// Uses the LAPACK MRRR routines (dsyevr/zheevr),
+// whose cost scales with the number of eigenpairs
+// computed.
+//
+template<class MatM, typename T,
+         class = stdx::require<hasMatRange<MatM>>>
+void
+diagHermitian(MatM && M,
+              Mat<T> & U,
+              Vector & d,
+              size_t nkeep,
+              Real minval = -std::numeric_limits<Real>::max());
+
+//
+// Version of partial diagHermitian writing into
+// existing storage: computes the largest ncols(U)
+// eigenpairs >= minval into U and d (of size ncols(U))
+// and returns the number n found. Results are in
+// the first n columns of U and elements of d.
+// U must be contiguous.
+//
+template<typename T>
+size_t
+diagHermitianRef(MatRefc<T> const& M,
+                 MatRef<T>  const& U,
+                 VectorRef  const& d,
+                 Real minval = -std::numeric_limits<Real>::max());
+
 // compute eigenvalues
 // and right eigenvectors
 template<class MatM, class MatV,class Vecd,
@@ -84,6 +119,22 @@ void
 orthog(Mat_ && M, size_t numpass = 2) { orthog(makeRef(M),numpass); }
 
 
+//
+// Algorithms available to SVD:
+// o DensityMatrixSVD: diagonalize M*M^dag, then refine the small
+//   singular values by recursing on the remaining block (default)
+// o GesddSVD: LAPACK divide-and-conquer ?gesdd, retried
+//   with ?gesvd if it fails to converge
+// o GesvdSVD: LAPACK ?gesvd
+// The LAPACK methods fall back to DensityMatrixSVD on failure.
+//
+enum SVDMethod { DensityMatrixSVD, GesddSVD, GesvdSVD };
+
+//Converts the name used for the "SVDMethod" arg
+//("DensityMatrix", "gesdd" or "gesvd") to an SVDMethod
+SVDMethod
+svdMethod(std::string const& name);
+
 //
 // Compute U,D,V such that 
 // norm(A-U*DD*conj(transpose(V))) < epsilon
@@ -105,6 +156,68 @@ SVD(MatM && M,
     MatV && V,
     Real thresh = SVD_THRESH);
 
+template<class MatM, class MatU,class VecD,class MatV,
+         class = stdx::require<
+         hasMatRange<MatM>,
+         hasMatRange<MatU>,
+         hasVecRange<VecD>,
+         hasMatRange<MatV>
+         >>
+void
+SVD(MatM && M,
+    MatU && U, 
+    VecD && D, 
+    MatV && V,
+    SVDMethod method,
+    Real thresh = SVD_THRESH);
+
+//
+// Randomized SVD: computes only the leading nsv singular
+// values and vectors of M, such that for M's spectrum
+// decaying fast enough U*DD*conj(transpose(V)) ~= M.
+// The range of M is found by applying it to nsv random
+// vectors followed by niter power iterations (which make
+// it accurate even for slowly decaying spectra).
+// Cost is O(nrows*ncols*nsv) instead of O(nrows*ncols*min(nrows,ncols)).
+// Typical use is to pass nsv = Maxm + p with a small
+// "oversampling" p (~10) to improve accuracy.
+//
+template<class MatM, class MatU,class VecD,class MatV,
+         class = stdx::require<
+         hasMatRange<MatM>,
+         hasMatRange<MatU>,
+         hasVecRange<VecD>,
+         hasMatRange<MatV>
+         >>
+void
+randomizedSVD(MatM && M,
+              MatU && U, 
+              VecD && D, 
+              MatV && V,
+              size_t nsv,
+              size_t niter = 2);
+
+//
+// QR decomposition M = Q*R of an m x n matrix M,
+// with k = min(m,n):
+// o Q is m x k with orthonormal columns
+// o R is k x n and upper triangular
+// Much cheaper than the SVD, so preferred whenever
+// only an orthonormal basis for the columns of M
+// is needed (no truncation).
+// For the LQ decomposition M = L*Q, take the
+// QR decomposition of transpose(M).
+//
+template<class MatM, class MatQ,class MatR,
+         class = stdx::require<
+         hasMatRange<MatM>,
+         hasMatRange<MatQ>,
+         hasMatRange<MatR>
+         >>
+void
+QR(MatM && M,
+   MatQ && Q, 
+   MatR && R);
 
 } //namespace itensor
 
@@ -94,6 +94,23 @@ diagHermitian(MatM && M,
     if(isTransposed(M)) conjugate(U);
     }
 
+template<class MatM, typename T, class>
+void
+diagHermitian(MatM && M,
+              Mat<T> & U,
+              Vector & d,
+              size_t nkeep,
+              Real minval)
+    {
+    auto N = ncols(M);
+    auto k = std::min(nkeep,N);
+    resize(U,N,k);
+    resize(d,k);
+    auto n = diagHermitianRef(makeRef(M),makeRef(U),makeRef(d),minval);
+    reduceCols(U,n);
+    resize(d,n);
+    }
+
 template<typename V>
 void
 diagGeneralRef(MatRefc<V> const& M,
@@ -178,6 +195,90 @@ SVD(MatM && M,
     SVDRef(makeRef(M),makeRef(U),makeRef(D),makeRef(V),thresh);
     }
 
+template<typename T>
+void
+SVDRef(MatRefc<T> const& M,
+       MatRef<T>  const& U, 
+       VectorRef  const& D, 
+       MatRef<T>  const& V,
+       SVDMethod method,
+       Real thresh);
+
+template<class MatM, 
+         class MatU,
+         class VecD,
+         class MatV,
+         class>
+void
+SVD(MatM && M,
+    MatU && U, 
+    VecD && D, 
+    MatV && V,
+    SVDMethod method,
+    Real thresh)
+    {
+    auto Mr = nrows(M),
+         Mc = ncols(M);
+    auto nsv = std::min(Mr,Mc);
+    resize(U,Mr,nsv);
+    resize(V,Mc,nsv);
+    resize(D,nsv);
+    SVDRef(makeRef(M),makeRef(U),makeRef(D),makeRef(V),method,thresh);
+    }
+
+template<typename T>
+void
+randomizedSVDRef(MatRefc<T> const& M,
+                 MatRef<T>  const& U, 
+                 VectorRef  const& D, 
+                 MatRef<T>  const& V,
+                 size_t niter);
+
+template<class MatM, 
+         class MatU,
+         class VecD,
+         class MatV,
+         class>
+void
+randomizedSVD(MatM && M,
+              MatU && U, 
+              VecD && D, 
+              MatV && V,
+              size_t nsv,
+              size_t niter)
+    {
+    auto Mr = nrows(M),
+         Mc = ncols(M);
+    nsv = std::min(nsv,std::min(Mr,Mc));
+    resize(U,Mr,nsv);
+    resize(V,Mc,nsv);
+    resize(D,nsv);
+    randomizedSVDRef(makeRef(M),makeRef(U),makeRef(D),makeRef(V),niter);
+    }
+
+template<typename T>
+void
+QRRef(MatRefc<T> const& M,
+      MatRef<T>  const& Q, 
+      MatRef<T>  const& R);
+
+template<class MatM, 
+         class MatQ,
+         class MatR,
+         class>
+void
+QR(MatM && M,
+   MatQ && Q, 
+   MatR && R)
+    {
+    auto Mr = nrows(M),
+         Mc = ncols(M),
+         k = std::min(Mr,Mc);
+    resize(Q,Mr,k);
+    resize(R,k,Mc);
+    QRRef(makeRef(M),makeRef(Q),makeRef(R));
+    }
+
 } //namespace itensor
 
 #endif
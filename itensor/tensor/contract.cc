@@ -1,9 +1,10 @@
 //TODO: replace unordered_map with a simpler container (small_map? or jump directly to location?)
 #include <unordered_map>
-#include <future>
 
 #include "itensor/util/multalloc.h"
 #include "itensor/util/cputime.h"
+#include "itensor/util/threadpool.h"
+#include "itensor/util/opcount.h"
 #include "itensor/detail/algs.h"
 #include "itensor/detail/gcounter.h"
 #include "itensor/tensor/mat.h"
@@ -677,54 +678,87 @@ class CABqueue
         //println("max subtask size is ",maxj);
         //////////
 
-        //Loop over threads in a round-robin fashion.
-        //Assign all tasks with the same memory 
-        //destination (offC) to the same thread. 
-        vector<vector<ABoffC>> threadtask(numthread);
-        int ss = 0;
-        for(auto& t : subtask)
-            {
-            auto& st_tasks = t.second;
-            auto& tt = threadtask[ss];
-            std::move(st_tasks.begin(),st_tasks.end(),std::inserter(tt,tt.end()));
-            ss = (ss+1)%numthread;
-            }
-
-        //"Package" thread tasks into std::future objects
-        //which begin running once they are created
-        vector<std::future<void>> futs(numthread);
-        assert(threadtask.size()==futs.size());
-        for(size_t i = 0; i < futs.size(); ++i)
-            {
-            auto& tt = threadtask[i];
-            //printfln("task size for thread %d is %d",i,tt.size());
-            futs[i] = std::async(std::launch::async,
-                      [&tt]()
-                          { 
-                          for(const auto& task : tt)
+        //All tasks with the same memory destination (offC)
+        //form one group, run in order by a single thread.
+        //Groups are handed out dynamically by the shared pool.
+        vector<vector<ABoffC> const*> groups;
+        groups.reserve(subtask.size());
+        for(auto& t : subtask) groups.push_back(&t.second);
+
+        parallelFor(groups.size(),numthread,
+                    [&groups](size_t g)
+                        {
+                        for(auto& task : *groups[g])
                             task.execute();
-                          }
-                      );
-            }
-        //Wait for futures to complete
-        for(auto& ft : futs) 
-            {
-            ft.wait();
-            }
+                        });
         }
     };
 
 
+//Permutations done by contract with at least this
+//many elements are split over getNThread() threads
+const size_t parallel_permute_size = 1ul<<16;
+
+//Elements start <= i < stop of index ind of t
+//(as a reference with a plain Range)
+template<typename TenRefT>
+auto
+sliceIndex(TenRefT const& t,
+           size_t ind,
+           size_t start,
+           size_t stop)
+    -> decltype(makeRef(t.store(),Range{}))
+    {
+    auto rb = RangeBuilder(t.r());
+    for(decltype(t.r()) j = 0; j < t.r(); ++j)
+        {
+        rb.setIndStr(j,size_t(j) == ind ? stop-start : t.extent(j),t.stride(j));
+        }
+    return makeRef(t.store()+t.stride(ind)*start,rb.build());
+    }
+
+//transform(from,to,op) splitting the slowest-moving
+//index of "to" into one range per thread, so that
+//each thread writes its own contiguous part of "to"
+template<typename RF, typename VF, typename RT, typename VT, typename Op>
+void
+parallelTransform(TenRefc<RF,VF> const& from,
+                  TenRef<RT,VT> const& to,
+                  Op const& op)
+    {
+    auto nthread = getNThread();
+    auto r = to.r();
+    if(nthread <= 1 || r == 0 || to.size() < parallel_permute_size)
+        {
+        transform(from,to,op);
+        return;
+        }
+    decltype(r) ind = 0;
+    for(decltype(r) j = 1; j < r; ++j)
+        {
+        if(to.stride(j) > to.stride(ind)) ind = j;
+        }
+    size_t n = to.extent(ind);
+    auto nchunk = std::min(n,size_t(nthread));
+    parallelFor(nchunk,nthread,[&](size_t c)
+        {
+        auto start = (c*n)/nchunk,
+             stop = ((c+1)*n)/nchunk;
+        transform(sliceIndex(from,ind,start,stop),sliceIndex(to,ind,start,stop),op);
+        });
+    }
+
 template<typename range_t, typename VA, typename VB>
 void 
 contract(CProps const& p,
          TenRefc<range_t,VA> A,
          TenRefc<range_t,VB> B,
          TenRef<range_t,common_type<VA,VB>>  C,
-         Real alpha = 1.,
-         Real beta = 0.)
+         Real alpha,
+         Real beta)
     {
     using VC = common_type<VA,VB>;
+    PROFILE_SCOPE_BYTES("contract",sizeof(VA)*A.size()+sizeof(VB)*B.size()+sizeof(VC)*C.size())
     auto Apsize = p.permuteA() ? area(p.newArange) : 0ul;
     auto Bpsize = p.permuteB() ? area(p.newBrange) : 0ul;
     auto Cpsize = p.permuteC() ? area(p.newCrange) : 0ul;
@@ -732,7 +766,7 @@ contract(CProps const& p,
     auto Bbufsize = isCplx(B) ? 2ul*Bpsize : Bpsize;
     auto Cbufsize = isCplx(C) ? 2ul*Cpsize : Cpsize;
 
-    auto d = std::vector<Real>(Abufsize+Bbufsize+Cbufsize);
+    auto d = ScratchBuf<Real>(Abufsize+Bbufsize+Cbufsize);
     auto ab = MAKE_SAFE_PTR(d.data(),d.size());
     auto bb = ab+Abufsize;
     auto cb = bb+Bbufsize;
@@ -740,10 +774,11 @@ contract(CProps const& p,
     MatRefc<VA> aref;
     if(p.permuteA())
         {
-        SCOPED_TIMER(12)
+        PROFILE_SCOPE_BYTES("permute A",2*sizeof(VA)*Apsize)
+        COUNT_OPS(PermuteOp,0,2*sizeof(VA)*Apsize)
         auto aptr = SAFE_REINTERPRET(VA,ab);
         auto tref = makeTenRef(SAFE_PTR_GET(aptr,Apsize),Apsize,&p.newArange);
-        tref &= permute(A,p.PA);
+        parallelTransform(permute(A,p.PA),tref,[](VA a, VA& t){ t = a; });
         aref = transpose(makeMatRefc(tref.store(),p.dmid,p.dleft));
         }
     else
@@ -761,10 +796,11 @@ contract(CProps const& p,
     MatRefc<VB> bref;
     if(p.permuteB())
         {
-        SCOPED_TIMER(13)
+        PROFILE_SCOPE_BYTES("permute B",2*sizeof(VB)*Bpsize)
+        COUNT_OPS(PermuteOp,0,2*sizeof(VB)*Bpsize)
         auto bptr = SAFE_REINTERPRET(VB,bb);
         auto tref = makeTenRef(SAFE_PTR_GET(bptr,Bpsize),Bpsize,&p.newBrange);
-        tref &= permute(B,p.PB);
+        parallelTransform(permute(B,p.PB),tref,[](VB b, VB& t){ t = b; });
         bref = makeMatRefc(tref.store(),p.dmid,p.dright);
         }
     else
@@ -799,17 +835,26 @@ contract(CProps const& p,
             }
         }
 
-    START_TIMER(11)
-    gemm(aref,bref,cref,alpha,beta);
-    STOP_TIMER(11)
+    //If permuting C, newC holds only alpha*A*B 
+    //and beta*C is added when permuting back
+    gemm(aref,bref,cref,alpha,p.permuteC() ? 0. : beta);
 
     if(p.permuteC())
         {
-        SCOPED_TIMER(14)
+        PROFILE_SCOPE_BYTES("permute C",2*sizeof(VC)*Cpsize)
+        //Adding into C also reads it
+        COUNT_OPS(PermuteOp,0,(beta == 0 ? 2 : 3)*sizeof(VC)*Cpsize)
 #ifdef DEBUG
         if(isTrivial(p.PC)) Error("Calling permute in contract with a trivial permutation");
 #endif
-        C &= permute(newC,p.PC);
+        if(beta == 0)
+            {
+            parallelTransform(permute(newC,p.PC),C,[](VC nc, VC& c){ c = nc; });
+            }
+        else
+            {
+            parallelTransform(permute(newC,p.PC),C,[beta](VC nc, VC& c){ c = beta*c+nc; });
+            }
         }
     }
 
@@ -855,7 +900,30 @@ contract(TenRefc<RangeT,VA> A, Labels const& ai,
         }
     }
 
+std::shared_ptr<CProps>
+computeCProps(Range const& Arange, Labels const& ai,
+              Range const& Brange, Labels const& bi,
+              Range const& Crange, Labels const& ci)
+    {
+    //CProps::compute only uses the extents
+    //of A, B, and C, not their data
+    auto props = std::make_shared<CProps>(ai,bi,ci);
+    props->compute(TenRefc<Range,Real>(DataRange<const Real>{},&Arange),
+                   TenRefc<Range,Real>(DataRange<const Real>{},&Brange),
+                   TenRefc<Range,Real>(DataRange<const Real>{},&Crange));
+    return props;
+    }
+
 //Explicit template instantiations:
+template void 
+contract(CProps const&, TenRefc<Range,Real>, TenRefc<Range,Real>, TenRef<Range,Real>, Real, Real);
+template void 
+contract(CProps const&, TenRefc<Range,Cplx>, TenRefc<Range,Real>, TenRef<Range,Cplx>, Real, Real);
+template void 
+contract(CProps const&, TenRefc<Range,Real>, TenRefc<Range,Cplx>, TenRef<Range,Cplx>, Real, Real);
+template void 
+contract(CProps const&, TenRefc<Range,Cplx>, TenRefc<Range,Cplx>, TenRef<Range,Cplx>, Real, Real);
+
 template void 
 contract(TenRefc<Range,Real>, Labels const&, 
          TenRefc<Range,Real>, Labels const&, 
@@ -995,7 +1063,8 @@ contractloop(TenRefc<RangeT> A, Labels const& ai,
         }
     p.computePerms();
 
-    auto nthread = args.getInt("NThread",4);
+    //contractloop has always defaulted to 4 threads
+    auto nthread = getNThread(args,4);
 
     long ra = ai.size(),
          rb = bi.size(),
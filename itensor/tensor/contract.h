@@ -5,6 +5,7 @@
 #ifndef __ITENSOR_CONTRACT_H
 #define __ITENSOR_CONTRACT_H
 
+#include <memory>
 #include "itensor/tensor/vec.h"
 #include "itensor/util/args.h"
 #include "itensor/util/range.h"
@@ -12,6 +13,10 @@
 
 namespace itensor {
 
+//C = alpha*A*B+beta*C, permuting A, B or C as
+//needed to use gemm. Permutations of large tensors
+//are split over the threads of the shared pool if
+//Args::global() sets "NThread" (see util/threadpool.h).
 template<typename RangeT, typename VA, typename VB>
 void 
 contract(TenRefc<RangeT,VA> A, Labels const& ai, 
@@ -21,6 +26,30 @@ contract(TenRefc<RangeT,VA> A, Labels const& ai,
          Real alpha = 1.,
          Real beta = 0.);
 
+//Analysis of the index pattern of C = A*B
+//(which of A, B, C to permute and how), which
+//depends only on the labels and extents.
+//Computing it once lets repeated contractions
+//of the same shape skip this step.
+struct CProps;
+
+std::shared_ptr<CProps>
+computeCProps(Range const& Arange, Labels const& ai,
+              Range const& Brange, Labels const& bi,
+              Range const& Crange, Labels const& ci);
+
+//Version of contract using a precomputed CProps
+//(ai and bi must be non-empty, i.e. neither
+//A nor B may be a scalar)
+template<typename RangeT, typename VA, typename VB>
+void 
+contract(CProps const& props,
+         TenRefc<RangeT,VA> A,
+         TenRefc<RangeT,VB> B,
+         TenRef<RangeT,common_type<VA,VB>>  C,
+         Real alpha = 1.,
+         Real beta = 0.);
+
 template<typename R, typename VA, typename VB>
 void 
 contract(Ten<R,VA> const& A, Labels const& ai, 
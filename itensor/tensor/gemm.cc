@@ -180,6 +180,12 @@ gemm_impl(MatRefc<Cplx> A,
     }
 
 
+//
+// For mixed real/complex products, two dgemm calls
+// on the real and imaginary parts of the complex
+// argument are cheaper than promoting the real
+// argument to complex and calling zgemm
+//
 void
 gemm_impl(MatRefc<Real> A,
           MatRefc<Cplx> B,
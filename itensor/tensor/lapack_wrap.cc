@@ -1,8 +1,47 @@
 #include "itensor/tensor/lapack_wrap.h"
+#include "itensor/util/multalloc.h"
+#include "itensor/util/opcount.h"
 //#include "itensor/tensor/permutecplx.h"
 
 namespace itensor {
 
+namespace {
+
+//Flop estimates of the decompositions (in real
+//flops, so four times larger if complex)
+
+//Tridiagonal reduction and back transformation
+//of k eigenvectors of an n x n Hermitian matrix
+double
+eigFlops(double n, double k) { return 4./3*n*n*n+2*n*n*k; }
+
+//Thin SVD with singular vectors of an m x n matrix
+double
+svdFlops(double m, double n)
+    {
+    if(m < n) std::swap(m,n);
+    return 6*m*n*n+20*n*n*n;
+    }
+
+//Schur decomposition and eigenvectors of
+//a general n x n matrix
+double
+geevFlops(double n) { return 25*n*n*n; }
+
+template<typename T>
+double
+eigBytes(double n, double k) { return sizeof(T)*(n*n+n*k)+sizeof(Real)*k; }
+
+template<typename T>
+double
+svdBytes(double m, double n)
+    {
+    auto l = std::min(m,n);
+    return sizeof(T)*(m*n+m*l+l*n)+sizeof(Real)*l;
+    }
+
+} //namespace
+
 //
 // daxpy
 // Y += alpha*X
@@ -110,6 +149,8 @@ gemm_wrapper(bool transa,
              LAPACK_REAL beta,
              LAPACK_REAL * C)
     {
+    PROFILE_SCOPE_BYTES("gemm",sizeof(LAPACK_REAL)*(m*k+k*n+m*n))
+    COUNT_OPS(GemmOp,2.*m*n*k,sizeof(LAPACK_REAL)*(1.*m*k+1.*k*n+(beta == 0. ? 1. : 2.)*m*n))
     LAPACK_INT lda = m,
                ldb = k;
 #ifdef ITENSOR_USE_CBLAS
@@ -160,6 +201,8 @@ gemm_wrapper(bool transa,
              Cplx beta,
              Cplx* C)
     {
+    PROFILE_SCOPE_BYTES("gemm",sizeof(Cplx)*(m*k+k*n+m*n))
+    COUNT_OPS(GemmOp,8.*m*n*k,sizeof(Cplx)*(1.*m*k+1.*k*n+(beta == 0. ? 1. : 2.)*m*n))
     LAPACK_INT lda = m,
                ldb = k;
 #ifdef PLATFORM_openblas
@@ -188,7 +231,11 @@ gemm_wrapper(bool transa,
     auto* pA = reinterpret_cast<const double*>(A);
     auto* pB = reinterpret_cast<const double*>(B);
     auto* pC = reinterpret_cast<double*>(C);
+#ifdef ITENSOR_USE_ZGEMM3M
+    cblas_zgemm3m(CblasColMajor,at,bt,m,n,k,palpha,pA,lda,pB,ldb,pbeta,pC,m);
+#else
 	cblas_zgemm(CblasColMajor,at,bt,m,n,k,palpha,pA,lda,pB,ldb,pbeta,pC,m);
+#endif
 #else //platform not openblas
 #ifdef ITENSOR_USE_CBLAS
     auto at = CblasNoTrans,
@@ -203,11 +250,13 @@ gemm_wrapper(bool transa,
         bt = CblasTrans;
         ldb = n;
         }
-    TIMER_START(31)
     auto palpha = (void*)(&alpha); 
     auto pbeta = (void*)(&beta); 
+#ifdef ITENSOR_USE_ZGEMM3M
+    cblas_zgemm3m(CblasColMajor,at,bt,m,n,k,palpha,(void*)A,lda,(void*)B,ldb,pbeta,(void*)C,m);
+#else
     cblas_zgemm(CblasColMajor,at,bt,m,n,k,palpha,(void*)A,lda,(void*)B,ldb,pbeta,(void*)C,m);
-    TIMER_STOP(31)
+#endif
 #else //use Fortran zgemm
     auto *ncA = const_cast<Cplx*>(A);
     auto *ncB = const_cast<Cplx*>(B);
@@ -314,12 +363,12 @@ dsyev_wrapper(char jobz,        //if jobz=='V', compute eigs and evecs
               LAPACK_REAL* eigs, //eigenvalues on return
               LAPACK_INT& info)  //error info
     {
-    std::vector<LAPACK_REAL> work;
+    COUNT_OPS(DecompOp,eigFlops(n,jobz == 'V' ? n : 0),eigBytes<LAPACK_REAL>(n,jobz == 'V' ? n : 0))
     LAPACK_INT lda = n;
 
 #ifdef PLATFORM_acml
     LAPACK_INT lwork = std::max(1,3*n-1);
-    work.resize(lwork+2);
+    auto work = ScratchBuf<LAPACK_REAL>(lwork+2);
     F77NAME(dsyev)(&jobz,&uplo,&n,A,&lda,eigs,work.data(),&lwork,&info,1,1);
 #else
     //Compute optimal workspace size (will be written to wkopt)
@@ -327,11 +376,149 @@ dsyev_wrapper(char jobz,        //if jobz=='V', compute eigs and evecs
     LAPACK_REAL wkopt = 0;
     F77NAME(dsyev)(&jobz,&uplo,&n,A,&lda,eigs,&wkopt,&lwork,&info);
     lwork = LAPACK_INT(wkopt);
-    work.resize(lwork+2);
+    auto work = ScratchBuf<LAPACK_REAL>(lwork+2);
     F77NAME(dsyev)(&jobz,&uplo,&n,A,&lda,eigs,work.data(),&lwork,&info);
 #endif
     }
 
+//
+// dsyevd
+//
+LAPACK_INT
+dsyevd_wrapper(LAPACK_INT N,
+               LAPACK_REAL* A,
+               LAPACK_REAL* eigs)
+    {
+    COUNT_OPS(DecompOp,eigFlops(N,N),eigBytes<LAPACK_REAL>(N,N))
+    char jobz = 'V';
+    char uplo = 'U';
+    LAPACK_INT info = 0;
+    //Workspace query
+    LAPACK_INT lwork = -1,
+               liwork = -1;
+    LAPACK_REAL wkopt = 0;
+    LAPACK_INT iwkopt = 0;
+#ifdef PLATFORM_acml
+    F77NAME(dsyevd)(&jobz,&uplo,&N,A,&N,eigs,&wkopt,&lwork,&iwkopt,&liwork,&info,1,1);
+#else
+    F77NAME(dsyevd)(&jobz,&uplo,&N,A,&N,eigs,&wkopt,&lwork,&iwkopt,&liwork,&info);
+#endif
+    lwork = LAPACK_INT(wkopt);
+    liwork = iwkopt;
+    auto work = ScratchBuf<LAPACK_REAL>(lwork);
+    std::vector<LAPACK_INT> iwork(liwork);
+#ifdef PLATFORM_acml
+    F77NAME(dsyevd)(&jobz,&uplo,&N,A,&N,eigs,work.data(),&lwork,iwork.data(),&liwork,&info,1,1);
+#else
+    F77NAME(dsyevd)(&jobz,&uplo,&N,A,&N,eigs,work.data(),&lwork,iwork.data(),&liwork,&info);
+#endif
+    return info;
+    }
+
+//
+// syevr
+//
+LAPACK_INT
+syevr_wrapper(char range,
+              LAPACK_INT N,
+              Real* A,
+              Real vl,
+              Real vu,
+              LAPACK_INT il,
+              LAPACK_INT iu,
+              LAPACK_INT & nfound,
+              Real* w,
+              Real* Z)
+    {
+    auto nvec = (range == 'I') ? iu-il+1 : N;
+    COUNT_OPS(DecompOp,eigFlops(N,nvec),eigBytes<Real>(N,nvec))
+    char jobz = 'V';
+    char uplo = 'U';
+    LAPACK_REAL abstol = 0;
+    LAPACK_INT info = 0;
+    nfound = 0;
+    std::vector<LAPACK_INT> isuppz(2*N);
+    //Workspace query
+    LAPACK_INT lwork = -1,
+               liwork = -1;
+    LAPACK_REAL wkopt = 0;
+    LAPACK_INT iwkopt = 0;
+#ifdef PLATFORM_acml
+    F77NAME(dsyevr)(&jobz,&range,&uplo,&N,A,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,Z,&N,isuppz.data(),
+                    &wkopt,&lwork,&iwkopt,&liwork,&info,1,1,1);
+#else
+    F77NAME(dsyevr)(&jobz,&range,&uplo,&N,A,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,Z,&N,isuppz.data(),
+                    &wkopt,&lwork,&iwkopt,&liwork,&info);
+#endif
+    lwork = LAPACK_INT(wkopt);
+    liwork = iwkopt;
+    auto work = ScratchBuf<LAPACK_REAL>(lwork);
+    std::vector<LAPACK_INT> iwork(liwork);
+#ifdef PLATFORM_acml
+    F77NAME(dsyevr)(&jobz,&range,&uplo,&N,A,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,Z,&N,isuppz.data(),
+                    work.data(),&lwork,iwork.data(),&liwork,&info,1,1,1);
+#else
+    F77NAME(dsyevr)(&jobz,&range,&uplo,&N,A,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,Z,&N,isuppz.data(),
+                    work.data(),&lwork,iwork.data(),&liwork,&info);
+#endif
+    return info;
+    }
+
+LAPACK_INT
+syevr_wrapper(char range,
+              LAPACK_INT N,
+              Cplx* A,
+              Real vl,
+              Real vu,
+              LAPACK_INT il,
+              LAPACK_INT iu,
+              LAPACK_INT & nfound,
+              Real* w,
+              Cplx* Z)
+    {
+    auto nvec = (range == 'I') ? iu-il+1 : N;
+    COUNT_OPS(DecompOp,4*eigFlops(N,nvec),eigBytes<Cplx>(N,nvec))
+    static_assert(sizeof(LAPACK_COMPLEX)==sizeof(Cplx),"LAPACK_COMPLEX and itensor::Cplx have different size");
+    char jobz = 'V';
+    char uplo = 'U';
+    LAPACK_REAL abstol = 0;
+    LAPACK_INT info = 0;
+    nfound = 0;
+    auto pA = reinterpret_cast<LAPACK_COMPLEX*>(A);
+    auto pZ = reinterpret_cast<LAPACK_COMPLEX*>(Z);
+    std::vector<LAPACK_INT> isuppz(2*N);
+    //Workspace query
+    LAPACK_INT lwork = -1,
+               lrwork = -1,
+               liwork = -1;
+    Cplx wkopt = 0;
+    auto pwk = reinterpret_cast<LAPACK_COMPLEX*>(&wkopt);
+    LAPACK_REAL rwkopt = 0;
+    LAPACK_INT iwkopt = 0;
+#ifdef PLATFORM_acml
+    F77NAME(zheevr)(&jobz,&range,&uplo,&N,pA,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,pZ,&N,isuppz.data(),
+                    pwk,&lwork,&rwkopt,&lrwork,&iwkopt,&liwork,&info,1,1,1);
+#else
+    F77NAME(zheevr)(&jobz,&range,&uplo,&N,pA,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,pZ,&N,isuppz.data(),
+                    pwk,&lwork,&rwkopt,&lrwork,&iwkopt,&liwork,&info);
+#endif
+    lwork = LAPACK_INT(wkopt.real());
+    lrwork = LAPACK_INT(rwkopt);
+    liwork = iwkopt;
+    auto work = ScratchBuf<Cplx>(lwork);
+    auto pw = reinterpret_cast<LAPACK_COMPLEX*>(work.data());
+    auto rwork = ScratchBuf<LAPACK_REAL>(lrwork);
+    std::vector<LAPACK_INT> iwork(liwork);
+#ifdef PLATFORM_acml
+    F77NAME(zheevr)(&jobz,&range,&uplo,&N,pA,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,pZ,&N,isuppz.data(),
+                    pw,&lwork,rwork.data(),&lrwork,iwork.data(),&liwork,&info,1,1,1);
+#else
+    F77NAME(zheevr)(&jobz,&range,&uplo,&N,pA,&N,&vl,&vu,&il,&iu,&abstol,&nfound,w,pZ,&N,isuppz.data(),
+                    pw,&lwork,rwork.data(),&lrwork,iwork.data(),&liwork,&info);
+#endif
+    return info;
+    }
+
 //
 // dscal
 //
@@ -359,15 +546,13 @@ zgesdd_wrapper(char *jobz,           //char* specifying how much of U, V to comp
                LAPACK_COMPLEX *vt,   //on return, unitary matrix V transpose
                LAPACK_INT *info)
     {
-    std::vector<LAPACK_COMPLEX> work;
-    std::vector<LAPACK_REAL> rwork;
-    std::vector<LAPACK_INT> iwork;
+    COUNT_OPS(DecompOp,4*svdFlops(*m,*n),svdBytes<Cplx>(*m,*n))
     LAPACK_INT l = std::min(*m,*n),
                g = std::max(*m,*n);
     LAPACK_INT lwork = l*l+2*l+g+100;
-    work.resize(lwork);
-    rwork.resize(5*l*(1+l));
-    iwork.resize(8*l);
+    auto work = ScratchBuf<LAPACK_COMPLEX>(lwork);
+    auto rwork = ScratchBuf<LAPACK_REAL>(l*std::max(5*l+7,2*g+2*l+1));
+    std::vector<LAPACK_INT> iwork(8*l);
 #ifdef PLATFORM_acml
     LAPACK_INT jobz_len = 1;
     F77NAME(zgesdd)(jobz,m,n,A,m,s,u,m,vt,n,work.data(),&lwork,rwork.data(),iwork.data(),info,jobz_len);
@@ -376,6 +561,146 @@ zgesdd_wrapper(char *jobz,           //char* specifying how much of U, V to comp
 #endif
     }
 
+LAPACK_INT
+gesdd_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Real* A,
+              Real* s,
+              Real* u,
+              Real* vt)
+    {
+    COUNT_OPS(DecompOp,svdFlops(m,n),svdBytes<Real>(m,n))
+    char jobz = 'S';
+    LAPACK_INT l = std::min(m,n);
+    LAPACK_INT ldvt = std::max(l,1);
+    std::vector<LAPACK_INT> iwork(8*l);
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    LAPACK_REAL wkopt = 0;
+#ifdef PLATFORM_acml
+    LAPACK_INT jobz_len = 1;
+    F77NAME(dgesdd)(&jobz,&m,&n,A,&m,s,u,&m,vt,&ldvt,&wkopt,&lwork,iwork.data(),&info,jobz_len);
+#else
+    F77NAME(dgesdd)(&jobz,&m,&n,A,&m,s,u,&m,vt,&ldvt,&wkopt,&lwork,iwork.data(),&info);
+#endif
+    lwork = LAPACK_INT(wkopt);
+    auto work = ScratchBuf<LAPACK_REAL>(lwork);
+#ifdef PLATFORM_acml
+    F77NAME(dgesdd)(&jobz,&m,&n,A,&m,s,u,&m,vt,&ldvt,work.data(),&lwork,iwork.data(),&info,jobz_len);
+#else
+    F77NAME(dgesdd)(&jobz,&m,&n,A,&m,s,u,&m,vt,&ldvt,work.data(),&lwork,iwork.data(),&info);
+#endif
+    return info;
+    }
+
+LAPACK_INT
+gesdd_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Cplx* A,
+              Real* s,
+              Cplx* u,
+              Cplx* vt)
+    {
+    static_assert(sizeof(LAPACK_COMPLEX)==sizeof(Cplx),"LAPACK_COMPLEX and itensor::Cplx have different size");
+    COUNT_OPS(DecompOp,4*svdFlops(m,n),svdBytes<Cplx>(m,n))
+    char jobz = 'S';
+    LAPACK_INT l = std::min(m,n),
+               g = std::max(m,n);
+    LAPACK_INT ldvt = std::max(l,1);
+    auto pA = reinterpret_cast<LAPACK_COMPLEX*>(A);
+    auto pu = reinterpret_cast<LAPACK_COMPLEX*>(u);
+    auto pvt = reinterpret_cast<LAPACK_COMPLEX*>(vt);
+    auto rwork = ScratchBuf<LAPACK_REAL>(std::max(1,l*std::max(5*l+7,2*g+2*l+1)));
+    std::vector<LAPACK_INT> iwork(8*l);
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    Cplx wkopt = 0;
+    auto pwk = reinterpret_cast<LAPACK_COMPLEX*>(&wkopt);
+#ifdef PLATFORM_acml
+    LAPACK_INT jobz_len = 1;
+    F77NAME(zgesdd)(&jobz,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pwk,&lwork,rwork.data(),iwork.data(),&info,jobz_len);
+#else
+    F77NAME(zgesdd)(&jobz,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pwk,&lwork,rwork.data(),iwork.data(),&info);
+#endif
+    lwork = LAPACK_INT(wkopt.real());
+    auto work = ScratchBuf<Cplx>(lwork);
+    auto pw = reinterpret_cast<LAPACK_COMPLEX*>(work.data());
+#ifdef PLATFORM_acml
+    F77NAME(zgesdd)(&jobz,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pw,&lwork,rwork.data(),iwork.data(),&info,jobz_len);
+#else
+    F77NAME(zgesdd)(&jobz,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pw,&lwork,rwork.data(),iwork.data(),&info);
+#endif
+    return info;
+    }
+
+LAPACK_INT
+gesvd_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Real* A,
+              Real* s,
+              Real* u,
+              Real* vt)
+    {
+    COUNT_OPS(DecompOp,svdFlops(m,n),svdBytes<Real>(m,n))
+    char job = 'S';
+    LAPACK_INT l = std::min(m,n);
+    LAPACK_INT ldvt = std::max(l,1);
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    LAPACK_REAL wkopt = 0;
+#ifdef PLATFORM_acml
+    LAPACK_INT job_len = 1;
+    F77NAME(dgesvd)(&job,&job,&m,&n,A,&m,s,u,&m,vt,&ldvt,&wkopt,&lwork,&info,job_len,job_len);
+#else
+    F77NAME(dgesvd)(&job,&job,&m,&n,A,&m,s,u,&m,vt,&ldvt,&wkopt,&lwork,&info);
+#endif
+    lwork = LAPACK_INT(wkopt);
+    auto work = ScratchBuf<LAPACK_REAL>(lwork);
+#ifdef PLATFORM_acml
+    F77NAME(dgesvd)(&job,&job,&m,&n,A,&m,s,u,&m,vt,&ldvt,work.data(),&lwork,&info,job_len,job_len);
+#else
+    F77NAME(dgesvd)(&job,&job,&m,&n,A,&m,s,u,&m,vt,&ldvt,work.data(),&lwork,&info);
+#endif
+    return info;
+    }
+
+LAPACK_INT
+gesvd_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Cplx* A,
+              Real* s,
+              Cplx* u,
+              Cplx* vt)
+    {
+    COUNT_OPS(DecompOp,4*svdFlops(m,n),svdBytes<Cplx>(m,n))
+    char job = 'S';
+    LAPACK_INT l = std::min(m,n);
+    LAPACK_INT ldvt = std::max(l,1);
+    auto pA = reinterpret_cast<LAPACK_COMPLEX*>(A);
+    auto pu = reinterpret_cast<LAPACK_COMPLEX*>(u);
+    auto pvt = reinterpret_cast<LAPACK_COMPLEX*>(vt);
+    auto rwork = ScratchBuf<LAPACK_REAL>(std::max(1,5*l));
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    Cplx wkopt = 0;
+    auto pwk = reinterpret_cast<LAPACK_COMPLEX*>(&wkopt);
+#ifdef PLATFORM_acml
+    LAPACK_INT job_len = 1;
+    F77NAME(zgesvd)(&job,&job,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pwk,&lwork,rwork.data(),&info,job_len,job_len);
+#else
+    F77NAME(zgesvd)(&job,&job,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pwk,&lwork,rwork.data(),&info);
+#endif
+    lwork = LAPACK_INT(wkopt.real());
+    auto work = ScratchBuf<Cplx>(lwork);
+    auto pw = reinterpret_cast<LAPACK_COMPLEX*>(work.data());
+#ifdef PLATFORM_acml
+    F77NAME(zgesvd)(&job,&job,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pw,&lwork,rwork.data(),&info,job_len,job_len);
+#else
+    F77NAME(zgesvd)(&job,&job,&m,&n,pA,&m,s,pu,&m,pvt,&ldvt,pw,&lwork,rwork.data(),&info);
+#endif
+    return info;
+    }
+
 //
 // dgeqrf
 //
@@ -391,9 +716,8 @@ dgeqrf_wrapper(LAPACK_INT* m,     //number of rows of A
                                   //length should be min(m,n)
                LAPACK_INT* info)  //error info
     {
-    std::vector<LAPACK_REAL> work;
     int lwork = std::max(1,4*std::max(*n,*m));
-    work.resize(lwork+2); 
+    auto work = ScratchBuf<LAPACK_REAL>(lwork+2); 
     F77NAME(dgeqrf)(m,n,A,lda,tau,work.data(),&lwork,info);
     }
 
@@ -412,12 +736,88 @@ dorgqr_wrapper(LAPACK_INT* m,     //number of rows of A
                LAPACK_REAL* tau,  //scalar factors as returned by dgeqrf
                LAPACK_INT* info)  //error info
     {
-    std::vector<LAPACK_REAL> work;
     auto lwork = std::max(1,4*std::max(*n,*m));
-    work.resize(lwork+2); 
+    auto work = ScratchBuf<LAPACK_REAL>(lwork+2); 
     F77NAME(dorgqr)(m,n,k,A,lda,tau,work.data(),&lwork,info);
     }
 
+LAPACK_INT
+geqrf_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Real* A,
+              Real* tau)
+    {
+    LAPACK_INT lda = std::max(m,1);
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    LAPACK_REAL wkopt = 0;
+    F77NAME(dgeqrf)(&m,&n,A,&lda,tau,&wkopt,&lwork,&info);
+    lwork = std::max(1,LAPACK_INT(wkopt));
+    auto work = ScratchBuf<LAPACK_REAL>(lwork);
+    F77NAME(dgeqrf)(&m,&n,A,&lda,tau,work.data(),&lwork,&info);
+    return info;
+    }
+
+LAPACK_INT
+geqrf_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Cplx* A,
+              Cplx* tau)
+    {
+    static_assert(sizeof(LAPACK_COMPLEX)==sizeof(Cplx),"LAPACK_COMPLEX and itensor::Cplx have different size");
+    auto pA = reinterpret_cast<LAPACK_COMPLEX*>(A);
+    auto ptau = reinterpret_cast<LAPACK_COMPLEX*>(tau);
+    LAPACK_INT lda = std::max(m,1);
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    Cplx wkopt = 0;
+    F77NAME(zgeqrf)(&m,&n,pA,&lda,ptau,reinterpret_cast<LAPACK_COMPLEX*>(&wkopt),&lwork,&info);
+    lwork = std::max(1,LAPACK_INT(wkopt.real()));
+    auto work = ScratchBuf<Cplx>(lwork);
+    auto pw = reinterpret_cast<LAPACK_COMPLEX*>(work.data());
+    F77NAME(zgeqrf)(&m,&n,pA,&lda,ptau,pw,&lwork,&info);
+    return info;
+    }
+
+LAPACK_INT
+orgqr_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              LAPACK_INT k,
+              Real* A,
+              Real* tau)
+    {
+    LAPACK_INT lda = std::max(m,1);
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    LAPACK_REAL wkopt = 0;
+    F77NAME(dorgqr)(&m,&n,&k,A,&lda,tau,&wkopt,&lwork,&info);
+    lwork = std::max(1,LAPACK_INT(wkopt));
+    auto work = ScratchBuf<LAPACK_REAL>(lwork);
+    F77NAME(dorgqr)(&m,&n,&k,A,&lda,tau,work.data(),&lwork,&info);
+    return info;
+    }
+
+LAPACK_INT
+orgqr_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              LAPACK_INT k,
+              Cplx* A,
+              Cplx* tau)
+    {
+    auto pA = reinterpret_cast<LAPACK_COMPLEX*>(A);
+    auto ptau = reinterpret_cast<LAPACK_COMPLEX*>(tau);
+    LAPACK_INT lda = std::max(m,1);
+    LAPACK_INT info = 0;
+    LAPACK_INT lwork = -1; //workspace query
+    Cplx wkopt = 0;
+    F77NAME(zungqr)(&m,&n,&k,pA,&lda,ptau,reinterpret_cast<LAPACK_COMPLEX*>(&wkopt),&lwork,&info);
+    lwork = std::max(1,LAPACK_INT(wkopt.real()));
+    auto work = ScratchBuf<Cplx>(lwork);
+    auto pw = reinterpret_cast<LAPACK_COMPLEX*>(work.data());
+    F77NAME(zungqr)(&m,&n,&k,pA,&lda,ptau,pw,&lwork,&info);
+    return info;
+    }
+
 //
 // zheev
 //
@@ -428,6 +828,7 @@ zheev_wrapper(LAPACK_INT      N,  //number of cols of A
               Cplx          * A,  //matrix A, on return contains eigenvectors
               LAPACK_REAL   * d)  //eigenvalues on return
     {
+    COUNT_OPS(DecompOp,4*eigFlops(N,N),eigBytes<Cplx>(N,N))
     char jobz = 'V';
     char uplo = 'U';
 #ifdef PLATFORM_lapacke
@@ -435,8 +836,8 @@ zheev_wrapper(LAPACK_INT      N,  //number of cols of A
     LAPACKE_zheev(LAPACK_COL_MAJOR,jobz,uplo,N,A,N,w.data());
 #else
     LAPACK_INT lwork = std::max(1,3*N-1);//max(1, 1+6*N+2*N*N);
-    std::vector<LAPACK_COMPLEX> work(lwork);
-    std::vector<LAPACK_REAL> rwork(lwork);
+    auto work = ScratchBuf<LAPACK_COMPLEX>(lwork);
+    auto rwork = ScratchBuf<LAPACK_REAL>(lwork);
     LAPACK_INT info = 0;
     static_assert(sizeof(LAPACK_COMPLEX)==sizeof(Cplx),"LAPACK_COMPLEX and itensor::Cplx have different size");
     auto pA = reinterpret_cast<LAPACK_COMPLEX*>(A);
@@ -499,6 +900,7 @@ dgeev_wrapper(char jobvl,          //if 'V', compute left eigenvectors, else 'N'
               LAPACK_REAL* vl,      //left eigenvectors on return
               LAPACK_REAL* vr)      //right eigenvectors on return
     {
+    COUNT_OPS(DecompOp,geevFlops(n),sizeof(LAPACK_REAL)*(3.*n*n+2.*n))
     std::vector<LAPACK_REAL> work;
     std::vector<LAPACK_REAL> cpA;
 
@@ -557,6 +959,7 @@ zgeev_wrapper(char jobvl,          //if 'V', compute left eigenvectors, else 'N'
               Cplx * vl,   //left eigenvectors on return
               Cplx * vr)   //right eigenvectors on return
     {
+    COUNT_OPS(DecompOp,4*geevFlops(n),sizeof(Cplx)*(3.*n*n+n))
     std::vector<LAPACK_COMPLEX> cpA;
     std::vector<LAPACK_COMPLEX> work;
     std::vector<LAPACK_REAL> rwork;
@@ -8,7 +8,7 @@
 #include <vector>
 #include "itensor/config.h"
 #include "itensor/types.h"
-#include "itensor/util/timers.h"
+#include "itensor/util/profiler.h"
 
 //
 // Headers and typedefs
@@ -22,6 +22,7 @@
 #ifdef PLATFORM_lapack
 
 #define LAPACK_REQUIRE_EXTERN
+#define ITENSOR_USE_ZGEMM
 
 namespace itensor {
     using LAPACK_INT = int;
@@ -34,6 +35,9 @@ namespace itensor {
 #elif defined PLATFORM_openblas
 
 #define ITENSOR_USE_CBLAS
+#define ITENSOR_USE_ZGEMM
+//Define ITENSOR_USE_ZGEMM3M (e.g. in options.mk) 
+//if your OpenBLAS build provides cblas_zgemm3m
 
 #include "cblas.h"
 #include "lapacke.h"
@@ -92,6 +96,7 @@ imagRef(LAPACK_COMPLEX & z)
 
 #define ITENSOR_USE_CBLAS
 #define ITENSOR_USE_ZGEMM
+#define ITENSOR_USE_ZGEMM3M
 
 #include "mkl_cblas.h"
 #include "mkl_lapack.h"
@@ -115,6 +120,7 @@ imagRef(LAPACK_COMPLEX & z)
 #elif defined PLATFORM_acml
 
 #define LAPACK_REQUIRE_EXTERN
+#define ITENSOR_USE_ZGEMM
 //#include "acml.h"
     namespace itensor {
     using LAPACK_INT = int;
@@ -280,6 +286,29 @@ void F77NAME(dsyev)(const char* jobz, const char* uplo, const LAPACK_INT* n, dou
             LAPACK_INT* info );
 #endif
 
+#ifdef PLATFORM_acml
+void F77NAME(dsyevd)(char *jobz, char *uplo, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
+             double *w, double *work, LAPACK_INT *lwork, LAPACK_INT *iwork, LAPACK_INT *liwork, 
+             LAPACK_INT *info, LAPACK_INT jobz_len, LAPACK_INT uplo_len);
+#else
+void F77NAME(dsyevd)(char *jobz, char *uplo, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
+             double *w, double *work, LAPACK_INT *lwork, LAPACK_INT *iwork, LAPACK_INT *liwork, 
+             LAPACK_INT *info);
+#endif
+
+#ifdef PLATFORM_acml
+void F77NAME(dsyevr)(char *jobz, char *range, char *uplo, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
+             double *vl, double *vu, LAPACK_INT *il, LAPACK_INT *iu, double *abstol, 
+             LAPACK_INT *m, double *w, double *z, LAPACK_INT *ldz, LAPACK_INT *isuppz, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *iwork, LAPACK_INT *liwork, LAPACK_INT *info,
+             LAPACK_INT jobz_len, LAPACK_INT range_len, LAPACK_INT uplo_len);
+#else
+void F77NAME(dsyevr)(char *jobz, char *range, char *uplo, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
+             double *vl, double *vu, LAPACK_INT *il, LAPACK_INT *iu, double *abstol, 
+             LAPACK_INT *m, double *w, double *z, LAPACK_INT *ldz, LAPACK_INT *isuppz, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *iwork, LAPACK_INT *liwork, LAPACK_INT *info);
+#endif
+
 #ifdef ITENSOR_USE_CBLAS
 void cblas_dscal(const LAPACK_INT N, const LAPACK_REAL alpha, LAPACK_REAL* X,const LAPACK_INT incX);
 #else
@@ -297,6 +326,39 @@ void F77NAME(zgesdd)(char *jobz, LAPACK_INT *m, LAPACK_INT *n, LAPACK_COMPLEX *a
              LAPACK_COMPLEX *work, LAPACK_INT *lwork, double *rwork, LAPACK_INT *iwork, LAPACK_INT *info);
 #endif
 
+#ifdef PLATFORM_acml
+void F77NAME(dgesdd)(char *jobz, LAPACK_INT *m, LAPACK_INT *n, double *a, LAPACK_INT *lda, double *s, 
+             double *u, LAPACK_INT *ldu, double *vt, LAPACK_INT *ldvt, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *iwork, LAPACK_INT *info, 
+             LAPACK_INT jobz_len);
+#else
+void F77NAME(dgesdd)(char *jobz, LAPACK_INT *m, LAPACK_INT *n, double *a, LAPACK_INT *lda, double *s, 
+             double *u, LAPACK_INT *ldu, double *vt, LAPACK_INT *ldvt, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *iwork, LAPACK_INT *info);
+#endif
+
+#ifdef PLATFORM_acml
+void F77NAME(dgesvd)(char *jobu, char *jobvt, LAPACK_INT *m, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
+             double *s, double *u, LAPACK_INT *ldu, double *vt, LAPACK_INT *ldvt, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *info, 
+             LAPACK_INT jobu_len, LAPACK_INT jobvt_len);
+#else
+void F77NAME(dgesvd)(char *jobu, char *jobvt, LAPACK_INT *m, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
+             double *s, double *u, LAPACK_INT *ldu, double *vt, LAPACK_INT *ldvt, 
+             double *work, LAPACK_INT *lwork, LAPACK_INT *info);
+#endif
+
+#ifdef PLATFORM_acml
+void F77NAME(zgesvd)(char *jobu, char *jobvt, LAPACK_INT *m, LAPACK_INT *n, LAPACK_COMPLEX *a, LAPACK_INT *lda, 
+             double *s, LAPACK_COMPLEX *u, LAPACK_INT *ldu, LAPACK_COMPLEX *vt, LAPACK_INT *ldvt, 
+             LAPACK_COMPLEX *work, LAPACK_INT *lwork, double *rwork, LAPACK_INT *info, 
+             LAPACK_INT jobu_len, LAPACK_INT jobvt_len);
+#else
+void F77NAME(zgesvd)(char *jobu, char *jobvt, LAPACK_INT *m, LAPACK_INT *n, LAPACK_COMPLEX *a, LAPACK_INT *lda, 
+             double *s, LAPACK_COMPLEX *u, LAPACK_INT *ldu, LAPACK_COMPLEX *vt, LAPACK_INT *ldvt, 
+             LAPACK_COMPLEX *work, LAPACK_INT *lwork, double *rwork, LAPACK_INT *info);
+#endif
+
 void F77NAME(dgeqrf)(LAPACK_INT *m, LAPACK_INT *n, double *a, LAPACK_INT *lda, 
                      double *tau, double *work, LAPACK_INT *lwork, LAPACK_INT *info);
 
@@ -304,6 +366,13 @@ void F77NAME(dorgqr)(LAPACK_INT *m, LAPACK_INT *n, LAPACK_INT *k, double *a,
                      LAPACK_INT *lda, double *tau, double *work, LAPACK_INT *lwork, 
                      LAPACK_INT *info);
 
+void F77NAME(zgeqrf)(LAPACK_INT *m, LAPACK_INT *n, LAPACK_COMPLEX *a, LAPACK_INT *lda, 
+                     LAPACK_COMPLEX *tau, LAPACK_COMPLEX *work, LAPACK_INT *lwork, LAPACK_INT *info);
+
+void F77NAME(zungqr)(LAPACK_INT *m, LAPACK_INT *n, LAPACK_INT *k, LAPACK_COMPLEX *a, 
+                     LAPACK_INT *lda, LAPACK_COMPLEX *tau, LAPACK_COMPLEX *work, LAPACK_INT *lwork, 
+                     LAPACK_INT *info);
+
 #ifdef PLATFORM_lapacke
 lapack_int LAPACKE_zheev(int matrix_order, char jobz, char uplo, lapack_int n,
                          lapack_complex_double* a, lapack_int lda, double* w);
@@ -317,6 +386,20 @@ void F77NAME(zheev)(char *jobz, char *uplo, LAPACK_INT *n, LAPACK_COMPLEX *a, LA
            LAPACK_INT *info);
 #endif
 
+#ifdef PLATFORM_acml
+void F77NAME(zheevr)(char *jobz, char *range, char *uplo, LAPACK_INT *n, LAPACK_COMPLEX *a, LAPACK_INT *lda, 
+             double *vl, double *vu, LAPACK_INT *il, LAPACK_INT *iu, double *abstol, 
+             LAPACK_INT *m, double *w, LAPACK_COMPLEX *z, LAPACK_INT *ldz, LAPACK_INT *isuppz, 
+             LAPACK_COMPLEX *work, LAPACK_INT *lwork, double *rwork, LAPACK_INT *lrwork, 
+             LAPACK_INT *iwork, LAPACK_INT *liwork, LAPACK_INT *info,
+             LAPACK_INT jobz_len, LAPACK_INT range_len, LAPACK_INT uplo_len);
+#else
+void F77NAME(zheevr)(char *jobz, char *range, char *uplo, LAPACK_INT *n, LAPACK_COMPLEX *a, LAPACK_INT *lda, 
+             double *vl, double *vu, LAPACK_INT *il, LAPACK_INT *iu, double *abstol, 
+             LAPACK_INT *m, double *w, LAPACK_COMPLEX *z, LAPACK_INT *ldz, LAPACK_INT *isuppz, 
+             LAPACK_COMPLEX *work, LAPACK_INT *lwork, double *rwork, LAPACK_INT *lrwork, 
+             LAPACK_INT *iwork, LAPACK_INT *liwork, LAPACK_INT *info);
+#endif
 
 #ifdef PLATFORM_acml
 void F77NAME(dsygv)(LAPACK_INT *itype, char *jobz, char *uplo, LAPACK_INT *n, double *a, 
@@ -417,6 +500,10 @@ gemm_wrapper(bool transa,
 //
 // zgemm
 //
+// If ITENSOR_USE_ZGEMM3M is defined (default for MKL)
+// calls zgemm3m instead, which does 3 real multiplies
+// per complex product instead of 4
+//
 void
 gemm_wrapper(bool transa, 
              bool transb,
@@ -471,6 +558,55 @@ dsyev_wrapper(char jobz,        //if jobz=='V', compute eigs and evecs
               LAPACK_REAL* eigs, //eigenvalues on return
               LAPACK_INT& info);  //error info
 
+//
+// dsyevd
+//
+// Eigenvalues and eigenvectors of a real symmetric matrix A
+// by the divide-and-conquer method (faster than dsyev
+// when the eigenvectors are needed)
+//
+LAPACK_INT
+dsyevd_wrapper(LAPACK_INT N,        //number of cols of A
+               LAPACK_REAL* A,      //matrix A, on return contains eigenvectors
+               LAPACK_REAL* eigs);  //eigenvalues on return, ascending
+
+//
+// syevr
+//
+// Selected eigenvalues and eigenvectors of a real symmetric
+// (dsyevr) or complex Hermitian (zheevr) matrix A by the
+// MRRR method, which only pays for the eigenpairs requested:
+// o range=='A': all eigenvalues
+// o range=='V': eigenvalues in the half-open interval (vl,vu]
+// o range=='I': the il-th through iu-th eigenvalues (1-based, ascending)
+// The number found is returned in nfound, with the eigenvalues
+// in ascending order in w (of size N) and the eigenvectors in
+// the columns of Z (of size N*N, or N*(iu-il+1) if range=='I').
+// A is overwritten. Returns the LAPACK info code.
+//
+LAPACK_INT
+syevr_wrapper(char range,
+              LAPACK_INT N,
+              Real* A,
+              Real vl,
+              Real vu,
+              LAPACK_INT il,
+              LAPACK_INT iu,
+              LAPACK_INT & nfound,
+              Real* w,
+              Real* Z);
+LAPACK_INT
+syevr_wrapper(char range,
+              LAPACK_INT N,
+              Cplx* A,
+              Real vl,
+              Real vu,
+              LAPACK_INT il,
+              LAPACK_INT iu,
+              LAPACK_INT & nfound,
+              Real* w,
+              Cplx* Z);
+
 //
 // dscal
 //
@@ -491,6 +627,51 @@ zgesdd_wrapper(char *jobz,           //char* specifying how much of U, V to comp
                LAPACK_COMPLEX *vt,   //on return, unitary matrix V transpose
                LAPACK_INT *info);
 
+//
+// gesdd
+//
+// Singular value decomposition A = U*diag(s)*V^dag by the
+// divide-and-conquer method (LAPACK dgesdd or zgesdd).
+// Computes the first min(m,n) columns of U and rows of V^dag.
+// A is overwritten. Returns the LAPACK info code.
+//
+LAPACK_INT
+gesdd_wrapper(LAPACK_INT m,    //number of rows of A
+              LAPACK_INT n,    //number of cols of A
+              Real* A,         //m x n matrix, column-major
+              Real* s,         //on return, the min(m,n) singular values
+              Real* u,         //on return, m x min(m,n) matrix U
+              Real* vt);       //on return, min(m,n) x n matrix V^dag
+LAPACK_INT
+gesdd_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Cplx* A,
+              Real* s,
+              Cplx* u,
+              Cplx* vt);
+
+//
+// gesvd
+//
+// Same as gesdd_wrapper but using the QR-iteration
+// based LAPACK dgesvd or zgesvd, which is slower but
+// more robust
+//
+LAPACK_INT
+gesvd_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Real* A,
+              Real* s,
+              Real* u,
+              Real* vt);
+LAPACK_INT
+gesvd_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Cplx* A,
+              Real* s,
+              Cplx* u,
+              Cplx* vt);
+
 //
 // dgeqrf
 //
@@ -521,6 +702,46 @@ dorgqr_wrapper(LAPACK_INT* m,     //number of rows of A
                LAPACK_REAL* tau,  //scalar factors as returned by dgeqrf
                LAPACK_INT* info);  //error info
 
+//
+// geqrf
+//
+// QR factorization A = Q*R of an m x n matrix A
+// (LAPACK dgeqrf or zgeqrf). On return the upper triangle
+// of A contains R; the rest of A together with the
+// min(m,n) scalars tau represent Q.
+// Returns the LAPACK info code.
+//
+LAPACK_INT
+geqrf_wrapper(LAPACK_INT m,    //number of rows of A
+              LAPACK_INT n,    //number of cols of A
+              Real* A,         //m x n matrix, column-major
+              Real* tau);      //on return, min(m,n) scalar factors of Q
+LAPACK_INT
+geqrf_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              Cplx* A,
+              Cplx* tau);
+
+//
+// orgqr
+//
+// Overwrites A, as returned by geqrf_wrapper, with the
+// first n columns of Q (LAPACK dorgqr or zungqr).
+// Returns the LAPACK info code.
+//
+LAPACK_INT
+orgqr_wrapper(LAPACK_INT m,    //number of rows of A
+              LAPACK_INT n,    //number of columns of Q to compute, n <= m
+              LAPACK_INT k,    //number of scalar factors tau, k <= n
+              Real* A,         //m x n matrix from geqrf_wrapper
+              Real* tau);      //scalar factors from geqrf_wrapper
+LAPACK_INT
+orgqr_wrapper(LAPACK_INT m,
+              LAPACK_INT n,
+              LAPACK_INT k,
+              Cplx* A,
+              Cplx* tau);
+
 //
 // zheev
 //
@@ -4,7 +4,7 @@
 //
 #include <limits>
 #include "itensor/util/range.h"
-#include "itensor/util/timers.h"
+#include "itensor/util/profiler.h"
 #include "itensor/tensor/lapack_wrap.h"
 #include "itensor/tensor/mat.h"
 #include "itensor/tensor/slicemat.h"
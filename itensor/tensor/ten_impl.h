@@ -93,6 +93,43 @@ checkCompatible(TenRefc<R1,T1> const& A,
             }
     }
 
+namespace detail {
+
+//Edge length of the square tiles used by
+//transform when the fastest-moving indices
+//of "from" and "to" differ (a transpose)
+constexpr size_t transform_tile = 32;
+
+//Minimum extent of an index for it to be 
+//worth running the inner loop over
+constexpr size_t transform_minext = 4;
+
+//Without tiling, a line of "from" read in the
+//inner loop is only reused after reading about
+//this many other lines; beyond this number they
+//no longer stay cached and tiling pays off
+//(threshold measured with benchmark/permute)
+constexpr size_t transform_tile_reuse = 2048;
+
+//Index with the smallest stride among those
+//with extent > 1 (i.e. the fastest-moving one)
+template<typename TenRefType>
+size_t
+fastestIndex(TenRefType const& t)
+    {
+    size_t ind = 0;
+    auto found = false;
+    for(decltype(t.r()) j = 0; j < t.r(); ++j)
+        {
+        if(t.extent(j) <= 1) continue;
+        if(!found || t.stride(j) < t.stride(ind)) ind = j;
+        found = true;
+        }
+    return ind;
+    }
+
+} //namespace detail
+
 template<typename R1, typename T1, 
          typename R2, typename T2, 
          typename Op>
@@ -112,7 +149,71 @@ transform(TenRefc<R1,T1> const& from,
         return;
         }
 
-    //find size and location of largest index of from
+    //Find fastest-moving index of "to" and "from"
+    //(these differ when transform is a permutation)
+    size_type toind = detail::fastestIndex(to),
+              fromind = detail::fastestIndex(from);
+
+    //Number of lines of "from" read by the untiled 
+    //loop below before a line is reused
+    size_type reuse = 0;
+    if(toind != fromind)
+        {
+        reuse = to.extent(toind);
+        for(decltype(r) j = 0; j < fromind; ++j)
+            {
+            if(j != toind) reuse *= to.extent(j);
+            }
+        }
+
+    if(toind != fromind 
+       && reuse >= detail::transform_tile_reuse
+       && to.extent(fromind) >= detail::transform_minext)
+        {
+        //Tiled transpose over toind and fromind, so that
+        //both reads and writes stay within a few
+        //cache lines for each tile
+        auto nt = to.extent(toind),
+             nf = to.extent(fromind);
+        auto tstepto = to.stride(toind),
+             tstepfrom = from.stride(toind),
+             fstepto = to.stride(fromind),
+             fstepfrom = from.stride(fromind);
+
+        auto RB = RangeBuilder(r);
+        for(decltype(r) i = 0; i < r; ++i)
+            RB.setIndex(i,from.extent(i));
+        RB.setIndex(toind,1);
+        RB.setIndex(fromind,1);
+
+        constexpr size_type tile = detail::transform_tile;
+        for(auto& i : RB.build())
+            {
+            auto pto = MAKE_SAFE_PTR_OFFSET(to.data(),offset(to,i),to.store().size());
+            auto pfrom = MAKE_SAFE_PTR_OFFSET(from.data(),offset(from,i),from.store().size());
+            for(size_type fb = 0; fb < nf; fb += tile)
+            for(size_type tb = 0; tb < nt; tb += tile)
+                {
+                auto fe = std::min(fb+tile,nf),
+                     te = std::min(tb+tile,nt);
+                for(auto f = fb; f < fe; ++f)
+                    {
+                    auto pt = pto+(f*fstepto+tb*tstepto);
+                    auto pf = pfrom+(f*fstepfrom+tb*tstepfrom);
+                    for(auto t = tb; t < te; ++t)
+                        {
+                        op(*pf,*pt);
+                        pt += tstepto;
+                        pf += tstepfrom;
+                        }
+                    }
+                }
+            }
+        return;
+        }
+
+    //Run inner loop over fastest-moving index if shared
+    //by "to" and "from", otherwise over the largest index
     size_type bigind = 0, 
               bigsize = from.extent(0);
     for(decltype(r) j = 1; j < r; ++j)
@@ -121,6 +222,11 @@ transform(TenRefc<R1,T1> const& from,
             bigsize = from.extent(j); 
             bigind = j;
             }
+    if(toind == fromind && from.extent(toind) >= detail::transform_minext)
+        {
+        bigind = toind;
+        bigsize = from.extent(toind);
+        }
 
     auto stepfrom = from.stride(bigind);
     auto stepto = to.stride(bigind);
@@ -134,16 +240,24 @@ transform(TenRefc<R1,T1> const& from,
 
     for(auto& i : RB.build())
         {
-        //println("i = ",i);
-        //printfln("to (offset,size) = (%d,%d)",offset(to,i),to.store().size());
-        //printfln("from (offset,size) = (%d,%d)",offset(from,i),from.store().size());
         auto pto = MAKE_SAFE_PTR_OFFSET(to.data(),offset(to,i),to.store().size());
         auto pfrom = MAKE_SAFE_PTR_OFFSET(from.data(),offset(from,i),from.store().size());
-        for(decltype(bigsize) b = 0; b < bigsize; ++b)
+        if(stepto == 1 && stepfrom == 1)
             {
-            op(*pfrom,*pto);
-            pto += stepto;
-            pfrom += stepfrom;
+            //Unit-stride loop, which the compiler can vectorize
+            for(decltype(bigsize) b = 0; b < bigsize; ++b)
+                {
+                op(pfrom[b],pto[b]);
+                }
+            }
+        else
+            {
+            for(decltype(bigsize) b = 0; b < bigsize; ++b)
+                {
+                op(*pfrom,*pto);
+                pto += stepto;
+                pfrom += stepfrom;
+                }
             }
         }
     }
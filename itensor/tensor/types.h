@@ -9,7 +9,7 @@
 #include <iostream>
 #include "itensor/util/infarray.h"
 #include "itensor/util/vararray.h"
-#include "itensor/util/timers.h"
+#include "itensor/util/profiler.h"
 #include "itensor/types.h"
 
 namespace itensor {
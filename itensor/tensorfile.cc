@@ -0,0 +1,616 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include <cstdio>
+#include <cstring>
+#include "itensor/tensorfile.h"
+#include "itensor/util/print.h"
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace itensor {
+
+using std::string;
+using std::vector;
+using std::move;
+using offset_type = TensorFileWriter::offset_type;
+
+namespace {
+
+char const tf_magic[8] = {'I','T','E','N','S','O','R','F'};
+offset_type const tf_align = 64;
+
+struct TensorFileHeader
+    {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t reserved;
+    offset_type table_offset;
+    offset_type table_size;
+    char pad[32];
+    };
+static_assert(sizeof(TensorFileHeader) == tf_align,"TensorFileHeader must be 64 bytes");
+
+//
+// Storage is written as metadata (stored in the
+// table) plus its element data (stored as a raw,
+// aligned block), if any
+//
+
+struct StoreParts
+    {
+    string meta;
+    char const* data = nullptr;
+    offset_type size = 0;
+    };
+
+struct GetStoreParts { };
+
+const char*
+typeNameOf(GetStoreParts const&) { return "GetStoreParts"; }
+
+template<typename V>
+StoreParts
+makeParts(std::ostringstream const& meta, vector<V> const& store)
+    {
+    auto p = StoreParts{};
+    p.meta = meta.str();
+    p.data = reinterpret_cast<char const*>(store.data());
+    p.size = sizeof(V)*store.size();
+    return p;
+    }
+
+template<typename T>
+StoreParts
+doTask(GetStoreParts, Dense<T> const& d)
+    {
+    std::ostringstream meta;
+    return makeParts(meta,d.store);
+    }
+
+template<typename T>
+StoreParts
+doTask(GetStoreParts, Diag<T> const& d)
+    {
+    std::ostringstream meta;
+    itensor::write(meta,d.val);
+    itensor::write(meta,d.length);
+    return makeParts(meta,d.store);
+    }
+
+template<typename T>
+StoreParts
+doTask(GetStoreParts, QDense<T> const& d)
+    {
+    std::ostringstream meta;
+    itensor::write(meta,d.offsets);
+    return makeParts(meta,d.store);
+    }
+
+template<typename T>
+StoreParts
+doTask(GetStoreParts, QDiag<T> const& d)
+    {
+    std::ostringstream meta;
+    itensor::write(meta,d.val);
+    itensor::write(meta,d.length);
+    return makeParts(meta,d.store);
+    }
+
+//Storage without element data is
+//kept entirely in the table
+template<typename D>
+StoreParts
+metaOnly(D const& d)
+    {
+    std::ostringstream meta;
+    itensor::write(meta,d);
+    auto p = StoreParts{};
+    p.meta = meta.str();
+    return p;
+    }
+
+StoreParts
+doTask(GetStoreParts, Combiner const& d) { return metaOnly(d); }
+
+StoreParts
+doTask(GetStoreParts, QCombiner const& d) { return metaOnly(d); }
+
+template<typename T>
+StoreParts
+doTask(GetStoreParts, Scalar<T> const& d) { return metaOnly(d); }
+
+void
+writeZeros(std::ostream& s, offset_type n)
+    {
+    char const zeros[tf_align] = {};
+    while(n > 0)
+        {
+        auto nw = std::min(n,tf_align);
+        s.write(zeros,nw);
+        n -= nw;
+        }
+    }
+
+} //namespace
+
+TensorFileWriter::
+TensorFileWriter(string const& fname)
+  : fname_(fname),
+    s_(fname.c_str(),std::ios::binary)
+    {
+    if(!s_.good())
+        throw ITError("Couldn't open file \"" + fname + "\" for writing");
+    //Header is written by close()
+    writeZeros(s_,tf_align);
+    pos_ = tf_align;
+    }
+
+TensorFileWriter::
+~TensorFileWriter()
+    {
+    try
+        {
+        close();
+        }
+    catch(std::exception const& e)
+        {
+        printfln("Warning: %s",e.what());
+        }
+    }
+
+void TensorFileWriter::
+write(string const& name, ITensor const& T)
+    {
+    writeTensor(name,T);
+    }
+
+void TensorFileWriter::
+write(string const& name, IQTensor const& T)
+    {
+    writeTensor(name,T);
+    }
+
+offset_type TensorFileWriter::
+indexNum(Index const& i)
+    {
+    auto key = std::make_pair(i.id(),i.primeLevel());
+    auto it = index_num_.find(key);
+    if(it != index_num_.end()) return it->second;
+    auto n = offset_type(index_num_.size());
+    index_num_[key] = n;
+    i.write(indices_);
+    return n;
+    }
+
+offset_type TensorFileWriter::
+indexNum(IQIndex const& I)
+    {
+    auto key = IQKey{I.id(),I.primeLevel(),int(I.dir())};
+    auto it = iqindex_num_.find(key);
+    if(it != iqindex_num_.end()) return it->second;
+
+    //Sectors are shared by all prime
+    //levels and arrows of an IQIndex
+    auto dit = iqdat_num_.find(I.id());
+    auto datnum = offset_type(0);
+    if(dit != iqdat_num_.end())
+        {
+        datnum = dit->second;
+        }
+    else
+        {
+        datnum = offset_type(iqdat_num_.size());
+        iqdat_num_[I.id()] = datnum;
+        itensor::write(iqdats_,offset_type(I.nblock()));
+        for(auto j : range1(I.nblock()))
+            {
+            itensor::write(iqdats_,indexNum(I.index(j)));
+            itensor::write(iqdats_,I.qn(j));
+            }
+        }
+
+    auto n = offset_type(iqindex_num_.size());
+    iqindex_num_[key] = n;
+    itensor::write(iqindices_,indexNum(static_cast<Index const&>(I)));
+    itensor::write(iqindices_,I.dir());
+    itensor::write(iqindices_,datnum);
+    return n;
+    }
+
+template<typename IndexT>
+void TensorFileWriter::
+writeTensor(string const& name, ITensorT<IndexT> const& T)
+    {
+    if(!s_.is_open()) throw ITError("TensorFileWriter: file \"" + fname_ + "\" already closed");
+
+    auto type = StorageType::Null;
+    auto parts = StoreParts{};
+    if(T.store())
+        {
+        type = doTask(StorageType{},T.store());
+        parts = doTask(GetStoreParts{},T.store());
+        }
+
+    //Align the data block
+    auto offset = (pos_+tf_align-1)/tf_align*tf_align;
+    writeZeros(s_,offset-pos_);
+    s_.write(parts.data,parts.size);
+    pos_ = offset+parts.size;
+    if(!s_.good()) throw ITError("Error writing to file \"" + fname_ + "\"");
+
+    auto inds = vector<offset_type>();
+    for(auto& I : T.inds()) inds.push_back(indexNum(I));
+
+    itensor::write(entries_,name);
+    itensor::write(entries_,std::is_same<IndexT,IQIndex>::value);
+    itensor::write(entries_,inds);
+    itensor::write(entries_,T.scale());
+    itensor::write(entries_,type);
+    itensor::write(entries_,parts.meta);
+    itensor::write(entries_,offset);
+    itensor::write(entries_,parts.size);
+    ++nentry_;
+    }
+
+void TensorFileWriter::
+writeAttribute(string const& name, string const& value)
+    {
+    attrs_[name] = value;
+    }
+
+void TensorFileWriter::
+close()
+    {
+    if(!s_.is_open()) return;
+
+    auto table_offset = (pos_+tf_align-1)/tf_align*tf_align;
+    writeZeros(s_,table_offset-pos_);
+    auto writeSection = [this](offset_type n, std::ostringstream const& sec)
+        {
+        itensor::write(s_,n);
+        auto str = sec.str();
+        s_.write(str.data(),str.size());
+        return sizeof(n)+str.size();
+        };
+    offset_type table_size = 0;
+    table_size += writeSection(index_num_.size(),indices_);
+    table_size += writeSection(iqdat_num_.size(),iqdats_);
+    table_size += writeSection(iqindex_num_.size(),iqindices_);
+    table_size += writeSection(nentry_,entries_);
+    std::ostringstream attrs;
+    for(auto& a : attrs_)
+        {
+        itensor::write(attrs,a.first);
+        itensor::write(attrs,a.second);
+        }
+    table_size += writeSection(attrs_.size(),attrs);
+
+    auto h = TensorFileHeader{};
+    std::memcpy(h.magic,tf_magic,sizeof(tf_magic));
+    h.version = tensorFileVersion();
+    h.table_offset = table_offset;
+    h.table_size = table_size;
+    s_.seekp(0);
+    s_.write(reinterpret_cast<char const*>(&h),sizeof(h));
+    auto ok = s_.good();
+    s_.close();
+    if(!ok) throw ITError("Error writing to file \"" + fname_ + "\"");
+    }
+
+void TensorFileWriter::
+discard()
+    {
+    if(s_.is_open()) s_.close();
+    std::remove(fname_.c_str());
+    }
+
+
+TensorFile::
+TensorFile(string const& fname)
+  : fname_(fname)
+    {
+#if defined(_WIN32)
+    std::ifstream s(fname.c_str(),std::ios::binary);
+    if(!s.good()) throw ITError("Couldn't open file \"" + fname + "\" for reading");
+    buf_.assign(std::istreambuf_iterator<char>(s),std::istreambuf_iterator<char>());
+    data_ = buf_.data();
+    size_ = buf_.size();
+#else
+    auto fd = ::open(fname.c_str(),O_RDONLY);
+    if(fd < 0) throw ITError("Couldn't open file \"" + fname + "\" for reading");
+    struct stat st;
+    if(::fstat(fd,&st) != 0)
+        {
+        ::close(fd);
+        throw ITError("Couldn't determine size of file \"" + fname + "\"");
+        }
+    size_ = st.st_size;
+    if(size_ > 0)
+        {
+        auto p = ::mmap(nullptr,size_,PROT_READ,MAP_PRIVATE,fd,0);
+        if(p == MAP_FAILED)
+            {
+            ::close(fd);
+            throw ITError("Couldn't map file \"" + fname + "\" into memory");
+            }
+        data_ = static_cast<char const*>(p);
+        }
+    //The mapping stays valid after closing
+    ::close(fd);
+#endif
+    try
+        {
+        readTable();
+        }
+    catch(...)
+        {
+#if !defined(_WIN32)
+        if(data_) ::munmap(const_cast<char*>(data_),size_);
+#endif
+        throw;
+        }
+    }
+
+TensorFile::
+~TensorFile()
+    {
+#if !defined(_WIN32)
+    if(data_) ::munmap(const_cast<char*>(data_),size_);
+#endif
+    }
+
+void TensorFile::
+readTable()
+    {
+    auto bad = [this](string const& what)
+        {
+        return ITError("File \"" + fname_ + "\" is not a valid TensorFile: " + what);
+        };
+
+    if(size_ < sizeof(TensorFileHeader)) throw bad("too short");
+    auto h = TensorFileHeader{};
+    std::memcpy(&h,data_,sizeof(h));
+    if(std::memcmp(h.magic,tf_magic,sizeof(tf_magic)) != 0) throw bad("wrong magic number");
+    version_ = h.version;
+    if(version_ > tensorFileVersion())
+        {
+        throw ITError(format("File \"%s\" has TensorFile format version %d, newer than supported version %d",
+                             fname_,version_,tensorFileVersion()));
+        }
+    if(h.table_offset+h.table_size > size_) throw bad("truncated table");
+
+    std::istringstream s(string(data_+h.table_offset,h.table_size));
+    auto count = [&s]()
+        {
+        offset_type n = 0;
+        itensor::read(s,n);
+        return n;
+        };
+
+    indices_.resize(count());
+    for(auto& i : indices_) i.read(s);
+
+    auto iqdats = vector<IQIndex::storage_ptr>(count());
+    for(auto& dat : iqdats)
+        {
+        auto iq = IQIndex::storage(count());
+        for(auto& x : iq)
+            {
+            auto n = count();
+            x.index = indices_.at(n);
+            itensor::read(s,x.qn);
+            }
+        dat = IQIndex("",move(iq)).store();
+        }
+
+    iqindices_.resize(count());
+    for(auto& I : iqindices_)
+        {
+        auto n = count();
+        auto dir = Out;
+        itensor::read(s,dir);
+        auto d = count();
+        I = IQIndex(indices_.at(n),iqdats.at(d),dir);
+        }
+
+    auto nentry = count();
+    for(offset_type n = 0; n < nentry; ++n)
+        {
+        auto name = string();
+        auto e = Entry{};
+        itensor::read(s,name);
+        itensor::read(s,e.iq);
+        itensor::read(s,e.inds);
+        itensor::read(s,e.scale);
+        itensor::read(s,e.type);
+        itensor::read(s,e.meta);
+        itensor::read(s,e.offset);
+        itensor::read(s,e.size);
+        if(e.offset+e.size > size_) throw bad("truncated data of tensor \"" + name + "\"");
+        entries_[name] = move(e);
+        }
+
+    if(version_ >= 2)
+        {
+        auto nattr = count();
+        for(offset_type n = 0; n < nattr; ++n)
+            {
+            auto name = string();
+            itensor::read(s,name);
+            itensor::read(s,attrs_[name]);
+            }
+        }
+    if(!s) throw bad("truncated table");
+    }
+
+vector<string> TensorFile::
+names() const
+    {
+    auto res = stdx::reserve_vector<string>(entries_.size());
+    for(auto& e : entries_) res.push_back(e.first);
+    return res;
+    }
+
+string const& TensorFile::
+attribute(string const& name) const
+    {
+    auto it = attrs_.find(name);
+    if(it == attrs_.end())
+        throw ITError("No attribute \"" + name + "\" in file \"" + fname_ + "\"");
+    return it->second;
+    }
+
+TensorFile::Entry const& TensorFile::
+entry(string const& name) const
+    {
+    auto it = entries_.find(name);
+    if(it == entries_.end())
+        throw ITError("No tensor \"" + name + "\" in file \"" + fname_ + "\"");
+    return it->second;
+    }
+
+namespace {
+
+template<typename V>
+void
+readData(char const* p, offset_type size, vector<V> & store)
+    {
+    store.resize(size/sizeof(V));
+    std::memcpy(store.data(),p,size);
+    }
+
+Index const&
+fileIndex(vector<Index> const& indices,
+          vector<IQIndex> const&,
+          offset_type n,
+          Index const*)
+    {
+    return indices.at(n);
+    }
+
+IQIndex const&
+fileIndex(vector<Index> const&,
+          vector<IQIndex> const& iqindices,
+          offset_type n,
+          IQIndex const*)
+    {
+    return iqindices.at(n);
+    }
+
+} //namespace
+
+template<typename IndexT>
+ITensorT<IndexT> TensorFile::
+readTensor(Entry const& e) const
+    {
+    if(e.iq != std::is_same<IndexT,IQIndex>::value)
+        {
+        throw ITError(format("Reading %s from file \"%s\" holding %s",
+                             e.iq ? "ITensor" : "IQTensor",fname_,
+                             e.iq ? "IQTensor" : "ITensor"));
+        }
+
+    auto inds = stdx::reserve_vector<IndexT>(e.inds.size());
+    for(auto n : e.inds)
+        {
+        inds.push_back(fileIndex(indices_,iqindices_,n,static_cast<IndexT const*>(nullptr)));
+        }
+    auto is = IndexSetT<IndexT>(move(inds));
+
+    std::istringstream meta(e.meta);
+    auto p = data_+e.offset;
+    switch(e.type)
+        {
+        case StorageType::Null:
+            {
+            return ITensorT<IndexT>(move(is));
+            }
+        case StorageType::DenseReal:
+            {
+            auto d = DenseReal{};
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::DenseCplx:
+            {
+            auto d = DenseCplx{};
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::DiagReal:
+            {
+            auto d = DiagReal{};
+            itensor::read(meta,d.val);
+            itensor::read(meta,d.length);
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::DiagCplx:
+            {
+            auto d = DiagCplx{};
+            itensor::read(meta,d.val);
+            itensor::read(meta,d.length);
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::QDenseReal:
+            {
+            auto d = QDenseReal{};
+            itensor::read(meta,d.offsets);
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::QDenseCplx:
+            {
+            auto d = QDenseCplx{};
+            itensor::read(meta,d.offsets);
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::QDiagReal:
+            {
+            auto d = QDiagReal{};
+            itensor::read(meta,d.val);
+            itensor::read(meta,d.length);
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::QDiagCplx:
+            {
+            auto d = QDiagCplx{};
+            itensor::read(meta,d.val);
+            itensor::read(meta,d.length);
+            readData(p,e.size,d.store);
+            return ITensorT<IndexT>(move(is),move(d),e.scale);
+            }
+        case StorageType::Combiner:
+            {
+            return ITensorT<IndexT>(move(is),itensor::read<Combiner>(meta),e.scale);
+            }
+        case StorageType::QCombiner:
+            {
+            return ITensorT<IndexT>(move(is),itensor::read<QCombiner>(meta),e.scale);
+            }
+        case StorageType::ScalarReal:
+            {
+            return ITensorT<IndexT>(move(is),itensor::read<ScalarReal>(meta),e.scale);
+            }
+        case StorageType::ScalarCplx:
+            {
+            return ITensorT<IndexT>(move(is),itensor::read<ScalarCplx>(meta),e.scale);
+            }
+        }
+    throw ITError("Unrecognized storage type in file \"" + fname_ + "\"");
+    }
+template ITensor TensorFile::readTensor(Entry const& e) const;
+template IQTensor TensorFile::readTensor(Entry const& e) const;
+
+} //namespace itensor
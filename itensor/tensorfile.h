@@ -0,0 +1,198 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_TENSORFILE_H
+#define __ITENSOR_TENSORFILE_H
+
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <tuple>
+#include "itensor/iqtensor.h"
+
+namespace itensor {
+
+//
+// Versioned binary container holding named
+// ITensors and IQTensors.
+//
+// Layout:
+//   o 64-byte header: magic "ITENSORF", format
+//     version, offset and size of the table
+//   o raw element data of each tensor's storage,
+//     every block starting at a multiple of 64 bytes
+//   o table: each distinct Index, IQIndex and IQIndex
+//     sector list stored once, followed by one entry
+//     per tensor (name, index numbers, scale, storage
+//     type, storage metadata, data block location)
+//   o (version 2 and later) named attributes:
+//     short byte strings such as serialized counters
+//
+// Reading maps the file into memory (mmap), so
+// opening is cheap and only the blocks of tensors
+// actually read are loaded from disk. Files use the
+// byte order of the machine writing them.
+//
+
+class TensorFileWriter
+    {
+    public:
+    using offset_type = std::uint64_t;
+    private:
+    struct IQKey
+        {
+        Index::id_type id;
+        int plev;
+        int dir;
+        bool
+        operator<(IQKey const& o) const
+            {
+            return std::tie(id,plev,dir) < std::tie(o.id,o.plev,o.dir);
+            }
+        };
+    std::string fname_;
+    std::ofstream s_;
+    offset_type pos_ = 0;
+    std::map<std::pair<Index::id_type,int>,offset_type> index_num_;
+    std::map<Index::id_type,offset_type> iqdat_num_;
+    std::map<IQKey,offset_type> iqindex_num_;
+    std::ostringstream indices_,
+                       iqdats_,
+                       iqindices_,
+                       entries_;
+    offset_type nentry_ = 0;
+    std::map<std::string,std::string> attrs_;
+    public:
+
+    explicit
+    TensorFileWriter(std::string const& fname);
+
+    TensorFileWriter(TensorFileWriter const&) = delete;
+    TensorFileWriter& operator=(TensorFileWriter const&) = delete;
+
+    //Calls close() if not called already,
+    //printing a warning if that fails
+    ~TensorFileWriter();
+
+    void
+    write(std::string const& name, ITensor const& T);
+
+    void
+    write(std::string const& name, IQTensor const& T);
+
+    //Stores an arbitrary byte string under name
+    void
+    writeAttribute(std::string const& name, std::string const& value);
+
+    //Writes the table; the file is
+    //only readable after close()
+    void
+    close();
+
+    //Closes without writing the table and removes
+    //the file, e.g. when a write has failed
+    void
+    discard();
+
+    private:
+
+    offset_type
+    indexNum(Index const& i);
+
+    offset_type
+    indexNum(IQIndex const& I);
+
+    template<typename IndexT>
+    void
+    writeTensor(std::string const& name, ITensorT<IndexT> const& T);
+    };
+
+class TensorFile
+    {
+    public:
+    using offset_type = TensorFileWriter::offset_type;
+    private:
+    struct Entry
+        {
+        bool iq = false;
+        std::vector<offset_type> inds;
+        LogNum scale;
+        StorageType::Type type = StorageType::Null;
+        std::string meta;
+        offset_type offset = 0,
+                    size = 0;
+        };
+    std::string fname_;
+    char const* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<char> buf_; //used if mmap is unavailable
+    std::uint32_t version_ = 0;
+    std::vector<Index> indices_;
+    std::vector<IQIndex> iqindices_;
+    std::map<std::string,Entry> entries_;
+    std::map<std::string,std::string> attrs_;
+    public:
+
+    //Maps the file into memory and reads its table;
+    //throws ITError if it is not a valid TensorFile
+    explicit
+    TensorFile(std::string const& fname);
+
+    TensorFile(TensorFile const&) = delete;
+    TensorFile& operator=(TensorFile const&) = delete;
+
+    ~TensorFile();
+
+    std::string const&
+    fileName() const { return fname_; }
+
+    //Format version of the file
+    std::uint32_t
+    version() const { return version_; }
+
+    bool
+    has(std::string const& name) const { return entries_.count(name) > 0; }
+
+    //Names of all tensors in the file
+    std::vector<std::string>
+    names() const;
+
+    bool
+    hasAttribute(std::string const& name) const { return attrs_.count(name) > 0; }
+
+    //Returns the attribute written with the
+    //given name; throws ITError if there is none
+    std::string const&
+    attribute(std::string const& name) const;
+
+    //Reads the tensor written with the given name. Tensor must
+    //be ITensor or IQTensor, matching the type written.
+    template<class Tensor>
+    Tensor
+    read(std::string const& name) const
+        {
+        return readTensor<typename Tensor::index_type>(entry(name));
+        }
+
+    private:
+
+    void
+    readTable();
+
+    Entry const&
+    entry(std::string const& name) const;
+
+    template<typename IndexT>
+    ITensorT<IndexT>
+    readTensor(Entry const& e) const;
+    };
+
+//Current version of the TensorFile format
+std::uint32_t constexpr
+tensorFileVersion() { return 2; }
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,197 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_ASYNCFILE_H
+#define __ITENSOR_ASYNCFILE_H
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "itensor/util/readwrite.h"
+
+namespace itensor {
+
+//
+// Objects stored in files by a background thread.
+//
+// write(fname,t) returns at once; t is written by the
+// I/O thread and kept in memory until then, so reading
+// it back never waits for the disk. prefetch(fname)
+// starts reading a file so that a later read(fname)
+// finds it already loaded. Tasks run in the order
+// submitted, so a file is never read while an
+// earlier write to it is still in progress.
+//
+// Used by LocalMPO and MPSt when doWrite(true)
+// to take disk access off the critical path.
+//
+template<class T>
+class AsyncFileStore
+    {
+    using Ptr = std::shared_ptr<T const>;
+    using Future = std::shared_future<Ptr>;
+    struct Slot
+        {
+        Future f;
+        //Object being written, or nullptr if prefetched
+        T const* written;
+        };
+    std::map<std::string,Slot> loaded_;
+    std::deque<std::function<void()>> tasks_;
+    std::exception_ptr error_;
+    std::mutex m_;
+    std::condition_variable wake_,
+                            idle_;
+    bool busy_ = false,
+         stop_ = false;
+    std::thread thread_;
+    public:
+
+    AsyncFileStore() : thread_([this]{ loop(); }) { }
+
+    AsyncFileStore(AsyncFileStore const&) = delete;
+    AsyncFileStore& operator=(AsyncFileStore const&) = delete;
+
+    //Finishes all pending writes
+    ~AsyncFileStore()
+        {
+            {
+            std::lock_guard<std::mutex> lock(m_);
+            stop_ = true;
+            }
+        wake_.notify_one();
+        thread_.join();
+        }
+
+    void
+    write(std::string const& fname, T t)
+        {
+        auto p = std::make_shared<T const>(std::move(t));
+        auto done = std::promise<Ptr>();
+        done.set_value(p);
+        std::lock_guard<std::mutex> lock(m_);
+        rethrow();
+        loaded_[fname] = Slot{done.get_future().share(),p.get()};
+        submit([this,fname,p]
+            {
+            writeToFile(fname,*p);
+            //Drop the in-memory copy unless fname was
+            //written again or prefetched meanwhile
+            //(waiting on a prefetch here would deadlock)
+            std::lock_guard<std::mutex> lock(m_);
+            auto it = loaded_.find(fname);
+            if(it != loaded_.end() && it->second.written == p.get()) loaded_.erase(it);
+            });
+        }
+
+    void
+    prefetch(std::string const& fname)
+        {
+        std::lock_guard<std::mutex> lock(m_);
+        if(loaded_.count(fname)) return;
+        auto done = std::make_shared<std::promise<Ptr>>();
+        loaded_[fname] = Slot{done->get_future().share(),nullptr};
+        submit([fname,done]
+            {
+            try
+                {
+                done->set_value(std::make_shared<T const>(readFromFile<T>(fname)));
+                }
+            catch(...)
+                {
+                done->set_exception(std::current_exception());
+                }
+            });
+        }
+
+    //Returns the contents of fname, waiting
+    //for a prefetch of it if one is pending
+    T
+    read(std::string const& fname)
+        {
+        auto slot = Future();
+            {
+            std::lock_guard<std::mutex> lock(m_);
+            rethrow();
+            auto it = loaded_.find(fname);
+            if(it != loaded_.end())
+                {
+                slot = it->second.f;
+                //Slots of pending writes are removed by the
+                //write task, so that reading fname again
+                //never reads the file while it is written
+                if(!it->second.written) loaded_.erase(it);
+                }
+            }
+        if(slot.valid()) return *slot.get();
+        return readFromFile<T>(fname);
+        }
+
+    //Waits until all submitted tasks are done
+    void
+    flush()
+        {
+        std::unique_lock<std::mutex> lock(m_);
+        idle_.wait(lock,[this]{ return tasks_.empty() && !busy_; });
+        rethrow();
+        }
+
+    private:
+
+    //Requires m_ to be locked
+    void
+    submit(std::function<void()> f)
+        {
+        tasks_.push_back(std::move(f));
+        wake_.notify_one();
+        }
+
+    //Requires m_ to be locked
+    void
+    rethrow()
+        {
+        if(!error_) return;
+        auto e = error_;
+        error_ = nullptr;
+        std::rethrow_exception(e);
+        }
+
+    void
+    loop()
+        {
+        std::unique_lock<std::mutex> lock(m_);
+        while(true)
+            {
+            wake_.wait(lock,[this]{ return stop_ || !tasks_.empty(); });
+            if(tasks_.empty()) return;
+            auto f = std::move(tasks_.front());
+            tasks_.pop_front();
+            busy_ = true;
+            lock.unlock();
+            try
+                {
+                f();
+                }
+            catch(...)
+                {
+                lock.lock();
+                if(!error_) error_ = std::current_exception();
+                lock.unlock();
+                }
+            lock.lock();
+            busy_ = false;
+            if(tasks_.empty()) idle_.notify_all();
+            }
+        }
+    };
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,206 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <ostream>
+#include "itensor/util/eventtrace.h"
+#include "itensor/util/profiler.h"
+#include "itensor/util/error.h"
+#include "itensor/util/print.h"
+
+namespace itensor {
+
+namespace {
+
+//Small ids numbering threads in order of their first event
+int
+threadId()
+    {
+    static std::atomic<int> next(0);
+    thread_local int id = next++;
+    return id;
+    }
+
+//Number of regions the current thread is in
+int&
+threadDepth()
+    {
+    thread_local int depth = 0;
+    return depth;
+    }
+
+} //namespace
+
+EventTracer::
+EventTracer()
+  : active_(false),
+    sweep_(0),
+    bond_(0),
+    max_depth_(-1)
+    {
+    //Region names are held by the profiler, which
+    //must therefore be destroyed after the tracer
+    profiler();
+    auto fname = std::getenv("ITENSOR_EVENT_TRACE");
+    if(fname && *fname) start(fname);
+    }
+
+EventTracer::
+~EventTracer()
+    {
+    try
+        {
+        stop();
+        }
+    catch(std::exception const& e)
+        {
+        printfln("Warning: %s",e.what());
+        }
+    }
+
+EventTracer&
+eventTracer()
+    {
+    static EventTracer t;
+    return t;
+    }
+
+void EventTracer::
+start(std::string const& fname,
+      size_t capacity,
+      int max_depth)
+    {
+    if(capacity == 0) Error("EventTracer capacity must be positive");
+    std::lock_guard<std::mutex> lock(m_);
+    file_ = fname;
+    events_.assign(capacity,Event());
+    nrecord_ = 0;
+    max_depth_ = max_depth;
+    start_ = clock_type::now();
+    active_ = true;
+    }
+
+void EventTracer::
+stop()
+    {
+    if(!active_.exchange(false)) return;
+    auto fname = std::string();
+        {
+        std::lock_guard<std::mutex> lock(m_);
+        fname = file_;
+        }
+    if(fname.empty()) return;
+    std::ofstream f(fname);
+    if(!f) throw ITError("Couldn't open event trace file \"" + fname + "\"");
+    writeJSON(f);
+    }
+
+void EventTracer::
+begin(int region, double bytes)
+    {
+    auto depth = ++threadDepth();
+    auto max_depth = max_depth_.load(std::memory_order_relaxed);
+    if(max_depth >= 0 && depth > max_depth) return;
+    record(region,'B',bytes);
+    }
+
+void EventTracer::
+end(int region)
+    {
+    auto depth = threadDepth()--;
+    auto max_depth = max_depth_.load(std::memory_order_relaxed);
+    if(max_depth >= 0 && depth > max_depth) return;
+    record(region,'E',0);
+    }
+
+void EventTracer::
+record(int region, char phase, double bytes)
+    {
+    auto e = Event();
+    e.time = clock_type::now();
+    e.bytes = bytes;
+    e.region = region;
+    e.tid = threadId();
+    e.sweep = sweep_.load(std::memory_order_relaxed);
+    e.bond = bond_.load(std::memory_order_relaxed);
+    e.phase = phase;
+    std::lock_guard<std::mutex> lock(m_);
+    if(events_.empty()) return;
+    events_[nrecord_ % events_.size()] = e;
+    ++nrecord_;
+    }
+
+size_t EventTracer::
+size() const
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    return std::min(nrecord_,events_.size());
+    }
+
+size_t EventTracer::
+dropped() const
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    return nrecord_ > events_.size() ? nrecord_-events_.size() : 0;
+    }
+
+void EventTracer::
+writeJSON(std::ostream& s) const
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    auto cap = events_.size();
+    auto n = std::min(nrecord_,cap);
+    auto first = nrecord_-n;
+    //Depth of open begin events of each thread
+    auto depth = std::map<int,int>();
+    auto& P = profiler();
+    auto comma = false;
+    s << "{\"traceEvents\":[";
+    for(auto j = first; j < nrecord_; ++j)
+        {
+        auto& e = events_[j % cap];
+        auto& d = depth[e.tid];
+        if(e.phase == 'E')
+            {
+            if(d == 0) continue;
+            --d;
+            }
+        else
+            {
+            ++d;
+            }
+        auto ts = std::chrono::duration<double,std::micro>(e.time-start_).count();
+        s << (comma ? ",\n" : "\n");
+        comma = true;
+        s << format("{\"name\":\"%s\",\"cat\":\"itensor\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":0,\"tid\":%d",
+                    P.name(e.region),e.phase,ts,e.tid);
+        if(e.phase == 'B')
+            {
+            s << format(",\"args\":{\"sweep\":%d,\"bond\":%d",e.sweep,e.bond);
+            if(e.bytes > 0) s << format(",\"bytes\":%.0f",e.bytes);
+            s << "}";
+            }
+        s << "}";
+        }
+    s << format("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"dropped\":%d}}\n",first);
+    }
+
+EventTraceSession::
+~EventTraceSession()
+    {
+    if(!started_) return;
+    try
+        {
+        eventTracer().stop();
+        }
+    catch(std::exception const& e)
+        {
+        printfln("Warning: %s",e.what());
+        }
+    }
+
+} //namespace itensor
@@ -0,0 +1,158 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_EVENTTRACE_H
+#define __ITENSOR_EVENTTRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace itensor {
+
+//
+// Timeline of begin/end events in the Chrome trace-event
+// format (load the output in chrome://tracing or Perfetto).
+//
+// Events are emitted by the regions marked with
+// PROFILE_SCOPE (see util/profiler.h), and carry the
+// thread, the current sweep and bond set by setPosition
+// (by dmrg and gateTEvol, where the "sweep" is the time
+// step) and the bytes given to PROFILE_SCOPE_BYTES.
+//
+// Events are kept in a ring buffer of fixed capacity,
+// so only the most recent ones are written out. Giving
+// a maximum depth skips regions nested more deeply
+// (such as gemm calls inside contractions), so that the
+// buffer holds a longer stretch of the outer regions.
+//
+// Tracing is off unless the environment variable
+// ITENSOR_EVENT_TRACE is set to the name of an output file
+// (written at program exit) or eventTracer().start(fname)
+// is called. dmrg and gateTEvol also trace for the
+// "EventTraceFile" arg, writing the file when they return.
+//
+class EventTracer
+    {
+    public:
+    using clock_type = std::chrono::steady_clock;
+
+    struct Event
+        {
+        clock_type::time_point time;
+        double bytes = 0;
+        int region = -1;
+        int tid = 0;
+        int sweep = 0,
+            bond = 0;
+        char phase = 'B'; //'B' for begin, 'E' for end
+        };
+
+    static const size_t default_capacity = 1ul << 18;
+    private:
+    std::atomic<bool> active_;
+    std::atomic<int> sweep_,
+                     bond_,
+                     max_depth_;
+    mutable std::mutex m_;
+    std::string file_;
+    std::vector<Event> events_;
+    size_t nrecord_ = 0; //events recorded since start
+    clock_type::time_point start_;
+    public:
+
+    EventTracer();
+
+    EventTracer(EventTracer const&) = delete;
+    EventTracer& operator=(EventTracer const&) = delete;
+
+    //Writes the events if still recording; errors are
+    //printed as a warning since this runs at program exit
+    ~EventTracer();
+
+    bool
+    active() const { return active_.load(std::memory_order_relaxed); }
+
+    //Clears the buffer and starts recording; stop writes
+    //the events to fname, unless it is empty.
+    //If max_depth >= 0 only regions nested at most
+    //max_depth deep in each thread are recorded.
+    void
+    start(std::string const& fname = "",
+          size_t capacity = default_capacity,
+          int max_depth = -1);
+
+    //Writes the events to the file given to start
+    //and stops recording
+    void
+    stop();
+
+    //Sweep and bond recorded with later events
+    void
+    setPosition(int sweep, int bond)
+        {
+        sweep_.store(sweep,std::memory_order_relaxed);
+        bond_.store(bond,std::memory_order_relaxed);
+        }
+
+    void
+    begin(int region, double bytes = 0);
+
+    void
+    end(int region);
+
+    //Number of events in the buffer
+    size_t
+    size() const;
+
+    //Number of events overwritten since start
+    size_t
+    dropped() const;
+
+    //Writes the buffered events as a JSON trace. End
+    //events whose begin event was overwritten are skipped.
+    void
+    writeJSON(std::ostream& s) const;
+
+    private:
+
+    void
+    record(int region, char phase, double bytes);
+    };
+
+EventTracer&
+eventTracer();
+
+//
+// Runs the event tracer for the lifetime of this
+// object if fname is not empty and the tracer is
+// not already running
+//
+class EventTraceSession
+    {
+    bool started_ = false;
+    public:
+
+    EventTraceSession(std::string const& fname,
+                      size_t capacity = EventTracer::default_capacity,
+                      int max_depth = -1)
+        {
+        if(fname.empty() || eventTracer().active()) return;
+        eventTracer().start(fname,capacity,max_depth);
+        started_ = true;
+        }
+
+    EventTraceSession(EventTraceSession const&) = delete;
+    EventTraceSession& operator=(EventTraceSession const&) = delete;
+
+    //Errors writing the file are printed as a warning
+    ~EventTraceSession();
+    };
+
+} //namespace itensor
+
+#endif
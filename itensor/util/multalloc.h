@@ -5,8 +5,13 @@
 #ifndef __ITENSOR_MULTALLOC_H
 #define __ITENSOR_MULTALLOC_H
 
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <vector>
+#include <type_traits>
 #include "itensor/global.h"
 
 #ifdef DEBUG
@@ -41,6 +46,313 @@
 
 namespace itensor {
 
+//
+// Scratch memory for short-lived temporary buffers
+// (permuted copies in contract, workspace of SVD
+// and LAPACK calls), drawn from an arena owned by
+// each thread so that repeated calls reuse the same
+// memory instead of going through malloc and free.
+//
+// Buffers must be released in the reverse order they
+// were acquired, which holds automatically for
+// ScratchBuf objects declared as local variables.
+//
+// Arenas keep their memory between calls; trimScratch()
+// frees the memory of every thread's arena not in use.
+//
+// //Sample usage:
+// auto buf = ScratchBuf<Real>(n);
+// auto* p = buf.data(); //n uninitialized Reals
+//
+
+struct ScratchStats
+    {
+    size_t nacquire = 0; //number of buffers handed out
+    size_t nreuse = 0;   //number served from memory already held by an arena
+    size_t nheap = 0;    //number of heap allocations made by arenas
+    size_t peak = 0;     //most bytes in use at once in any one thread
+    };
+
+class ScratchArena;
+
+namespace detail {
+
+struct ScratchCounters
+    {
+    std::atomic<size_t> nacquire{0},
+                        nreuse{0},
+                        nheap{0},
+                        peak{0};
+    };
+
+inline ScratchCounters&
+scratchCounters()
+    {
+    static ScratchCounters c;
+    return c;
+    }
+
+//Arenas of all threads, for trimScratch
+struct ScratchRegistry
+    {
+    std::mutex m;
+    std::vector<ScratchArena*> arenas;
+    };
+
+inline ScratchRegistry&
+scratchRegistry()
+    {
+    static ScratchRegistry r;
+    return r;
+    }
+
+} //namespace detail
+
+class ScratchArena
+    {
+    public:
+    using size_type = std::size_t;
+    private:
+    struct Chunk
+        {
+        std::unique_ptr<Real[]> mem;
+        Real* data = nullptr; //mem rounded up to 64 bytes
+        size_type size = 0,
+                  used = 0;
+
+        void
+        allocate(size_type n)
+            {
+            mem.reset(new Real[n+7]);
+            auto addr = reinterpret_cast<std::uintptr_t>(mem.get());
+            data = reinterpret_cast<Real*>((addr+63) & ~std::uintptr_t(63));
+            size = n;
+            }
+        };
+    std::vector<Chunk> chunks_;
+    size_type inuse_ = 0,
+              wanted_ = 0;
+    //Only contended when trimScratch runs
+    mutable std::mutex m_;
+    public:
+
+    ScratchArena()
+        {
+        auto& r = detail::scratchRegistry();
+        std::lock_guard<std::mutex> lock(r.m);
+        r.arenas.push_back(this);
+        }
+
+    ~ScratchArena()
+        {
+        auto& r = detail::scratchRegistry();
+        std::lock_guard<std::mutex> lock(r.m);
+        r.arenas.erase(std::find(r.arenas.begin(),r.arenas.end(),this));
+        }
+
+    ScratchArena(ScratchArena const&) = delete;
+
+    ScratchArena& operator=(ScratchArena const&) = delete;
+
+    //Arena of the calling thread
+    static ScratchArena&
+    local()
+        {
+        static thread_local ScratchArena arena;
+        return arena;
+        }
+
+    //Returns memory for n Reals 
+    Real*
+    acquire(size_type n)
+        {
+        //Chunks start on a 64 byte boundary; rounding n up
+        //to a multiple of 8 Reals keeps every buffer on one
+        n = (n+7ul) & ~size_type(7ul);
+        std::lock_guard<std::mutex> lock(m_);
+        auto& c = detail::scratchCounters();
+        ++c.nacquire;
+        if(chunks_.empty() || chunks_.back().size-chunks_.back().used < n)
+            {
+            ++c.nheap;
+            auto cap = size_type(0);
+            for(auto& ch : chunks_) cap += ch.size;
+            chunks_.emplace_back();
+            chunks_.back().allocate(std::max(n,2*cap));
+            }
+        else
+            {
+            ++c.nreuse;
+            }
+        auto& ch = chunks_.back();
+        auto* p = ch.data+ch.used;
+        ch.used += n;
+        inuse_ += n;
+        wanted_ = std::max(wanted_,inuse_);
+        auto bytes = inuse_*sizeof(Real);
+        auto peak = c.peak.load();
+        while(bytes > peak && !c.peak.compare_exchange_weak(peak,bytes)) { }
+        return p;
+        }
+
+    //Returns memory obtained from acquire(n),
+    //which must be the most recent one not yet released
+    void
+    release(Real* p, size_type n)
+        {
+        n = (n+7ul) & ~size_type(7ul);
+        std::lock_guard<std::mutex> lock(m_);
+#ifdef DEBUG
+        if(chunks_.empty() || p != chunks_.back().data+chunks_.back().used-n)
+            {
+            throw std::runtime_error("ScratchArena: buffers released out of order");
+            }
+#endif
+        chunks_.back().used -= n;
+        inuse_ -= n;
+        if(chunks_.back().used == 0 && chunks_.size() > 1) 
+            {
+            chunks_.pop_back();
+            }
+        if(inuse_ == 0 && chunks_.size() == 1 && chunks_.front().size < wanted_)
+            {
+            //Replace with a single chunk large enough
+            //for everything that was in use at once
+            chunks_.front().allocate(wanted_);
+            }
+        }
+
+    //Number of Reals held by this arena
+    size_type
+    capacity() const
+        {
+        std::lock_guard<std::mutex> lock(m_);
+        size_type cap = 0;
+        for(auto& ch : chunks_) cap += ch.size;
+        return cap;
+        }
+
+    //Frees all memory held (only possible when no
+    //buffers are in use), returning the number of Reals freed
+    size_type
+    clear()
+        {
+        std::lock_guard<std::mutex> lock(m_);
+        if(inuse_ != 0) return 0;
+        size_type cap = 0;
+        for(auto& ch : chunks_) cap += ch.size;
+        chunks_.clear();
+        wanted_ = 0;
+        return cap;
+        }
+    };
+
+inline ScratchStats
+scratchStats()
+    {
+    auto& c = detail::scratchCounters();
+    auto s = ScratchStats{};
+    s.nacquire = c.nacquire.load();
+    s.nreuse = c.nreuse.load();
+    s.nheap = c.nheap.load();
+    s.peak = c.peak.load();
+    return s;
+    }
+
+//Frees the memory held by the arenas of all
+//threads, except those with buffers in use.
+//Returns the number of bytes freed.
+inline size_t
+trimScratch()
+    {
+    auto& r = detail::scratchRegistry();
+    std::lock_guard<std::mutex> lock(r.m);
+    size_t freed = 0;
+    for(auto* a : r.arenas) freed += a->clear()*sizeof(Real);
+    return freed;
+    }
+
+inline void
+resetScratchStats()
+    {
+    auto& c = detail::scratchCounters();
+    c.nacquire = 0;
+    c.nreuse = 0;
+    c.nheap = 0;
+    c.peak = 0;
+    }
+
+//
+// Uninitialized buffer of n elements of type T
+// (Real, Cplx, or a LAPACK scalar type) taken from
+// the calling thread's ScratchArena
+//
+template<typename T>
+class ScratchBuf
+    {
+    static_assert(std::is_trivially_destructible<T>::value 
+                  && sizeof(T) % sizeof(Real) == 0,
+                  "ScratchBuf element type must be made of Reals");
+    public:
+    using size_type = std::size_t;
+    using value_type = T;
+    private:
+    ScratchArena* arena_ = nullptr;
+    Real* p_ = nullptr;
+    size_type size_ = 0;
+    static constexpr size_type
+    nreal(size_type n) { return n*(sizeof(T)/sizeof(Real)); }
+    public:
+
+    ScratchBuf() { }
+
+    explicit
+    ScratchBuf(size_type n)
+      : size_(n)
+        { 
+        if(n == 0) return;
+        arena_ = &ScratchArena::local();
+        p_ = arena_->acquire(nreal(n));
+        }
+
+    ScratchBuf(ScratchBuf const&) = delete;
+
+    ScratchBuf& operator=(ScratchBuf const&) = delete;
+
+    ScratchBuf(ScratchBuf && o)
+      : arena_(o.arena_),
+        p_(o.p_),
+        size_(o.size_)
+        {
+        o.arena_ = nullptr;
+        o.p_ = nullptr;
+        o.size_ = 0;
+        }
+
+    ~ScratchBuf()
+        {
+        if(p_) arena_->release(p_,nreal(size_));
+        }
+
+    T*
+    data() { return reinterpret_cast<T*>(p_); }
+
+    T const*
+    data() const { return reinterpret_cast<T const*>(p_); }
+
+    size_type
+    size() const { return size_; }
+
+    bool
+    empty() const { return size_ == 0; }
+
+    T&
+    operator[](size_type i) { return data()[i]; }
+
+    T const&
+    operator[](size_type i) const { return data()[i]; }
+    };
+
 //
 // //Sample usage:
 // MultAlloc<Real,3> ma;
@@ -0,0 +1,103 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include <cstdlib>
+#include "itensor/util/opcount.h"
+#include "itensor/util/print.h"
+
+namespace itensor {
+
+namespace {
+
+void
+atomicAdd(std::atomic<double>& x, double v)
+    {
+    auto old = x.load(std::memory_order_relaxed);
+    while(!x.compare_exchange_weak(old,old+v,std::memory_order_relaxed)) { }
+    }
+
+} //namespace
+
+OpCounts
+operator-(OpCounts const& a, OpCounts const& b)
+    {
+    auto res = a;
+    for(int t = 0; t < NOpType; ++t)
+        {
+        res.ops[t].calls -= b.ops[t].calls;
+        res.ops[t].flops -= b.ops[t].flops;
+        res.ops[t].bytes -= b.ops[t].bytes;
+        res.ops[t].time -= b.ops[t].time;
+        }
+    return res;
+    }
+
+std::string
+showRates(OpCounts const& c)
+    {
+    return format("gemm %.2f GFLOP/s/thread (%.3f thread-s), permute %.2f GB/s/thread (%.3f thread-s), "
+                  "decomp %.2f GFLOP/s/thread (%.3f thread-s)",
+                  c[GemmOp].gflops(),c[GemmOp].time,
+                  c[PermuteOp].gbytes(),c[PermuteOp].time,
+                  c[DecompOp].gflops(),c[DecompOp].time);
+    }
+
+OpCounter::
+OpCounter()
+  : enabled_(false)
+    {
+    auto count = std::getenv("ITENSOR_COUNT_OPS");
+    if(count && *count) enable();
+    }
+
+OpCounter&
+opCounter()
+    {
+    static OpCounter c;
+    return c;
+    }
+
+void OpCounter::
+add(OpType t, double flops, double bytes, double time)
+    {
+    auto& c = counters_[t];
+    c.calls.fetch_add(1,std::memory_order_relaxed);
+    atomicAdd(c.flops,flops);
+    atomicAdd(c.bytes,bytes);
+    atomicAdd(c.time,time);
+    }
+
+OpStats OpCounter::
+stats(OpType t) const
+    {
+    auto& c = counters_[t];
+    auto s = OpStats();
+    s.calls = c.calls.load(std::memory_order_relaxed);
+    s.flops = c.flops.load(std::memory_order_relaxed);
+    s.bytes = c.bytes.load(std::memory_order_relaxed);
+    s.time = c.time.load(std::memory_order_relaxed);
+    return s;
+    }
+
+OpCounts OpCounter::
+counts() const
+    {
+    auto res = OpCounts();
+    for(int t = 0; t < NOpType; ++t) res.ops[t] = stats(OpType(t));
+    return res;
+    }
+
+void OpCounter::
+reset()
+    {
+    for(auto& c : counters_)
+        {
+        c.calls = 0;
+        c.flops = 0;
+        c.bytes = 0;
+        c.time = 0;
+        }
+    }
+
+} //namespace itensor
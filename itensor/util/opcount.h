@@ -0,0 +1,195 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_OPCOUNT_H
+#define __ITENSOR_OPCOUNT_H
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+//Counts the rest of the enclosing scope as one operation
+//of type TYPE doing FLOPS floating point operations and
+//moving BYTES bytes (only evaluated when counting is enabled)
+#define COUNT_OPS(TYPE,FLOPS,BYTES) \
+    itensor::OpCountScope ITENSOR_OPCOUNT_CAT(op_count_,__LINE__)(TYPE,[&]() { return double(FLOPS); },[&]() { return double(BYTES); });
+
+#define ITENSOR_OPCOUNT_CAT_(A,B) A##B
+#define ITENSOR_OPCOUNT_CAT(A,B) ITENSOR_OPCOUNT_CAT_(A,B)
+
+namespace itensor {
+
+enum OpType
+    {
+    GemmOp,    //matrix multiplications (gemm)
+    PermuteOp, //tensor permutations done by contract
+    DecompOp,  //dense SVDs and eigensolves (LAPACK)
+    NOpType
+    };
+
+struct OpStats
+    {
+    long calls = 0;
+    double flops = 0,
+           bytes = 0,
+           time = 0; //seconds, summed over calling threads
+
+    //Achieved rates (zero if no time was counted).
+    //Since time is summed over threads these are
+    //averages per thread, not the total throughput
+    //of calls made from several threads at once.
+    double
+    gflops() const { return time > 0 ? 1E-9*flops/time : 0; }
+
+    double
+    gbytes() const { return time > 0 ? 1E-9*bytes/time : 0; }
+    };
+
+struct OpCounts
+    {
+    OpStats ops[NOpType];
+
+    OpStats const&
+    operator[](OpType t) const { return ops[t]; }
+    };
+
+OpCounts
+operator-(OpCounts const& a, OpCounts const& b);
+
+//One line summary of the per-thread rates and
+//thread-seconds spent, such as "gemm 12.30 GFLOP/s/thread
+//(1.200 thread-s), permute 4.50 GB/s/thread (0.300 thread-s),
+//decomp 3.40 GFLOP/s/thread (0.200 thread-s)"
+std::string
+showRates(OpCounts const& c);
+
+//
+// Counts the floating point operations, bytes moved and
+// time spent in each gemm, each permutation done by
+// contract, and each dense SVD or eigensolve.
+// Flops of decompositions are the usual estimates
+// (e.g. 6mn^2+20n^3 for the SVD of an m x n matrix,
+// m >= n), and flops of complex operations are counted
+// as real ones (8mnk for zgemm, 4 times the real count
+// for complex decompositions).
+//
+// Counting is off unless enabled by setting the
+// environment variable ITENSOR_COUNT_OPS, by calling
+// opCounter().enable() or, during the call, by the
+// "CountOps" arg of dmrg and gateTEvol (see OpCountSession
+// below). While it is on, DMRGObserver and
+// TEvolObserver print the rates of each sweep or
+// time step.
+//
+// Totals are kept since the program started (or the
+// last reset); take differences of counts() to measure
+// a part of a calculation.
+//
+class OpCounter
+    {
+    struct Counter
+        {
+        std::atomic<long> calls;
+        std::atomic<double> flops,
+                            bytes,
+                            time;
+        Counter() : calls(0), flops(0), bytes(0), time(0) { }
+        };
+    std::atomic<bool> enabled_;
+    Counter counters_[NOpType];
+    public:
+    using clock_type = std::chrono::steady_clock;
+
+    OpCounter();
+
+    OpCounter(OpCounter const&) = delete;
+    OpCounter& operator=(OpCounter const&) = delete;
+
+    bool
+    enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    void
+    enable() { enabled_ = true; }
+
+    void
+    disable() { enabled_ = false; }
+
+    void
+    add(OpType t, double flops, double bytes, double time);
+
+    OpStats
+    stats(OpType t) const;
+
+    OpCounts
+    counts() const;
+
+    //Zeroes all counts
+    void
+    reset();
+    };
+
+OpCounter&
+opCounter();
+
+class OpCountScope
+    {
+    OpType type_ = GemmOp;
+    bool active_ = false;
+    double flops_ = 0,
+           bytes_ = 0;
+    OpCounter::clock_type::time_point start_;
+    public:
+
+    template<typename FlopsFunc, typename BytesFunc>
+    OpCountScope(OpType type, FlopsFunc&& flops, BytesFunc&& bytes)
+      : type_(type),
+        active_(opCounter().enabled())
+        {
+        if(!active_) return;
+        flops_ = flops();
+        bytes_ = bytes();
+        start_ = OpCounter::clock_type::now();
+        }
+
+    OpCountScope(OpCountScope const&) = delete;
+    OpCountScope& operator=(OpCountScope const&) = delete;
+
+    ~OpCountScope()
+        {
+        if(!active_) return;
+        auto t = std::chrono::duration<double>(OpCounter::clock_type::now()-start_).count();
+        opCounter().add(type_,flops_,bytes_,t);
+        }
+    };
+
+//
+// Enables op counting for the lifetime of this
+// object if count is true, then restores the
+// previous setting
+//
+class OpCountSession
+    {
+    bool started_ = false;
+    public:
+
+    explicit
+    OpCountSession(bool count)
+        {
+        if(!count || opCounter().enabled()) return;
+        opCounter().enable();
+        started_ = true;
+        }
+
+    OpCountSession(OpCountSession const&) = delete;
+    OpCountSession& operator=(OpCountSession const&) = delete;
+
+    ~OpCountSession()
+        {
+        if(started_) opCounter().disable();
+        }
+    };
+
+} //namespace itensor
+
+#endif
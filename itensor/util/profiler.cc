@@ -0,0 +1,307 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <ostream>
+#include "itensor/util/profiler.h"
+#include "itensor/util/error.h"
+#include "itensor/util/print.h"
+#include "itensor/util/range.h"
+
+namespace itensor {
+
+namespace {
+
+//Tree of a region merged over threads
+struct MergedNode
+    {
+    int region = -1;
+    Profiler::Stats stats;
+    std::vector<MergedNode> children;
+    };
+
+MergedNode&
+child(MergedNode& n, int region)
+    {
+    for(auto& c : n.children) if(c.region == region) return c;
+    n.children.emplace_back();
+    n.children.back().region = region;
+    return n.children.back();
+    }
+
+void
+addStats(Profiler::Stats& to, Profiler::Stats const& s)
+    {
+    to.calls += s.calls;
+    to.inclusive += s.inclusive;
+    to.exclusive += s.exclusive;
+    to.bytes += s.bytes;
+    }
+
+std::string
+jsonString(std::string const& s)
+    {
+    auto r = std::string("\"");
+    for(auto c : s)
+        {
+        if(c == '"' || c == '\\') r += '\\';
+        r += c;
+        }
+    return r + "\"";
+    }
+
+//Removes regions not entered since the last reset
+//(keeping those with nested regions which were)
+bool
+prune(MergedNode& n)
+    {
+    auto keep = std::vector<MergedNode>();
+    for(auto& c : n.children)
+        {
+        if(!prune(c)) keep.push_back(std::move(c));
+        }
+    n.children.swap(keep);
+    return n.stats.calls == 0 && n.children.empty();
+    }
+
+void
+writeNode(std::ostream& s,
+          MergedNode const& n,
+          std::vector<std::string> const& names)
+    {
+    s << "{\"name\":" << jsonString(names.at(n.region))
+      << format(",\"calls\":%d,\"inclusive\":%.6e,\"exclusive\":%.6e,\"bytes\":%.6e",
+                n.stats.calls,n.stats.inclusive,n.stats.exclusive,n.stats.bytes);
+    if(!n.children.empty())
+        {
+        s << ",\"children\":[";
+        for(auto& c : n.children)
+            {
+            if(&c != &n.children.front()) s << ",";
+            writeNode(s,c,names);
+            }
+        s << "]";
+        }
+    s << "}";
+    }
+
+} //namespace
+
+Profiler::
+Profiler()
+  : enabled_(false),
+    reset_time_(clock_type::now())
+    {
+    auto fname = std::getenv("ITENSOR_PROFILE");
+    if(fname && *fname) enable(fname);
+    }
+
+Profiler&
+profiler()
+    {
+    static Profiler p;
+    return p;
+    }
+
+void Profiler::
+enable(std::string const& fname)
+    {
+        {
+        std::lock_guard<std::mutex> lock(m_);
+        if(!fname.empty()) file_ = fname;
+        }
+    enabled_ = true;
+    }
+
+std::string Profiler::
+file() const
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    return file_;
+    }
+
+void Profiler::
+setFile(std::string const& fname)
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    file_ = fname;
+    }
+
+int Profiler::
+region(std::string const& name)
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    for(auto n : range(names_))
+        {
+        if(names_[n] == name) return n;
+        }
+    names_.push_back(name);
+    return names_.size()-1;
+    }
+
+std::string Profiler::
+name(int region) const
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    return names_.at(region);
+    }
+
+Profiler::ThreadLog& Profiler::
+threadLog()
+    {
+    //Logs are owned by the profiler so that
+    //they outlive the threads writing them
+    thread_local ThreadLog* log = nullptr;
+    if(!log)
+        {
+        auto l = std::make_shared<ThreadLog>();
+        l->nodes.emplace_back();
+        std::lock_guard<std::mutex> lock(m_);
+        logs_.push_back(l);
+        log = l.get();
+        }
+    return *log;
+    }
+
+void Profiler::
+enter(int region, size_t bytes)
+    {
+    auto& t = threadLog();
+    std::lock_guard<std::mutex> lock(t.m);
+    auto parent = t.stack.empty() ? 0 : t.stack.back().node;
+    auto node = -1;
+    for(auto c : t.nodes[parent].children)
+        {
+        if(t.nodes[c].region == region) { node = c; break; }
+        }
+    if(node < 0)
+        {
+        node = t.nodes.size();
+        t.nodes.emplace_back();
+        t.nodes.back().region = region;
+        t.nodes[parent].children.push_back(node);
+        }
+    auto f = Frame();
+    f.node = node;
+    f.bytes = bytes;
+    f.start = clock_type::now();
+    t.stack.push_back(f);
+    }
+
+void Profiler::
+exit()
+    {
+    auto end = clock_type::now();
+    auto& t = threadLog();
+    std::lock_guard<std::mutex> lock(t.m);
+    if(t.stack.empty()) Error("Profiler::exit called without matching enter");
+    auto f = t.stack.back();
+    t.stack.pop_back();
+    auto incl = std::chrono::duration<double>(end-f.start).count();
+    auto& s = t.nodes[f.node].stats;
+    s.calls += 1;
+    s.inclusive += incl;
+    s.exclusive += incl-f.children;
+    s.bytes += f.bytes;
+    if(!t.stack.empty()) t.stack.back().children += incl;
+    }
+
+Profiler::Stats Profiler::
+stats(std::vector<std::string> const& path) const
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    auto res = Stats();
+    for(auto& l : logs_)
+        {
+        std::lock_guard<std::mutex> llock(l->m);
+        auto node = 0;
+        for(auto& name : path)
+            {
+            auto next = -1;
+            for(auto c : l->nodes[node].children)
+                {
+                if(names_[l->nodes[c].region] == name) { next = c; break; }
+                }
+            node = next;
+            if(node < 0) break;
+            }
+        if(node > 0) addStats(res,l->nodes[node].stats);
+        }
+    return res;
+    }
+
+void Profiler::
+reset()
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    //Regions still open keep their place in the tree
+    //and are counted in full when they are exited
+    for(auto& l : logs_)
+        {
+        std::lock_guard<std::mutex> llock(l->m);
+        for(auto& n : l->nodes) n.stats = Stats();
+        }
+    reset_time_ = clock_type::now();
+    }
+
+void Profiler::
+writeJSON(std::ostream& s, std::string const& label) const
+    {
+    auto root = MergedNode();
+    auto nthread = 0;
+    auto elapsed = 0.;
+    auto names = std::vector<std::string>();
+        {
+        std::lock_guard<std::mutex> lock(m_);
+        names = names_;
+        elapsed = std::chrono::duration<double>(clock_type::now()-reset_time_).count();
+        for(auto& l : logs_)
+            {
+            std::lock_guard<std::mutex> llock(l->m);
+            auto used = false;
+            std::function<void(int,MergedNode&)> merge = 
+                [&](int n, MergedNode& m)
+                {
+                for(auto c : l->nodes[n].children)
+                    {
+                    auto& st = l->nodes[c].stats;
+                    if(st.calls > 0) used = true;
+                    auto& mc = child(m,l->nodes[c].region);
+                    addStats(mc.stats,st);
+                    merge(c,mc);
+                    }
+                };
+            merge(0,root);
+            if(used) ++nthread;
+            }
+        }
+
+    prune(root);
+
+    s << "{";
+    if(!label.empty()) s << "\"label\":" << jsonString(label) << ",";
+    s << format("\"elapsed\":%.6e,\"threads\":%d,\"regions\":[",elapsed,nthread);
+    for(auto& c : root.children)
+        {
+        if(&c != &root.children.front()) s << ",";
+        writeNode(s,c,names);
+        }
+    s << "]}";
+    }
+
+void Profiler::
+dump(std::string const& label)
+    {
+    auto fname = file();
+    if(fname.empty()) return;
+    std::ofstream f(fname,std::ios::app);
+    if(!f) throw ITError("Couldn't open profile file \"" + fname + "\"");
+    writeJSON(f,label);
+    f << "\n";
+    reset();
+    }
+
+} //namespace itensor
@@ -0,0 +1,222 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_PROFILER_H
+#define __ITENSOR_PROFILER_H
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "itensor/util/eventtrace.h"
+
+#define ITENSOR_PROFILE_CAT_(A,B) A##B
+#define ITENSOR_PROFILE_CAT(A,B) ITENSOR_PROFILE_CAT_(A,B)
+
+//Times the rest of the enclosing scope as region NAME
+#define PROFILE_SCOPE(NAME) PROFILE_SCOPE_BYTES(NAME,0)
+
+//Same as PROFILE_SCOPE, also counting BYTES bytes
+//touched (only evaluated when profiling or event
+//tracing is enabled)
+#define PROFILE_SCOPE_BYTES(NAME,BYTES) \
+    static const int ITENSOR_PROFILE_CAT(profile_region_,__LINE__) = itensor::profiler().region(NAME); \
+    itensor::ProfileScope ITENSOR_PROFILE_CAT(profile_scope_,__LINE__)(ITENSOR_PROFILE_CAT(profile_region_,__LINE__),[&]() { return size_t(BYTES); });
+
+namespace itensor {
+
+//
+// Hierarchical profiler.
+//
+// Regions are marked with PROFILE_SCOPE("name"). Each
+// thread records its own tree of nested regions and
+// for every call path the profiler keeps the number
+// of calls, the inclusive and exclusive (not counting
+// nested regions) wall time and the bytes touched.
+// Trees of different threads are merged by call path
+// when written out.
+//
+// Profiling is compiled in but off unless enabled at
+// runtime, either by setting the environment variable
+// ITENSOR_PROFILE to the name of an output file or by
+// calling profiler().enable(fname). dmrg also enables it
+// during the call for the "ProfileFile" arg (see
+// ProfileSession below) and, while it is enabled, writes
+// one line of JSON to the file at the end of each sweep.
+//
+// The same regions also mark begin/end events for the
+// event tracer (see util/eventtrace.h).
+//
+class Profiler
+    {
+    public:
+    using clock_type = std::chrono::steady_clock;
+
+    struct Stats
+        {
+        long calls = 0;
+        double inclusive = 0, //seconds
+               exclusive = 0;
+        double bytes = 0;
+        };
+    private:
+    struct Node
+        {
+        int region = -1;
+        std::vector<int> children;
+        Stats stats;
+        };
+    struct Frame
+        {
+        int node = 0;
+        clock_type::time_point start;
+        double children = 0;
+        size_t bytes = 0;
+        };
+    struct ThreadLog
+        {
+        std::mutex m;
+        std::vector<Node> nodes; //nodes[0] is the root
+        std::vector<Frame> stack;
+        };
+    std::atomic<bool> enabled_;
+    mutable std::mutex m_;
+    std::string file_;
+    std::vector<std::string> names_;
+    std::vector<std::shared_ptr<ThreadLog>> logs_;
+    clock_type::time_point reset_time_;
+    public:
+
+    Profiler();
+
+    Profiler(Profiler const&) = delete;
+    Profiler& operator=(Profiler const&) = delete;
+
+    bool
+    enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    //fname is where dump writes to
+    void
+    enable(std::string const& fname = "");
+
+    void
+    disable() { enabled_ = false; }
+
+    std::string
+    file() const;
+
+    //Sets the file dump writes to (none if empty)
+    void
+    setFile(std::string const& fname);
+
+    //Id of the region called name
+    int
+    region(std::string const& name);
+
+    //Name of the region with id region
+    std::string
+    name(int region) const;
+
+    void
+    enter(int region, size_t bytes = 0);
+
+    void
+    exit();
+
+    //Statistics of the call path made of the given region
+    //names, summed over threads (zero if never entered)
+    Stats
+    stats(std::vector<std::string> const& path) const;
+
+    //Zeroes all statistics
+    void
+    reset();
+
+    //Writes the statistics as a JSON object; a non-empty
+    //label is included as the field "label"
+    void
+    writeJSON(std::ostream& s, std::string const& label = "") const;
+
+    //Appends one line of JSON to file() and resets.
+    //Does nothing if file() is empty.
+    void
+    dump(std::string const& label = "");
+
+    private:
+
+    ThreadLog&
+    threadLog();
+    };
+
+Profiler&
+profiler();
+
+class ProfileScope
+    {
+    int region_ = -1;
+    bool profile_ = false,
+         trace_ = false;
+    public:
+
+    template<typename BytesFunc>
+    ProfileScope(int region, BytesFunc&& bytes)
+      : region_(region),
+        profile_(profiler().enabled()),
+        trace_(eventTracer().active())
+        {
+        if(!profile_ && !trace_) return;
+        auto b = bytes();
+        if(profile_) profiler().enter(region,b);
+        if(trace_) eventTracer().begin(region,b);
+        }
+
+    ProfileScope(ProfileScope const&) = delete;
+    ProfileScope& operator=(ProfileScope const&) = delete;
+
+    ~ProfileScope() 
+        { 
+        if(trace_) eventTracer().end(region_);
+        if(profile_) profiler().exit(); 
+        }
+    };
+
+//
+// Enables the profiler, writing to fname, for the
+// lifetime of this object if fname is not empty,
+// then restores its previous state and file
+//
+class ProfileSession
+    {
+    bool started_ = false,
+         was_enabled_ = false;
+    std::string prev_file_;
+    public:
+
+    explicit
+    ProfileSession(std::string const& fname)
+        {
+        if(fname.empty()) return;
+        was_enabled_ = profiler().enabled();
+        prev_file_ = profiler().file();
+        profiler().enable(fname);
+        started_ = true;
+        }
+
+    ProfileSession(ProfileSession const&) = delete;
+    ProfileSession& operator=(ProfileSession const&) = delete;
+
+    ~ProfileSession()
+        {
+        if(!started_) return;
+        profiler().setFile(prev_file_);
+        if(!was_enabled_) profiler().disable();
+        }
+    };
+
+} //namespace itensor
+
+#endif
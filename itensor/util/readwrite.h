@@ -5,6 +5,7 @@
 #ifndef __ITENSOR_READWRITE_H_
 #define __ITENSOR_READWRITE_H_
 
+#include <cstdlib>
 #include <fstream>
 #include <memory>
 #include <vector>
@@ -25,6 +26,7 @@ mkdtemp(char *templat)
     return retval;
     }
 #else
+#include <ftw.h>
 #include <unistd.h>
 #endif
 
@@ -330,6 +332,19 @@ writeToFile(const std::string& fname, const T& t)
     s.close(); 
     }
 
+//Copies the contents of file from to file to
+void inline
+copyFile(const std::string& from,
+         const std::string& to)
+    {
+    std::ifstream in(from.c_str(),std::ios::binary);
+    if(!in) throw ITError("Couldn't open file \"" + from + "\" for reading");
+    std::ofstream out(to.c_str(),std::ios::binary);
+    if(!out) throw ITError("Couldn't open file \"" + to + "\" for writing");
+    out << in.rdbuf();
+    if(!out) throw ITError("Error writing file \"" + to + "\"");
+    }
+
 //Given a prefix (e.g. pfix == "mydir")
 //and an optional location (e.g. locn == "/var/tmp/")
 //creates a temporary directory and returns its name
@@ -361,6 +376,53 @@ mkTempDir(const std::string& pfix,
     return final_dirname;
     }
 
+//Deletes the directory dir and everything in it
+void inline
+removeTree(std::string const& dir)
+    {
+#if defined(_WIN32)
+    system(("rd /s /q \"" + dir + "\"").c_str());
+#else
+    //FTW_DEPTH visits the contents of a directory
+    //before the directory itself; FTW_PHYS does not
+    //follow symbolic links
+    auto remove_entry = [](const char* path, const struct stat*, int, struct FTW*)
+        {
+        return ::remove(path);
+        };
+    nftw(dir.c_str(),remove_entry,16,FTW_DEPTH|FTW_PHYS);
+#endif
+    }
+
+//Temporary directory made by mkTempDir which is
+//deleted, with its contents, when destroyed.
+//Hold by shared_ptr to share it: the last
+//holder deletes the directory.
+class TempDir
+    {
+    std::string name_,
+                locn_;
+    public:
+
+    TempDir(std::string const& pfix,
+            std::string const& locn = "./")
+      : name_(mkTempDir(pfix,locn)),
+        locn_(locn)
+        { }
+
+    TempDir(TempDir const&) = delete;
+    TempDir& operator=(TempDir const&) = delete;
+
+    ~TempDir() { removeTree(name_); }
+
+    std::string const&
+    name() const { return name_; }
+
+    //Directory containing this one
+    std::string const&
+    location() const { return locn_; }
+    };
+
 } // namespace itensor
 
 #endif
@@ -0,0 +1,227 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include "itensor/util/tensorstats.h"
+
+namespace itensor {
+
+namespace {
+
+const char trace_magic[] = "ITCTRACE";
+const int trace_version = 1;
+
+using SectorTable = std::vector<TStats::Ind>;
+
+void
+writeSectors(std::ostream& s, TStats::Ind const& i)
+    {
+    itensor::write(s,i.dir);
+    itensor::write(s,i.sector_dims);
+    itensor::write(s,i.sector_qns);
+    }
+
+void
+readSectors(std::istream& s, TStats::Ind& i)
+    {
+    itensor::read(s,i.dir);
+    itensor::read(s,i.sector_dims);
+    itensor::read(s,i.sector_qns);
+    }
+
+//The arrow and sectors of each IQIndex are written
+//in full only the first time, then by id
+void
+writeTens(std::ostream& s, 
+          TStats::Tens const& t, 
+          bool blocksparse,
+          std::map<std::string,int>& sectors)
+    {
+    itensor::write(s,t.cplx);
+    itensor::write(s,int(t.inds.size()));
+    for(auto& i : t.inds)
+        {
+        itensor::write(s,i.label);
+        itensor::write(s,i.dim);
+        if(!blocksparse) continue;
+        std::ostringstream os;
+        writeSectors(os,i);
+        auto key = os.str();
+        auto it = sectors.find(key);
+        if(it != sectors.end())
+            {
+            itensor::write(s,it->second);
+            }
+        else
+            {
+            itensor::write(s,int(sectors.size()));
+            sectors.emplace(key,sectors.size());
+            s.write(key.data(),key.size());
+            }
+        }
+    if(blocksparse) itensor::write(s,t.blocks);
+    }
+
+void
+readTens(std::istream& s, 
+         TStats::Tens& t, 
+         bool blocksparse,
+         SectorTable& sectors)
+    {
+    itensor::read(s,t.cplx);
+    auto r = 0;
+    itensor::read(s,r);
+    t.inds.resize(r);
+    for(auto& i : t.inds)
+        {
+        itensor::read(s,i.label);
+        itensor::read(s,i.dim);
+        if(!blocksparse) continue;
+        auto id = 0;
+        itensor::read(s,id);
+        if(id == int(sectors.size()))
+            {
+            sectors.emplace_back();
+            readSectors(s,sectors.back());
+            }
+        auto& S = sectors.at(id);
+        i.dir = S.dir;
+        i.sector_dims = S.sector_dims;
+        i.sector_qns = S.sector_qns;
+        }
+    if(blocksparse) itensor::read(s,t.blocks);
+    }
+
+void
+printTens(std::ostream& s, const char* name, TStats::Tens const& t)
+    {
+    s << format("%s (%d) [ ",name,t.inds.size());
+    for(auto& i : t.inds) s << i.dim << " ";
+    s << "] { ";
+    for(auto& i : t.inds) s << i.label << " ";
+    s << "}";
+    if(!t.blocks.empty()) s << format(" %d blocks",t.blocks.size());
+    if(t.cplx) s << " complex";
+    s << "\n";
+    }
+
+} //namespace
+
+TStats::Tens
+tstatsTens(IndexSet const& is,
+           Labels const& labels,
+           bool cplx)
+    {
+    auto t = TStats::Tens();
+    t.cplx = cplx;
+    for(auto n : range(is.r()))
+        {
+        auto ind = TStats::Ind();
+        ind.label = labels[n];
+        ind.dim = is[n].m();
+        t.inds.push_back(std::move(ind));
+        }
+    return t;
+    }
+
+std::ostream&
+operator<<(std::ostream& s, TStats const& T)
+    {
+    printTens(s,"A",T.A);
+    printTens(s,"B",T.B);
+    printTens(s,"C",T.C);
+    s << format("time = %.3E s",T.time);
+    return s;
+    }
+
+ContractTrace::
+ContractTrace()
+  : active_(false)
+    {
+    auto fname = std::getenv("ITENSOR_CONTRACT_TRACE");
+    if(fname && *fname) start(fname);
+    }
+
+ContractTrace&
+contractTrace()
+    {
+    static ContractTrace t;
+    return t;
+    }
+
+void ContractTrace::
+start(std::string const& fname)
+    {
+    stop();
+    std::lock_guard<std::mutex> lock(m_);
+    f_.open(fname,std::ios::binary);
+    if(!f_) throw ITError("Couldn't open contraction trace file \"" + fname + "\"");
+    f_.write(trace_magic,sizeof(trace_magic)-1);
+    itensor::write(f_,trace_version);
+    nrecord_ = 0;
+    sectors_.clear();
+    active_ = true;
+    }
+
+void ContractTrace::
+stop()
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    active_ = false;
+    if(f_.is_open()) f_.close();
+    }
+
+long ContractTrace::
+size()
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    return nrecord_;
+    }
+
+void ContractTrace::
+record(TStats const& t)
+    {
+    std::lock_guard<std::mutex> lock(m_);
+    //May have been stopped since the caller checked
+    if(!f_.is_open()) return;
+    itensor::write(f_,t.blocksparse);
+    writeTens(f_,t.A,t.blocksparse,sectors_);
+    writeTens(f_,t.B,t.blocksparse,sectors_);
+    writeTens(f_,t.C,t.blocksparse,sectors_);
+    itensor::write(f_,t.time);
+    ++nrecord_;
+    }
+
+std::vector<TStats>
+readContractTrace(std::string const& fname)
+    {
+    std::ifstream f(fname,std::ios::binary);
+    if(!f) throw ITError("Couldn't open contraction trace file \"" + fname + "\"");
+    char magic[sizeof(trace_magic)-1];
+    f.read(magic,sizeof(magic));
+    auto version = 0;
+    itensor::read(f,version);
+    if(!f || std::memcmp(magic,trace_magic,sizeof(magic)) != 0 || version != trace_version)
+        {
+        throw ITError("File \"" + fname + "\" is not a contraction trace");
+        }
+    auto res = std::vector<TStats>();
+    auto sectors = SectorTable();
+    while(f.peek() != std::ifstream::traits_type::eof())
+        {
+        res.emplace_back();
+        auto& t = res.back();
+        itensor::read(f,t.blocksparse);
+        readTens(f,t.A,t.blocksparse,sectors);
+        readTens(f,t.B,t.blocksparse,sectors);
+        readTens(f,t.C,t.blocksparse,sectors);
+        itensor::read(f,t.time);
+        if(!f) throw ITError("Contraction trace \"" + fname + "\" is truncated");
+        }
+    return res;
+    }
+
+} //namespace itensor
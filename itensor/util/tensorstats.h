@@ -5,157 +5,151 @@
 #ifndef __ITENSOR_TENSORSTATS_H
 #define __ITENSOR_TENSORSTATS_H
 
-#include <cmath>
-#include "itensor/util/stdx.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <mutex>
 #include "itensor/util/print.h"
-#include "itensor/itensor_interface.h"
+#include "itensor/qn.h"
+#include "itensor/indexset.h"
+#include "itensor/tensor/contract.h"
 
-//#define COLLECT_TSTATS
-
-#ifdef COLLECT_TSTATS
 namespace itensor {
 
+//
+// Record of one ITensor or IQTensor contraction
+// C = A*B, as logged by ContractTrace.
+//
+// Indices are labeled as by computeLabels: contracted
+// indices have the same negative label in A and B,
+// uncontracted ones a unique positive label.
+// For block-sparse (QDense) tensors each index also
+// records its arrow and sectors, and each tensor its
+// non-zero blocks (block numbers as in QDense::offsets).
+//
 struct TStats
     {
-    using iarray = std::array<int,8>;
-
-    int Ar = 0;
-    int Br = 0;
-    int Cr = 0;
-    iarray Adims = iarray{};
-    iarray Alabs = iarray{};
-    iarray Bdims = iarray{};
-    iarray Blabs = iarray{};
-    iarray Cdims = iarray{};
-    iarray Clabs = iarray{};
-
-    TStats() { }
-
-    template<typename RangeT, typename VA, typename VB>
-    TStats(TenRefc<RangeT,VA> A, Labels const& ai, 
-           TenRefc<RangeT,VB> B, Labels const& bi, 
-           TenRef<RangeT,common_type<VA,VB>>  C, 
-           Labels const& ci)
+    struct Ind
         {
-        Ar = A.r();
-        for(auto n : range(Ar))
-            {
-            Adims[n] = A.extent(n);
-            Alabs[n] = ai[n];
-            }
-        Br = B.r();
-        for(auto n : range(Br))
-            {
-            Bdims[n] = B.extent(n);
-            Blabs[n] = bi[n];
-            }
-        Cr = C.r();
-        for(auto n : range(Cr))
+        int label = 0;
+        long dim = 0;
+        int dir = 0;
+        std::vector<long> sector_dims;
+        std::vector<QN> sector_qns;
+        };
+    struct Tens
+        {
+        bool cplx = false;
+        std::vector<Ind> inds;
+        std::vector<long> blocks;
+        };
+
+    bool blocksparse = false;
+    Tens A,B,C;
+    Real time = 0; //seconds
+    };
+
+TStats::Tens
+tstatsTens(IndexSet const& is,
+           Labels const& labels,
+           bool cplx);
+
+template<typename BlockOffsets>
+TStats::Tens
+tstatsTens(IQIndexSet const& is,
+           Labels const& labels,
+           BlockOffsets const& offsets,
+           bool cplx)
+    {
+    auto t = TStats::Tens();
+    t.cplx = cplx;
+    for(auto n : range(is.r()))
+        {
+        auto ind = TStats::Ind();
+        ind.label = labels[n];
+        ind.dim = is[n].m();
+        ind.dir = int(is[n].dir());
+        for(auto j : range1(is[n].nindex()))
             {
-            Cdims[n] = C.extent(n);
-            Clabs[n] = ci[n];
+            ind.sector_dims.push_back(is[n].index(j).m());
+            ind.sector_qns.push_back(is[n].qn(j));
             }
+        t.inds.push_back(std::move(ind));
         }
+    for(auto& bo : offsets) t.blocks.push_back(bo.block);
+    return t;
+    }
 
-    void
-    write(std::ostream & s) const;
-    void
-    read(std::istream & s);
+std::ostream&
+operator<<(std::ostream& s, TStats const& T);
 
-    };
-
-void inline TStats::
-write(std::ostream & s) const
+//
+// Logs every ITensor (Contract<Index>) and IQTensor
+// (Contract<IQIndex>) contraction to a binary trace file,
+// which can be read back with readContractTrace and replayed
+// with benchmark/replay.
+//
+// Recording is off unless the environment variable
+// ITENSOR_CONTRACT_TRACE is set to the name of the trace
+// file, or contractTrace().start(fname) is called.
+//
+class ContractTrace
     {
-    itensor::write(s,Ar);
-    itensor::write(s,Br);
-    itensor::write(s,Cr);
-    itensor::write(s,Adims);
-    itensor::write(s,Bdims);
-    itensor::write(s,Cdims);
-    itensor::write(s,Alabs);
-    itensor::write(s,Blabs);
-    itensor::write(s,Clabs);
-    }
+    public:
+    using clock_type = std::chrono::steady_clock;
+    private:
+    std::atomic<bool> active_;
+    std::mutex m_;
+    std::ofstream f_;
+    long nrecord_ = 0;
+    //Ids of the sector lists already written
+    std::map<std::string,int> sectors_;
+    public:
 
-void inline TStats::
-read(std::istream & s)
-    {
-    itensor::read(s,Ar);
-    itensor::read(s,Br);
-    itensor::read(s,Cr);
-    itensor::read(s,Adims);
-    itensor::read(s,Bdims);
-    itensor::read(s,Cdims);
-    itensor::read(s,Alabs);
-    itensor::read(s,Blabs);
-    itensor::read(s,Clabs);
-    }
+    ContractTrace();
 
-inline std::vector<TStats>&
-global_tstats()
-    {
-    static std::vector<TStats> gts;
-    return gts;
-    }
+    ContractTrace(ContractTrace const&) = delete;
+    ContractTrace& operator=(ContractTrace const&) = delete;
 
-template<typename... VArgs>
-void
-tstats(VArgs&&... vargs)
-    {
-    global_tstats().emplace_back(std::forward<VArgs&&>(vargs)...);
-    }
+    ~ContractTrace() { stop(); }
 
-inline std::ostream&
-operator<<(std::ostream& s, TStats const& T)
-    {
-    s << format("A (%d) [ ",T.Ar);
-    for(auto n : range(T.Ar)) s << T.Adims[n] << " ";
-    s << "] { ";
-    for(auto n : range(T.Ar)) s << T.Alabs[n] << " ";
-    s << "}\n";
-
-    s << format("B (%d) [ ",T.Br);
-    for(auto n : range(T.Br)) s << T.Bdims[n] << " ";
-    s << "] { ";
-    for(auto n : range(T.Br)) s << T.Blabs[n] << " ";
-    s << "}\n";
-
-    s << format("C (%d) [ ",T.Cr);
-    for(auto n : range(T.Cr)) s << T.Cdims[n] << " ";
-    s << "] { ";
-    for(auto n : range(T.Cr)) s << T.Clabs[n] << " ";
-    s << "}\n";
-
-    return s;
-    }
+    bool
+    active() const { return active_.load(std::memory_order_relaxed); }
 
-void inline
-doHistogram1(Real bucket_size = 0.5)
-    {
-    Real max_value = 10.;
-	int nbucket = (int)std::ceil(max_value/bucket_size);
-	auto histogram = std::vector<int>(nbucket);
-    //printfln("nbucket = %d",nbucket);
+    //Starts a new trace file, ending any current one
+    void
+    start(std::string const& fname);
 
-    for(auto& t : global_tstats())
-        {
-        Real logAdim = 0.;
-        for(auto n : range(t.Ar)) logAdim += std::log10(t.Adims[n]);
-		int bucket = (int)floor(logAdim/bucket_size);
-		//histogram[bucket] += 1;
-		histogram.at(bucket) += 1;
-        }
+    //Flushes and closes the trace file
+    void
+    stop();
+
+    //Number of records written to the current file
+    long
+    size();
+
+    void
+    record(TStats const& t);
 
-    std::ofstream f("hist.dat");
-    for(auto b : range(histogram))
+    //Records a contraction which began at time start
+    template<typename MakeStats>
+    void
+    record(clock_type::time_point start, MakeStats&& make)
         {
-        printfln(f,"%.12f %.12f",b*bucket_size,histogram[b]);
+        auto elapsed = std::chrono::duration<Real>(clock_type::now()-start).count();
+        auto t = make();
+        t.time = elapsed;
+        record(t);
         }
-    f.close();
-    }
+    };
+
+ContractTrace&
+contractTrace();
+
+std::vector<TStats>
+readContractTrace(std::string const& fname);
 
 } //namespace itensor
-#endif //COLLECT_TSTATS
 
 #endif
@@ -0,0 +1,205 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#include "itensor/util/threadpool.h"
+#include "itensor/tensor/lapack_wrap.h"
+
+namespace itensor {
+
+namespace {
+//Index of the pool worker running on this thread,
+//or -1 for threads not owned by a pool
+thread_local long this_worker = -1;
+thread_local ThreadPool const* this_pool = nullptr;
+}
+
+ThreadPool::
+ThreadPool(int nthread)
+  : npending_(0),
+    next_queue_(0)
+    {
+    auto nworker = std::max(nthread,1)-1;
+    for(auto w = 0; w < nworker; ++w)
+        {
+        queues_.emplace_back(new Queue);
+        }
+    for(auto w = 0; w < nworker; ++w)
+        {
+        workers_.emplace_back([this,w]() { workerLoop(w); });
+        }
+    }
+
+ThreadPool::
+~ThreadPool()
+    {
+        {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+        }
+    wake_.notify_all();
+    for(auto& t : workers_) t.join();
+    }
+
+void ThreadPool::
+submit(Task t)
+    {
+    if(workers_.empty())
+        {
+        t();
+        return;
+        }
+    //Workers push onto their own queue, other
+    //threads spread tasks over all queues
+    size_t q = 0;
+    if(this_pool == this) q = this_worker;
+    else                  q = (next_queue_++)%queues_.size();
+        {
+        std::lock_guard<std::mutex> lock(queues_[q]->m);
+        queues_[q]->tasks.push_back(std::move(t));
+        }
+        {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        ++npending_;
+        }
+    wake_.notify_one();
+    }
+
+bool ThreadPool::
+popTask(Task & t)
+    {
+    if(npending_ <= 0) return false;
+    auto nq = queues_.size();
+    auto first = (this_pool == this) ? size_t(this_worker) : size_t(0);
+    for(size_t j = 0; j < nq; ++j)
+        {
+        auto q = (first+j)%nq;
+        auto& Q = *queues_[q];
+        std::lock_guard<std::mutex> lock(Q.m);
+        if(Q.tasks.empty()) continue;
+        if(j == 0 && this_pool == this)
+            {
+            //own queue: newest first
+            t = std::move(Q.tasks.back());
+            Q.tasks.pop_back();
+            }
+        else
+            {
+            //steal: oldest first
+            t = std::move(Q.tasks.front());
+            Q.tasks.pop_front();
+            }
+        --npending_;
+        return true;
+        }
+    return false;
+    }
+
+void ThreadPool::
+workerLoop(size_t w)
+    {
+    this_worker = w;
+    this_pool = this;
+#ifdef PLATFORM_mkl
+    //Workers only run parts of parallel regions
+    mkl_set_num_threads_local(1);
+#endif
+    while(true)
+        {
+        Task t;
+        if(popTask(t))
+            {
+            t();
+            continue;
+            }
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock,[this]() { return stop_ || npending_ > 0; });
+        if(stop_ && npending_ <= 0) return;
+        }
+    }
+
+ThreadPool&
+threadPool()
+    {
+    static ThreadPool pool([]()
+        {
+        auto hw = int(std::thread::hardware_concurrency());
+        return int(Args::global().getInt("ThreadPoolSize",std::max(hw,1)));
+        }());
+    return pool;
+    }
+
+int
+getNThread(Args const& args,
+           int default_nthread)
+    {
+    return args.getInt("NThread",default_nthread);
+    }
+
+namespace detail {
+
+static thread_local int serial_depth = 0;
+
+int
+serialBLASDepth() { return serial_depth; }
+
+#if defined PLATFORM_mkl
+
+//MKL supports a per-thread setting, which only
+//needs to be made for the thread starting the region
+SerialBLAS::
+SerialBLAS()
+    {
+    ++serial_depth;
+    saved_ = mkl_set_num_threads_local(1);
+    }
+
+SerialBLAS::
+~SerialBLAS()
+    {
+    mkl_set_num_threads_local(saved_);
+    --serial_depth;
+    }
+
+#elif defined PLATFORM_openblas
+
+//OpenBLAS only has a process-wide setting: set it
+//when the first (outermost) region starts and
+//restore it once the last region exits
+static std::mutex openblas_mutex;
+static int openblas_nactive = 0;
+static int openblas_saved = 1;
+
+SerialBLAS::
+SerialBLAS()
+    {
+    ++serial_depth;
+    std::lock_guard<std::mutex> lock(openblas_mutex);
+    if(openblas_nactive++ == 0)
+        {
+        openblas_saved = openblas_get_num_threads();
+        openblas_set_num_threads(1);
+        }
+    }
+
+SerialBLAS::
+~SerialBLAS()
+    {
+    std::lock_guard<std::mutex> lock(openblas_mutex);
+    if(--openblas_nactive == 0) openblas_set_num_threads(openblas_saved);
+    --serial_depth;
+    }
+
+#else
+
+SerialBLAS::
+SerialBLAS() { ++serial_depth; }
+
+SerialBLAS::
+~SerialBLAS() { --serial_depth; }
+
+#endif
+
+} //namespace detail
+
+} //namespace itensor
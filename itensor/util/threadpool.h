@@ -0,0 +1,217 @@
+//
+// Distributed under the ITensor Library License, Version 1.2
+//    (See accompanying LICENSE file.)
+//
+#ifndef __ITENSOR_THREADPOOL_H
+#define __ITENSOR_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "itensor/util/args.h"
+
+namespace itensor {
+
+//
+// Persistent pool of worker threads shared by
+// all parallel code in the library.
+//
+// Each worker owns a task deque. A worker runs
+// its own tasks newest first and, when out of
+// work, steals the oldest task of another worker.
+//
+// Use parallelFor to run a loop; the calling
+// thread always takes part, so parallelFor may be
+// called from inside a task without deadlocking.
+//
+class ThreadPool
+    {
+    public:
+    using Task = std::function<void()>;
+    private:
+    struct Queue
+        {
+        std::mutex m;
+        std::deque<Task> tasks;
+        };
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<long> npending_;
+    std::atomic<size_t> next_queue_;
+    bool stop_ = false;
+    public:
+
+    //nthread counts the calling thread, so
+    //the pool starts nthread-1 workers
+    explicit
+    ThreadPool(int nthread);
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    ~ThreadPool();
+
+    //Maximum number of threads a parallelFor
+    //can use, including the calling thread
+    int
+    size() const { return 1+workers_.size(); }
+
+    void
+    submit(Task t);
+
+    //Calls f(i) for i = 0,1,...,n-1 using at most
+    //nthread threads and returns once all calls
+    //have completed. Indices are handed out one at
+    //a time, so put expensive items first.
+    //An exception thrown by f is rethrown here.
+    template<typename Callable>
+    void
+    parallelFor(size_t n,
+                int nthread,
+                Callable const& f);
+
+    private:
+
+    bool
+    popTask(Task & t);
+
+    void
+    workerLoop(size_t w);
+    };
+
+//Pool used throughout the library. Created on first
+//use with Global::args() "ThreadPoolSize" threads
+//(default: std::thread::hardware_concurrency()).
+ThreadPool&
+threadPool();
+
+//Number of threads a parallel region should use:
+//args "NThread" if defined (also looked up in
+//Global::args()), otherwise default_nthread, so
+//that threading is opt-in.
+int
+getNThread(Args const& args = Args::global(),
+           int default_nthread = 1);
+
+//Calls f(i) for i = 0,...,n-1 on the shared pool
+template<typename Callable>
+void
+parallelFor(size_t n,
+            int nthread,
+            Callable const& f)
+    {
+    threadPool().parallelFor(n,nthread,f);
+    }
+
+namespace detail {
+
+//While alive, restricts the BLAS library to one thread
+//so that parallel regions do not oversubscribe the
+//cores (MKL and OpenBLAS; no-op otherwise).
+//Created once by the thread starting a parallel region;
+//pool workers always run BLAS on one thread.
+class SerialBLAS
+    {
+    public:
+    SerialBLAS();
+    ~SerialBLAS();
+    SerialBLAS(SerialBLAS const&) = delete;
+    SerialBLAS& operator=(SerialBLAS const&) = delete;
+    private:
+    //BLAS thread setting to restore (MKL only);
+    //kept per object so nested regions restore
+    //the value they found
+    int saved_ = 0;
+    };
+
+//Number of SerialBLAS objects alive on this thread
+int
+serialBLASDepth();
+
+struct ParallelForState
+    {
+    std::atomic<size_t> next;
+    std::atomic<size_t> ndone;
+    size_t n = 0;
+    std::mutex m;
+    std::condition_variable done;
+    std::exception_ptr error;
+
+    ParallelForState(size_t n_) : next(0), ndone(0), n(n_) { }
+
+    //Claims and runs indices until none are left
+    template<typename Callable>
+    void
+    work(Callable const& f)
+        {
+        for(auto i = next++; i < n; i = next++)
+            {
+            try
+                {
+                f(i);
+                }
+            catch(...)
+                {
+                std::lock_guard<std::mutex> lock(m);
+                if(!error) error = std::current_exception();
+                }
+            if(++ndone == n)
+                {
+                std::lock_guard<std::mutex> lock(m);
+                done.notify_all();
+                }
+            }
+        }
+
+    //Blocks until every index has been run
+    void
+    wait()
+        {
+        std::unique_lock<std::mutex> lock(m);
+        done.wait(lock,[this]() { return ndone == n; });
+        }
+    };
+
+} //namespace detail
+
+template<typename Callable>
+void ThreadPool::
+parallelFor(size_t n,
+            int nthread,
+            Callable const& f)
+    {
+    if(n == 0) return;
+    if(nthread <= 1 || n == 1 || workers_.empty())
+        {
+        for(size_t i = 0; i < n; ++i) f(i);
+        return;
+        }
+
+    detail::SerialBLAS sb;
+    auto state = std::make_shared<detail::ParallelForState>(n);
+    auto nhelp = std::min(std::min(size_t(nthread),n),size_t(size()))-1;
+    auto* pf = &f;
+    for(size_t h = 0; h < nhelp; ++h)
+        {
+        //A helper starting after all indices are
+        //claimed returns without touching f
+        submit([state,pf]() { state->work(*pf); });
+        }
+    state->work(f);
+    //Indices not yet done are being run by helpers
+    //already started, so just wait for them
+    state->wait();
+    if(state->error) std::rethrow_exception(state->error);
+    }
+
+} //namespace itensor
+
+#endif
@@ -0,0 +1,67 @@
+#include "itensor/all.h"
+#include "itensor/mps/parallel_dmrg.h"
+
+using namespace itensor;
+
+//
+// Real-space parallel DMRG; build with "make parallel_dmrg"
+// and run with, for example, "mpirun -np 3 ./parallel_dmrg"
+//
+int
+main(int argc, char* argv[])
+    {
+    Environment env(argc,argv);
+
+    int N = 16;
+
+    auto sites = SpinHalf(N);
+
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+
+    auto state = InitState(sites);
+    for(int i = 1; i <= N; ++i)
+        {
+        if(i%2 == 1)
+            state.set(i,"Up");
+        else
+            state.set(i,"Dn");
+        }
+
+    //
+    // Every node needs an MPS and MPO with N sites,
+    // but only those of the first node are used
+    //
+    auto psi = IQMPS(state);
+
+    auto sweeps = Sweeps(8);
+    sweeps.maxm() = 10,20,100,100,200;
+    sweeps.cutoff() = 1E-10;
+    sweeps.niter() = 2;
+    sweeps.noise() = 1E-7,1E-8,0.0;
+
+    auto energy = parallelDmrg(psi,H,sweeps,env,{"Quiet",true});
+
+    //
+    // The optimized MPS is gathered on the first node,
+    // where it can be compared to serial DMRG
+    //
+    if(env.firstNode())
+        {
+        printfln("\nParallel DMRG energy = %.10f",energy);
+        printfln("Using overlap = %.10f", overlap(psi,H,psi) );
+
+        auto spsi = IQMPS(state);
+        auto senergy = dmrg(spsi,H,sweeps,{"Quiet",true});
+        printfln("Serial DMRG energy = %.10f",senergy);
+        printfln("Difference = %.2E",energy-senergy);
+        }
+
+    return 0;
+    }
@@ -1,3 +1,4 @@
+#include <sstream>
 #include "test.h"
 #include "itensor/decomp.h"
 #include "itensor/util/print_macro.h"
@@ -29,6 +30,116 @@ SECTION("Transpose SVD")
     CHECK(norm(A-U*D*V) < 1E-12);
     }
 
+SECTION("SVDMethod")
+    {
+    auto i = Index("i",10),
+         j = Index("j",4),
+         k = Index("k",6);
+    auto A = randomTensorC(i,j,k);
+    for(auto method : {"DensityMatrix","gesdd","gesvd"})
+        {
+        ITensor U(i,k),D,V;
+        svd(A,U,D,V,{"SVDMethod",method});
+        CHECK(norm(A-U*D*V) < 1E-12);
+        }
+    }
+
+SECTION("Randomized SVD")
+    {
+    auto l = Index("l",60),
+         s1 = Index("s1",2,Site),
+         s2 = Index("s2",2,Site),
+         r = Index("r",30);
+    auto AA = randomTensor(l,s1,s2,r);
+    auto args = Args("Maxm",4,"Cutoff",1E-12,"RandomizedSVD",true);
+
+    SECTION("ITensor")
+        {
+        ITensor U(l,s1),D,V;
+        auto spec = svd(AA,U,D,V,args);
+        CHECK(commonIndex(U,D).m() == 4);
+        //The truncation error accounts for
+        //the singular values not computed
+        auto err = sqr(norm(AA-U*D*V)/norm(AA));
+        CHECK(std::fabs(err-spec.truncerr()) < 1E-12);
+
+        auto fullargs = args;
+        fullargs.add("RandomizedSVD",false);
+        U = ITensor(l,s1);
+        auto fullspec = svd(AA,U,D,V,fullargs);
+        CHECK(spec.truncerr() >= fullspec.truncerr()-1E-12);
+        CHECK(spec.truncerr() < 1.05*fullspec.truncerr());
+        }
+
+    SECTION("denmatDecomp")
+        {
+        ITensor A(l,s1),B;
+        auto spec = denmatDecomp(AA,A,B,Fromleft,args);
+        CHECK(commonIndex(A,B).m() == 4);
+        auto err = sqr(norm(AA-A*B)/norm(AA));
+        CHECK(std::fabs(err-spec.truncerr()) < 1E-12);
+        }
+
+    SECTION("Partial denmatDecomp")
+        {
+        //Maxm too large for randomizedSVD: uses
+        //a partial diagonalization instead
+        auto pargs = Args("Maxm",30,"Cutoff",1E-12);
+        ITensor A(l,s1),B;
+        auto spec = denmatDecomp(AA,A,B,Fromleft,pargs);
+        CHECK(commonIndex(A,B).m() == 30);
+        auto err = sqr(norm(AA-A*B)/norm(AA));
+        CHECK(std::fabs(err-spec.truncerr()) < 1E-12);
+
+        ITensor U(l,s1),D,V;
+        auto svdspec = svd(AA,U,D,V,pargs);
+        CHECK(std::fabs(svdspec.truncerr()-spec.truncerr()) < 1E-10);
+        }
+
+    SECTION("IQTensor")
+        {
+        auto L = IQIndex("L",Index("L+",60),QN(+1),
+                             Index("L-",40),QN(-1));
+        auto R = IQIndex("R",Index("R+",70),QN(+1),
+                             Index("R-",50),QN(-1));
+        auto T = randomTensor(QN(),L,dag(R));
+        IQTensor U(L),D,V;
+        auto spec = svd(T,U,D,V,args);
+        CHECK(commonIndex(U,D).m() == 4);
+        auto err = sqr(norm(T-U*D*V)/norm(T));
+        CHECK(std::fabs(err-spec.truncerr()) < 1E-12);
+        }
+
+    SECTION("Threaded IQTensor")
+        {
+        //Blocks are factorized in parallel, each
+        //drawing its own random start matrix
+        auto L = IQIndex("L",Index("L+2",50),QN(+2),
+                             Index("L+1",60),QN(+1),
+                             Index("L0",70),QN(0),
+                             Index("L-1",60),QN(-1));
+        auto R = IQIndex("R",Index("R+2",40),QN(+2),
+                             Index("R+1",50),QN(+1),
+                             Index("R0",60),QN(0),
+                             Index("R-1",50),QN(-1));
+        auto T = randomTensor(QN(),L,dag(R));
+        auto targs = args;
+        targs.add("Maxm",8);
+        targs.add("NThread",4);
+        IQTensor U(L),D,V;
+        auto spec = svd(T,U,D,V,targs);
+        CHECK(commonIndex(U,D).m() == 8);
+        auto err = sqr(norm(T-U*D*V)/norm(T));
+        CHECK(std::fabs(err-spec.truncerr()) < 1E-12);
+
+        IQTensor A(L),B;
+        spec = denmatDecomp(T,A,B,Fromleft,targs);
+        CHECK(commonIndex(A,B).m() == 8);
+        err = sqr(norm(T-A*B)/norm(T));
+        CHECK(std::fabs(err-spec.truncerr()) < 1E-12);
+        }
+    }
+
 SECTION("Truncate Test")
     {
     size_t origm = 20;
@@ -193,6 +304,125 @@ SECTION("IQTensor SVD")
         CHECK(norm(psi-A*D*B) < 1E-12);
         }
 
+    SECTION("Parallel Blocks")
+        {
+        //Blocks of different, non-square sizes
+        auto u = IQIndex("u",Index("u+2",7),QN(+2),
+                             Index("u+1",3),QN(+1),
+                             Index("u 0",12),QN( 0),
+                             Index("u-1",5),QN(-1),
+                             Index("u-2",2),QN(-2));
+        auto v = IQIndex("v",Index("v+2",4),QN(+2),
+                             Index("v+1",9),QN(+1),
+                             Index("v 0",6),QN( 0),
+                             Index("v-1",5),QN(-1),
+                             Index("v-2",8),QN(-2));
+        auto S = randomTensor(QN(),u,dag(v));
+        IQTensor U(u),D,V;
+        svd(S,U,D,V,{"NThread",4});
+        CHECK(norm(S-U*D*V) < 1E-12);
+
+        //Truncation compares singular values across blocks
+        U = IQTensor(u);
+        auto spec = svd(S,U,D,V,{"NThread",4,"Maxm",10});
+        CHECK(spec.eigsKept().size() == 10);
+        CHECK(commonIndex(U,D).m() == 10);
+        }
+
+    SECTION("Spectrum Read/Write")
+        {
+        auto u = IQIndex("u",Index("u+1",3),QN(+1),
+                             Index("u 0",4),QN( 0),
+                             Index("u-1",2),QN(-1));
+        auto v = IQIndex("v",Index("v+1",2),QN(+1),
+                             Index("v 0",5),QN( 0),
+                             Index("v-1",3),QN(-1));
+        auto S = randomTensor(QN(),u,dag(v));
+        IQTensor U(u),D,V;
+        auto spec = svd(S,U,D,V,{"Maxm",5,"ComputeQNs",true});
+        CHECK(spec.hasQNs());
+
+        std::stringstream ss;
+        spec.write(ss);
+        Spectrum rspec;
+        rspec.read(ss);
+        CHECK(rspec.numEigsKept() == spec.numEigsKept());
+        CHECK(rspec.truncerr() == spec.truncerr());
+        CHECK(rspec.hasQNs());
+        for(int n = 1; n <= rspec.numEigsKept(); ++n)
+            {
+            CHECK(rspec.eig(n) == spec.eig(n));
+            CHECK(rspec.qn(n) == spec.qn(n));
+            }
+        }
+
+    }
+
+SECTION("QR")
+    {
+    auto i = Index("i",3),
+         j = Index("j",4),
+         k = Index("k",5);
+
+    SECTION("ITensor")
+        {
+        auto T = randomTensor(i,j,k);
+        ITensor Q(i,k),R;
+        qr(T,Q,R);
+        CHECK(norm(T-Q*R) < 1E-12);
+        CHECK(hasindex(Q,i));
+        CHECK(hasindex(Q,k));
+        CHECK(hasindex(R,j));
+        auto q = commonIndex(Q,R);
+        CHECK(q.m() == 4);
+        auto id = ITensor(q,prime(q));
+        for(auto n : range1(q.m())) id.set(q(n),prime(q)(n),1.);
+        CHECK(norm(Q*dag(prime(Q,q))-id) < 1E-12);
+
+        //Indices given on R instead
+        Q = ITensor();
+        R = ITensor(i,k);
+        qr(T,Q,R,{"IndexName","a"});
+        CHECK(norm(T-Q*R) < 1E-12);
+        CHECK(hasindex(Q,j));
+        CHECK(commonIndex(Q,R).rawname() == "a");
+        }
+
+    SECTION("Complex LQ")
+        {
+        auto T = randomTensorC(i,j,k);
+        ITensor L(j),Q;
+        lq(T,L,Q);
+        CHECK(norm(T-L*Q) < 1E-12);
+        CHECK(hasindex(L,j));
+        auto q = commonIndex(L,Q);
+        CHECK(q.m() == 4);
+        auto id = ITensor(q,prime(q));
+        for(auto n : range1(q.m())) id.set(q(n),prime(q)(n),1.);
+        CHECK(norm(Q*dag(prime(Q,q))-id) < 1E-12);
+        }
+
+    SECTION("IQTensor")
+        {
+        auto u = IQIndex("u",Index("u+1",3),QN(+1),
+                             Index("u 0",12),QN( 0),
+                             Index("u-1",5),QN(-1));
+        auto v = IQIndex("v",Index("v+1",9),QN(+1),
+                             Index("v 0",6),QN( 0),
+                             Index("v-1",5),QN(-1));
+        auto s = IQIndex("s",Index("s+",1),QN(+1),
+                             Index("s-",1),QN(-1));
+        auto T = randomTensor(QN(+1),u,dag(v),s);
+        IQTensor Q(u,s),R;
+        qr(T,Q,R,{"NThread",4});
+        CHECK(norm(T-Q*R) < 1E-12);
+        CHECK(div(Q) == QN());
+        CHECK(div(R) == QN(+1));
+        auto q = commonIndex(Q,R);
+        auto id = IQTensor(q,dag(prime(q)));
+        for(auto n : range1(q.m())) id.set(q(n),dag(prime(q))(n),1.);
+        CHECK(norm(Q*dag(prime(Q,q))-id) < 1E-12);
+        }
     }
 
 SECTION("IQTensor denmatDecomp")
@@ -324,6 +554,20 @@ SECTION("IQTensor diagHermitian")
         CHECK(norm(T-dag(U)*D*prime(U)) < 1E-12);
         }
 
+    SECTION("Parallel Blocks")
+        {
+        auto I = IQIndex("I",Index("i-2",6),QN(-2),
+                             Index("i-",4),QN(-1),
+                             Index("i0",9),QN(0),
+                             Index("i+",4),QN(+1),
+                             Index("i+2",3),QN(+2));
+        auto T = randomTensor(QN(),dag(I),prime(I));
+        T += dag(swapPrime(T,0,1));
+        IQTensor U,D;
+        diagHermitian(T,U,D,{"NThread",4});
+        CHECK(norm(T-dag(U)*D*prime(U)) < 1E-12);
+        }
+
     SECTION("Complex Rank 4")
         {
         detail::seed_quickran(1);
@@ -0,0 +1,151 @@
+#include <sys/stat.h>
+#include "test.h"
+#include "itensor/mps/dmrg.h"
+#include "itensor/mps/autompo.h"
+#include "itensor/mps/sites/spinhalf.h"
+#include "itensor/util/print_macro.h"
+
+using namespace itensor;
+
+//Aborts a DMRG run by throwing after
+//the step at the given position
+class InterruptObserver : public DMRGObserver<IQTensor>
+    {
+    int sw_, ha_, b_;
+    public:
+
+    InterruptObserver(IQMPS const& psi, int sw, int ha, int b)
+      : DMRGObserver<IQTensor>(psi), sw_(sw), ha_(ha), b_(b)
+        { }
+
+    void virtual
+    measure(Args const& args = Args::global())
+        {
+        DMRGObserver<IQTensor>::measure(args);
+        if(args.getInt("Sweep") == sw_ && args.getInt("HalfSweep") == ha_ && args.getInt("AtBond") == b_)
+            {
+            throw std::runtime_error("interrupted");
+            }
+        }
+    };
+
+TEST_CASE("DMRG")
+{
+SECTION("Memory Budget")
+    {
+    auto N = 12;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto neel = InitState(sites);
+    for(int j = 1; j <= N; ++j) neel.set(j,j%2==1 ? "Up" : "Dn");
+    auto sweeps = Sweeps(4);
+    sweeps.maxm() = 10,20,40,40;
+    sweeps.cutoff() = 1E-10;
+
+    auto psi0 = IQMPS(neel);
+    auto E0 = dmrg(psi0,H,sweeps,{"Quiet",true});
+
+    //A budget far below the size of the
+    //environments forces constant spilling
+    auto psi = IQMPS(neel);
+    auto E = dmrg(psi,H,sweeps,{"Quiet",true,"MaxMemoryGB",1E-5});
+    CHECK_CLOSE(E,E0);
+    CHECK_CLOSE(overlap(psi,H,psi),E0);
+    CHECK(std::abs(overlap(psi0,psi)) > 0.999);
+
+    //Spill directory of an MPS under a WriteDir
+    //containing a space; the sibling named after
+    //the part before the space must survive
+    auto exists = [](std::string const& fname) { return std::ifstream(fname).good(); };
+    auto spilled = [&exists,N](std::string const& dir)
+        {
+        for(auto j : range1(N)) if(exists(format("%s/A_%03d",dir,j))) return true;
+        return false;
+        };
+    auto base = mkTempDir("dmrgtest");
+    auto sibling = base + "/a";
+    mkdir(sibling.c_str(),0700);
+    std::ofstream(sibling+"/keep") << 1;
+    auto wdir = base + "/a b";
+    mkdir(wdir.c_str(),0700);
+    for(auto destroy : {false,true})
+        {
+        auto spilldir = std::string();
+            {
+            auto phi = psi;
+            phi.memoryBudget(std::make_shared<SpillManager>(1),{"WriteDir",wdir,"AsyncIO",false});
+            spilldir = phi.writeDir();
+            CHECK(spilldir.find(wdir) == 0);
+            CHECK(spilled(spilldir));
+            if(!destroy)
+                {
+                phi.memoryBudget(nullptr);
+                CHECK(rmdir(spilldir.c_str()) != 0);
+                CHECK_CLOSE(overlap(phi,H,phi),E0);
+                }
+            }
+        CHECK(!spilled(spilldir));
+        CHECK(rmdir(spilldir.c_str()) != 0);
+        CHECK(exists(sibling+"/keep"));
+        }
+    removeTree(base);
+    }
+
+SECTION("Checkpoint")
+    {
+    auto fname = std::string("dmrg_test.ckpt");
+    auto N = 10;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto neel = InitState(sites);
+    for(int j = 1; j <= N; ++j) neel.set(j,j%2==1 ? "Up" : "Dn");
+    auto sweeps = Sweeps(4);
+    sweeps.maxm() = 10,20,40,40;
+    sweeps.cutoff() = 1E-10;
+
+    auto psi0 = IQMPS(neel);
+    auto E0 = dmrg(psi0,H,sweeps,{"Quiet",true});
+
+    //With a memory budget, spilled tensors are
+    //written to the checkpoint from their files.
+    //Interval 0 saves every step, so the checkpoint
+    //is at the step before the interrupt.
+    for(auto budget : {false,true})
+        {
+        auto args = Args{"Quiet",true,"CheckpointFile",fname,"CheckpointInterval",0};
+        if(budget) args.add("MaxMemoryGB",1E-5);
+        auto psi1 = IQMPS(neel);
+        auto obs = InterruptObserver(psi1,2,2,5);
+        CHECK_THROWS_AS(dmrg(psi1,H,sweeps,obs,args),std::runtime_error);
+
+        DMRGCheckpoint c(fname);
+        CHECK(c.sweep == 2);
+        CHECK(c.halfsweep == 2);
+        CHECK(c.bond == 5);
+
+        auto psi = IQMPS(sites);
+        auto E = dmrg(psi,H,sweeps,c,{"Quiet",true});
+        CHECK_CLOSE(E,E0);
+        CHECK_CLOSE(overlap(psi,H,psi),E0);
+        CHECK(std::abs(overlap(psi0,psi)) > 0.999);
+
+        //The final checkpoint marks the run as finished
+        CHECK(DMRGCheckpoint(fname).sweep == sweeps.nsweep()+1);
+        std::remove(fname.c_str());
+        }
+    }
+}
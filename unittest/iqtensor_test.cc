@@ -160,6 +160,103 @@ SECTION("Contracting Product")
             }
         }
 
+    SECTION("Multithreaded Block Contraction")
+        {
+        auto R1 = A * dag(prime(A,L1));
+        auto R2 = D * prime(A,S1);
+        Global::args().add("NThread",4);
+        auto T1 = A * dag(prime(A,L1));
+        auto T2 = D * prime(A,S1);
+        Global::args().remove("NThread");
+        CHECK(norm(R1-T1) < 1E-12*norm(R1));
+        CHECK(norm(R2-T2) < 1E-12*norm(R2));
+        }
+
+    SECTION("Cached Contraction Plan")
+        {
+        //Products of tensors with the same indices and
+        //blocks but different data reuse a cached plan
+        auto A2 = A;
+        resetContractPlanStats();
+        for(int n = 0; n < 3; ++n)
+            {
+            randomize(A2);
+            auto R = A2 * dag(prime(A2,L1));
+            auto T = toITensor(A2) * dag(prime(toITensor(A2),L1));
+            CHECK(norm(T-toITensor(R)) < 1E-12*norm(T));
+            Global::args().add("ContractPlanCacheSize",0);
+            auto U = A2 * dag(prime(A2,L1));
+            Global::args().remove("ContractPlanCacheSize");
+            CHECK(norm(R-U) < 1E-12*norm(R));
+            }
+        //Only the first product can miss; the
+        //cache is not used when disabled
+        auto stats = contractPlanStats();
+        CHECK((stats.nhit+stats.nmiss) == 3);
+        CHECK(stats.nhit >= 2);
+        }
+
+    SECTION("Compare to Dense Contraction")
+        {
+        auto I = IQIndex("I",Index("I-",2),QN(-1),
+                             Index("I0",1),QN( 0),
+                             Index("I+",2),QN(+1));
+        auto J = IQIndex("J",Index("J0",1),QN( 0),
+                             Index("J+",2),QN(+1),
+                             Index("J++",1),QN(+2));
+        auto K = IQIndex("K",Index("K-",2),QN(-1),
+                             Index("K+",3),QN(+1));
+        //Only sector of M has QN +1
+        auto M = IQIndex("M",Index("M+",3),QN(+1));
+
+        auto checkDense = [](IQTensor const& X, IQTensor const& Y)
+            {
+            auto R = X*Y;
+            auto T = toITensor(X)*toITensor(Y);
+            CHECK(norm(T-toITensor(R)) < 1E-12*norm(T));
+            };
+
+        SECTION("C Lacks Blocks")
+            {
+            //C has divergence +2, so the blocks
+            //of its IQIndexes with other
+            //divergences are not stored
+            auto X = randomTensor(QN(+1),I,J,K);
+            auto Y = randomTensor(QN(+1),dag(K),prime(I));
+            checkDense(X,Y);
+            checkDense(Y,X);
+            auto R = X*Y;
+            CHECK(div(R) == QN(+2));
+            }
+
+        SECTION("No Matching Block of B")
+            {
+            //Y only has blocks where J has QN +1, so
+            //blocks of X with J sectors 0 and +2
+            //contract with nothing
+            auto X = randomTensor(QN(),I,J,K);
+            auto Y = randomTensor(QN(),dag(J),M);
+            checkDense(X,Y);
+            checkDense(Y,X);
+            auto XC = randomTensorC(QN(),I,J,K);
+            checkDense(XC,Y);
+            }
+
+        SECTION("Several Contracted Modes")
+            {
+            auto X = randomTensor(QN(),I,J,K);
+            auto Y = randomTensor(QN(),dag(K),prime(J),dag(I));
+            checkDense(X,Y);
+            checkDense(Y,X);
+            //All modes contracted
+            auto Z = randomTensor(QN(),dag(K),dag(I),dag(J));
+            CHECK_CLOSE((X*Z).real(),(toITensor(X)*toITensor(Z)).real());
+            auto YC = randomTensorC(QN(+1),dag(K),prime(J),dag(I),M);
+            checkDense(X,YC);
+            checkDense(YC,X);
+            }
+        }
+
     SECTION("Regression Test 1")
         {
         auto s = IQIndex("S=1 site",
@@ -179,6 +179,134 @@ SECTION("IQFourSite")
 
     }
 
+SECTION("Block Davidson")
+    {
+    const int N = 4;
+    SpinHalf sites(N);
+    auto initState = InitState(sites);
+    for(int i = 1; i <= N; ++i)
+        initState.set(i,i%2==1 ? "Up" : "Dn");
+
+    SECTION("ITensor")
+        {
+        auto H = MPO(Heisenberg(sites));
+        auto psi = MPS(initState);
+        auto PH = LocalMPO<ITensor>(H);
+        psi.position(2);
+        PH.position(2,psi);
+        auto phi = psi.A(2)*psi.A(3);
+        auto stats = EigenSolverStats{};
+        auto v = std::vector<ITensor>{{phi}};
+        auto eigs = blockDavidson(PH,v,stats,{"MaxIter",9,"ErrGoal",1E-12});
+        CHECK_CLOSE(eigs.front(),-0.95710678118);
+        CHECK(stats.nmatvec >= stats.niter+1);
+        }
+
+    SECTION("IQTensor")
+        {
+        auto H = IQMPO(Heisenberg(sites));
+        auto psi = IQMPS(initState);
+        auto PH = LocalMPO<IQTensor>(H);
+        psi.position(2);
+        PH.position(2,psi);
+        auto phi = psi.A(2)*psi.A(3);
+        auto En = blockDavidson(PH,phi,{"MaxIter",9,"ErrGoal",1E-12});
+        CHECK_CLOSE(En,-0.95710678118);
+        }
+
+    SECTION("Multiple States")
+        {
+        auto a1 = Index("a1",4,Site);
+        auto a2 = Index("a2",5,Site);
+        auto B = randomTensor(prime(a1),prime(a2),a1,a2);
+        auto A = B + swapPrime(B,0,1);
+        auto nget = 3;
+        auto phi = std::vector<ITensor>(nget);
+        for(auto& p : phi) p = randomTensor(a1,a2);
+        auto stats = EigenSolverStats{};
+        auto eigs = blockDavidson(ITensorMap(A),phi,stats,
+                                  {"MaxIter",40,"MaxBasis",12,"ErrGoal",1E-10});
+        for(auto j : range(nget))
+            {
+            auto Aphi = (A*phi[j]).mapprime(1,0);
+            CHECK(norm(Aphi-eigs[j]*phi[j]) < 1E-6);
+            for(auto k : range(nget))
+                {
+                CHECK_CLOSE((phi[j]*phi[k]).real(),j==k ? 1. : 0.);
+                }
+            if(j > 0) CHECK(eigs[j] >= eigs[j-1]);
+            }
+        //Lowest eigenvalue agrees with single-vector davidson
+        auto phi0 = randomTensor(a1,a2);
+        auto E0 = davidson(ITensorMap(A),phi0,{"MaxIter",19,"ErrGoal",1E-10});
+        CHECK_CLOSE(eigs.front(),E0);
+        CHECK(stats.nrestart > 0);
+        CHECK(stats.nmatvec >= nget);
+        }
+    }
+
+SECTION("Krylov Exponential")
+    {
+    auto a1 = Index("a1",4,Site);
+    auto a2 = Index("a2",5,Site);
+    auto B = randomTensor(prime(a1),prime(a2),a1,a2);
+    auto A = B + swapPrime(B,0,1);
+    A /= norm(A);
+    auto phi0 = randomTensor(a1,a2);
+
+    //exp(t*A)*phi by a Taylor series
+    auto taylor = [&A](ITensor phi, Cplx t, int nstep)
+        {
+        t /= nstep;
+        for(int s = 0; s < nstep; ++s)
+            {
+            auto term = phi;
+            for(int n = 1; n <= 30; ++n)
+                {
+                term = (A*term).mapprime(1,0)*(t/Real(n));
+                phi += term;
+                }
+            }
+        return phi;
+        };
+
+    SECTION("Real Time")
+        {
+        auto t = Cplx(0.,-0.5);
+        auto phi = phi0;
+        auto err = applyExp(ITensorMap(A),phi,t,{"ErrGoal",1E-12});
+        CHECK(err < 1E-10);
+        CHECK(norm(phi-taylor(phi0,t,1)) < 1E-10);
+        CHECK_CLOSE(norm(phi),norm(phi0));
+        }
+
+    SECTION("Imaginary Time")
+        {
+        auto phi = phi0;
+        applyExp(ITensorMap(A),phi,-0.3,{"ErrGoal",1E-12});
+        CHECK(norm(phi-taylor(phi0,-0.3,1)) < 1E-10);
+        }
+
+    SECTION("Split Steps")
+        {
+        //Long time with small Krylov space
+        auto t = Cplx(0.,-8.);
+        auto phi = phi0;
+        applyExp(ITensorMap(A),phi,t,{"ErrGoal",1E-10,"MaxIter",6});
+        CHECK(norm(phi-taylor(phi0,t,16)) < 1E-8);
+        }
+
+    SECTION("Krylov Space Too Small")
+        {
+        //Would need steps shorter than MinStep
+        auto t = Cplx(0.,-0.5);
+        auto phi = phi0;
+        CHECK_THROWS_AS(applyExp(ITensorMap(A),phi,t,{"MaxIter",1}),ITError);
+        phi = phi0;
+        CHECK_THROWS_AS(applyExp(ITensorMap(A),phi,t,{"MaxIter",2}),ITError);
+        }
+    }
+
 SECTION("GMRES (ITensor, Real)")
     {
     auto a1 = Index("a1",3,Site);
@@ -1,6 +1,7 @@
 #include "test.h"
 #include "itensor/mps/localop.h"
 #include "itensor/mps/localmpo.h"
+#include "itensor/mps/autompo.h"
 #include "itensor/mps/sites/spinhalf.h"
 #include "itensor/util/print_macro.h"
 
@@ -54,6 +55,60 @@ SECTION("Product")
         CHECK(hasindex(Hpsi,l0));
         CHECK(hasindex(Hpsi,l2));
         }
+
+    SECTION("Fused Dense Product")
+        {
+        auto Op1 = randomTensor(s1,prime(s1),h0,h1);
+        auto Op2 = randomTensor(s2,prime(s2),h1,h2);
+        auto L = randomTensor(l0,prime(l0),h0);
+        auto R = randomTensor(l2,prime(l2),h2);
+        auto lop = LocalOp<ITensor>(Op1,Op2,L,R);
+
+        auto exact = [&](ITensor const& phi)
+            {
+            auto res = phi*L;
+            res *= Op1;
+            res *= Op2;
+            res *= R;
+            return res.mapprime(1,0);
+            };
+
+        //Repeated products reuse the same plan; a
+        //new index order of phi gets a new plan
+        auto psi = randomTensor(l0,s1,s2,l2);
+        auto Hpsi = ITensor();
+        for(int n = 0; n < 3; ++n)
+            {
+            lop.product(psi,Hpsi);
+            CHECK(norm(Hpsi-exact(psi)) < 1E-11*norm(Hpsi));
+            psi = Hpsi/norm(Hpsi);
+            }
+        auto psi2 = randomTensor(s2,l2,l0,s1);
+        lop.product(psi2,Hpsi);
+        CHECK(norm(Hpsi-exact(psi2)) < 1E-11*norm(Hpsi));
+
+        //Complex phi and operators
+        auto psiz = randomTensorC(l0,s1,s2,l2);
+        lop.product(psiz,Hpsi);
+        CHECK(isComplex(Hpsi));
+        CHECK(norm(Hpsi-exact(psiz)) < 1E-11*norm(Hpsi));
+
+        auto Op1z = randomTensorC(s1,prime(s1),h0,h1);
+        lop.update(Op1z,Op2,L,R);
+        lop.product(psi,Hpsi);
+        auto ex = psi*L*Op1z*Op2*R;
+        ex.mapprime(1,0);
+        CHECK(norm(Hpsi-ex) < 1E-11*norm(Hpsi));
+
+        //Edge case: no L
+        auto E1 = randomTensor(s1,prime(s1),h1);
+        auto lopR = LocalOp<ITensor>(E1,Op2,ITensor(),R);
+        auto phi = randomTensor(s1,s2,l2);
+        lopR.product(phi,Hpsi);
+        auto exR = phi*R*Op2*E1;
+        exR.mapprime(1,0);
+        CHECK(norm(Hpsi-exR) < 1E-11*norm(Hpsi));
+        }
     }
 
 SECTION("Diag")
@@ -109,6 +164,66 @@ SECTION("LocalMPO As MPS")
     auto lmps = LocalMPO<IQTensor>(psiN);
     lmps.position(3,psiF);
     }
-}
 
+SECTION("Copy with Memory Budget")
+    {
+    auto N = 10;
+    auto sites = SpinHalf(N);
+    auto ampo = AutoMPO(sites);
+    for(int j = 1; j < N; ++j)
+        {
+        ampo += 0.5,"S+",j,"S-",j+1;
+        ampo += 0.5,"S-",j,"S+",j+1;
+        ampo +=     "Sz",j,"Sz",j+1;
+        }
+    auto H = IQMPO(ampo);
+    auto neel = InitState(sites);
+    for(int j = 1; j <= N; ++j) neel.set(j,j%2==1 ? "Up" : "Dn");
+    auto psi = IQMPS(neel);
+    auto sweep = [&psi,N](LocalMPO<IQTensor>& PH)
+        {
+        auto E = std::vector<Real>();
+        for(int b = 1; b < N; ++b)
+            {
+            PH.position(b,psi);
+            auto phip = IQTensor();
+            PH.product(psi.A(b)*psi.A(b+1),phip);
+            E.push_back(norm(phip));
+            }
+        for(int b = N-1; b >= 1; --b)
+            {
+            PH.position(b,psi);
+            auto phip = IQTensor();
+            PH.product(psi.A(b)*psi.A(b+1),phip);
+            E.push_back(norm(phip));
+            }
+        return E;
+        };
+
+    auto PH0 = LocalMPO<IQTensor>(H);
+    auto E0 = sweep(PH0);
+
+    auto m = std::make_shared<SpillManager>(1);
+    auto PH1 = std::unique_ptr<LocalMPO<IQTensor>>(new LocalMPO<IQTensor>(H));
+    PH1->memoryBudget(m);
+    PH1->position(N/2,psi);
+    CHECK(m->numSpilled() > 0);
+    auto dir1 = PH1->writeDir();
+
+    auto PH2 = *PH1;
+    CHECK(PH2.writeDir() != dir1);
+    PH1.reset();
+    CHECK(!fileExists(dir1));
 
+    auto E = sweep(PH2);
+    REQUIRE(E.size() == E0.size());
+    for(auto n : range(E)) CHECK_CLOSE(E[n],E0[n]);
+
+    //Moves keep spilling into the same directory
+    auto dir2 = PH2.writeDir();
+    auto PH3 = std::move(PH2);
+    CHECK(PH3.writeDir() == dir2);
+    E = sweep(PH3);
+    for(auto n : range(E)) CHECK_CLOSE(E[n],E0[n]);
+    }
+}
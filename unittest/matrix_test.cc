@@ -1409,6 +1409,39 @@ SECTION("diagHermitian")
 
         CHECK(norm(R-Mt) < 1E-12*norm(Mt));
         }
+
+    SECTION("Partial spectrum")
+        {
+        auto M = randomMat(N,N);
+        M = M+transpose(M);
+        Matrix U,Uk;
+        Vector d,dk;
+        diagHermitian(M,U,d);
+
+        //Largest 4 eigenpairs
+        diagHermitian(M,Uk,dk,4);
+        CHECK(dk.size() == 4);
+        CHECK(ncols(Uk) == 4);
+        CHECK(norm(dk-subVector(d,0,4)) < 1E-12);
+        auto Dk = Matrix(4,4);
+        diagonal(Dk) &= dk;
+        CHECK(norm(M*Uk-Uk*Dk) < 1E-12);
+
+        //Eigenvalues at least d(2)
+        diagHermitian(M,Uk,dk,N,d(2)-1E-8);
+        CHECK(dk.size() == 3);
+        CHECK(norm(dk-subVector(d,0,3)) < 1E-12);
+
+        auto C = randomMatC(N,N);
+        C = C+conj(transpose(C));
+        CMatrix CU,CUk;
+        diagHermitian(C,CU,d);
+        diagHermitian(C,CUk,dk,5);
+        CHECK(norm(dk-subVector(d,0,5)) < 1E-12);
+        Dk = Matrix(5,5);
+        diagonal(Dk) &= dk;
+        CHECK(norm(C*CUk-CUk*Dk) < 1E-12);
+        }
     }
 
 
@@ -1450,6 +1483,43 @@ SECTION("Orthogonalize")
         }
     }
 
+SECTION("QR Decomp")
+    {
+    for(auto dims : {std::make_pair(12,7),std::make_pair(7,12)})
+        {
+        auto k = std::min(dims.first,dims.second);
+        auto Id = Matrix(k,k);
+        for(auto j : range(k)) Id(j,j) = 1;
+
+        auto M = Matrix(dims.first,dims.second);
+        randomize(M);
+        Matrix Q,R;
+        QR(M,Q,R);
+        CHECK(ncols(Q) == k);
+        CHECK(nrows(R) == k);
+        CHECK(norm(M-Q*R) < 1E-12);
+        CHECK(norm(transpose(Q)*Q-Id) < 1E-12);
+        for(auto r : range(k))
+        for(auto c : range(r))
+            {
+            CHECK(R(r,c) == 0);
+            }
+
+        //LQ from the QR of the transpose
+        QR(transpose(M),Q,R);
+        CHECK(norm(M-transpose(R)*transpose(Q)) < 1E-12);
+
+        auto C = CMatrix(dims.first,dims.second);
+        randomize(C);
+        CMatrix CQ,CR;
+        QR(C,CQ,CR);
+        CHECK(norm(C-CQ*CR) < 1E-12);
+        auto CId = CMatrix(k,k);
+        for(auto j : range(k)) CId(j,j) = 1;
+        CHECK(norm(conj(transpose(CQ))*CQ-CId) < 1E-12);
+        }
+    }
+
 SECTION("Singular Value Decomp")
     {
     SECTION("One Pass Case")
@@ -1567,6 +1637,118 @@ SECTION("Singular Value Decomp")
 
         CHECK(norm(M-U*D*conj(transpose(V))) < 1E-12);
         }
+
+    SECTION("LAPACK SVD")
+        {
+        for(auto method : {GesddSVD,GesvdSVD})
+        for(auto dims : {std::make_pair(12,7),std::make_pair(7,12)})
+            {
+            auto M = Matrix(dims.first,dims.second);
+            randomize(M);
+            Matrix U,V;
+            Vector d;
+            SVD(M,U,d,V,method);
+            auto D = Matrix(d.size(),d.size());
+            diagonal(D) &= d;
+            CHECK(norm(M-U*D*transpose(V)) < 1E-12);
+            auto Id = Matrix(d.size(),d.size());
+            for(auto j : range(d.size())) Id(j,j) = 1;
+            CHECK(norm(transpose(U)*U-Id) < 1E-12);
+            CHECK(norm(transpose(V)*V-Id) < 1E-12);
+
+            //Same singular values as the default method
+            Matrix U0,V0;
+            Vector d0;
+            SVD(M,U0,d0,V0);
+            CHECK(norm(d-d0) < 1E-12);
+
+            auto C = CMatrix(dims.first,dims.second);
+            randomize(C);
+            CMatrix CU,CV;
+            SVD(C,CU,d,CV,method);
+            diagonal(D) &= d;
+            CHECK(norm(C-CU*D*conj(transpose(CV))) < 1E-12);
+            }
+        CHECK(svdMethod("gesdd") == GesddSVD);
+        CHECK_THROWS_AS(svdMethod("none"),ITError);
+        }
+
+    SECTION("Randomized SVD")
+        {
+        //Fixed seed for the test matrix and the random sketch
+        seedRNG(1);
+
+        //Matrix with known, decaying spectrum
+        auto m = 120,
+             n = 90;
+        auto A = Matrix(m,n);
+        randomize(A);
+        Matrix L,R;
+        Vector exact;
+        SVD(A,L,exact,R,GesddSVD);
+        for(auto j : range(exact.size())) exact(j) = std::pow(0.7,j);
+        auto DD = Matrix(exact.size(),exact.size());
+        diagonal(DD) &= exact;
+        auto M = Matrix(L*DD*transpose(R));
+
+        //Compute 20 singular values with oversampling 10
+        auto nsv = 30;
+        Matrix U,V;
+        Vector d;
+        randomizedSVD(M,U,d,V,nsv);
+        CHECK(d.size() == nsv);
+        CHECK(ncols(U) == nsv);
+        CHECK(ncols(V) == nsv);
+        for(auto j : range(20)) CHECK_CLOSE(d(j),exact(j));
+        //Error is set by the singular values not computed,
+        //whose norm is about 1.4*exact(nsv)
+        auto Dk = Matrix(nsv,nsv);
+        diagonal(Dk) &= d;
+        CHECK(norm(U*Dk*transpose(V)-M) < 2*exact(nsv));
+
+        //Multiplying by a phase leaves singular values unchanged
+        auto C = CMatrix(m,n);
+        for(auto r : range(m))
+        for(auto c : range(n))
+            {
+            C(r,c) = Cplx(0.6,0.8)*M(r,c);
+            }
+        CMatrix CU,CV;
+        randomizedSVD(C,CU,d,CV,nsv);
+        for(auto j : range(20)) CHECK_CLOSE(d(j),exact(j));
+        diagonal(Dk) &= d;
+        CHECK(norm(CU*Dk*conj(transpose(CV))-C) < 2*exact(nsv));
+        }
+
+    SECTION("Reproducible With Fixed Seed")
+        {
+        //Rank 1: SVD fills the null columns of V
+        //with random vectors
+        auto M = Matrix(4,4);
+        for(auto r : range(4))
+        for(auto c : range(4))
+            {
+            M(r,c) = (r+1.)*(c+2.);
+            }
+        auto run = [&M](int seed)
+            {
+            seedRNG(seed);
+            Matrix U,V;
+            Vector d;
+            SVD(M,U,d,V);
+            auto R = Matrix(60,40);
+            randomize(R);
+            Matrix RU,RV;
+            Vector rd;
+            randomizedSVD(R,RU,rd,RV,10);
+            return std::make_tuple(V,RU);
+            };
+        Matrix V1,V2,RU1,RU2;
+        std::tie(V1,RU1) = run(5);
+        std::tie(V2,RU2) = run(5);
+        CHECK(norm(V1-V2) == 0.);
+        CHECK(norm(RU1-RU2) == 0.);
+        }
     }
 
 //SECTION("Complex SVD")
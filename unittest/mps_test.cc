@@ -136,6 +136,111 @@ SECTION("Orthogonalize")
 
     }
 
+SECTION("QR Gauge Moves")
+    {
+    auto N = 10;
+    auto m = 20;
+    auto sites = SpinHalf(N);
+    auto psi = MPS(sites);
+
+    auto links = vector<Index>(N+1);
+    for(auto n : range1(N))
+        {
+        links.at(n) = Index(nameint("l",n),m);
+        }
+    psi.Aref(1) = randomTensor(links.at(1),sites(1));
+    for(auto n : range1(2,N-1))
+        {
+        psi.Aref(n) = randomTensor(links.at(n-1),sites(n),links.at(n));
+        }
+    psi.Aref(N) = randomTensor(links.at(N-1),sites(N));
+    psi.Aref(1) /= sqrt(overlap(psi,psi));
+    auto opsi = psi;
+
+    //Without truncation position only does QR
+    //decompositions, which keep the bond names
+    psi.position(N);
+    CHECK(psi.orthoCenter() == N);
+    CHECK_CLOSE(overlap(opsi,psi),1.0);
+    CHECK(linkInd(psi,3).rawname() == "l3");
+    for(auto n : range1(N-1))
+        {
+        auto li = commonIndex(psi.A(n),psi.A(n+1),Link);
+        auto rho = psi.A(n) * dag(prime(psi.A(n),li));
+        auto id = ITensor(li,prime(li));
+        for(auto l : range1(li.m())) id.set(li(l),prime(li)(l),1.0);
+        CHECK(norm(rho-id) < 1E-10);
+        }
+
+    //Same bond dimensions as with SVDs
+    auto spsi = opsi;
+    spsi.position(N,{"UseQR",false});
+    for(auto b : range1(N-1))
+        {
+        CHECK(linkInd(spsi,b).m() == linkInd(psi,b).m());
+        }
+
+    psi.orthogonalize({"Truncate",false});
+    CHECK(psi.orthoCenter() == 1);
+    CHECK_CLOSE(overlap(opsi,psi),1.0);
+    for(int n = N; n > 1; --n)
+        {
+        auto li = commonIndex(psi.A(n),psi.A(n-1),Link);
+        auto rho = psi.A(n) * dag(prime(psi.A(n),li));
+        auto id = ITensor(li,prime(li));
+        for(auto l : range1(li.m())) id.set(li(l),prime(li)(l),1.0);
+        CHECK(norm(rho-id) < 1E-10);
+        }
+
+    //IQMPS
+    auto ssites = Spinless(N);
+    auto init = InitState(ssites,"Emp");
+    init.set(2,"Occ");
+    init.set(5,"Occ");
+    auto iqpsi = IQMPS(init);
+    iqpsi.Anc(3) *= Complex_i;
+    iqpsi.position(N);
+    CHECK_EQUAL(findCenter(iqpsi),N);
+    CHECK(checkQNs(iqpsi));
+    iqpsi.position(1);
+    CHECK_EQUAL(findCenter(iqpsi),1);
+    CHECK_CLOSE(overlap(iqpsi,iqpsi),1.0);
+    }
+
+SECTION("Write to Disk")
+    {
+    auto N = 10;
+    auto m = 8;
+    auto sites = SpinHalf(N);
+    auto psi = MPS(sites);
+    auto links = vector<Index>(N+1);
+    for(auto n : range1(N)) links.at(n) = Index(nameint("l",n),m);
+    psi.Aref(1) = randomTensor(links.at(1),sites(1));
+    for(auto n : range1(2,N-1))
+        {
+        psi.Aref(n) = randomTensor(links.at(n-1),sites(n),links.at(n));
+        }
+    psi.Aref(N) = randomTensor(links.at(N-1),sites(N));
+    psi.Aref(1) /= sqrt(overlap(psi,psi));
+    auto opsi = psi;
+
+    //Sweep back and forth keeping only the current
+    //bond in memory, with and without background I/O
+    for(auto async : {true,false})
+        {
+        auto wpsi = psi;
+        wpsi.doWrite(true,{"AsyncIO",async});
+        CHECK(wpsi.doWrite());
+        for(int sw = 0; sw < 2; ++sw)
+            {
+            wpsi.position(N);
+            wpsi.position(1);
+            }
+        wpsi.doWrite(false);
+        CHECK_CLOSE(overlap(opsi,wpsi),1.0);
+        }
+    }
+
 SECTION("Overlap - 1 site")
     {
     auto psi = MPS(1);
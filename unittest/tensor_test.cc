@@ -4,6 +4,7 @@
 #include "itensor/detail/algs.h"
 #include "itensor/tensor/permutation.h"
 #include "itensor/tensor/sliceten.h"
+#include "itensor/tensor/contract.h"
 
 using namespace itensor;
 
@@ -318,6 +319,25 @@ SECTION("Slicing")
                 }
             }
 
+        SECTION("Copy Permuted")
+            {
+            //Large enough to use tiled transposes,
+            //with extents not multiples of the tile size
+            auto L = Tensor(70,3,35,20);
+            for(auto& el : L) el = detail::quickran();
+            for(auto& P : {Labels{0,1,2,3},Labels{1,0,2,3},Labels{2,3,0,1},
+                           Labels{3,2,1,0},Labels{1,3,2,0},Labels{0,2,1,3}})
+                {
+                auto PL = Tensor(permute(L,P));
+                Real maxdiff = 0;
+                for(auto& i : PL.range())
+                    {
+                    maxdiff = std::max(maxdiff,std::fabs(PL(i)-permute(L,P)(i)));
+                    }
+                CHECK(maxdiff == 0);
+                }
+            }
+
         }
 
     SECTION("Sub Tensor")
@@ -413,4 +433,51 @@ SECTION("Slicing")
         }
 
     } // Slicing
+
+SECTION("Contract Into Permuted C")
+    {
+    //Index order of C requires permuting the result
+    //of the matrix product, which must then be
+    //added to beta*C
+    Tensor A(2,50,3),
+           B(50,4),
+           C(2,4,3);
+    randomize(A);
+    randomize(B);
+    randomize(C);
+    auto C0 = C;
+    auto alpha = 0.5,
+         beta = 2.;
+    contract(makeRefc(A),{1,-1,2},makeRefc(B),{-1,3},makeRef(C),{1,3,2},alpha,beta);
+    for(auto i1 : range(2))
+    for(auto i2 : range(3))
+    for(auto i3 : range(4))
+        {
+        Real val = 0;
+        for(auto k : range(50)) val += A(i1,k,i2)*B(k,i3);
+        CHECK_CLOSE(C(i1,i3,i2),alpha*val+beta*C0(i1,i3,i2));
+        }
+    }
+
+SECTION("Contract With Threaded Permutations")
+    {
+    //Permutations of A and C are large enough to be
+    //split over threads when "NThread" is set
+    Tensor A(120,6,110),
+           B(6,5);
+    randomize(A);
+    randomize(B);
+    Tensor C1(5,110,120);
+    randomize(C1);
+    auto C4 = C1;
+    auto saved = Args::global();
+    Args::global().add("NThread",1);
+    contract(makeRefc(A),{1,2,3},makeRefc(B),{2,4},makeRef(C1),{4,3,1},1.,0.5);
+    Args::global().add("NThread",4);
+    contract(makeRefc(A),{1,2,3},makeRefc(B),{2,4},makeRef(C4),{4,3,1},1.,0.5);
+    Args::global() = saved;
+    Real maxdiff = 0;
+    for(auto& i : C1.range()) maxdiff = std::max(maxdiff,std::fabs(C1(i)-C4(i)));
+    CHECK(maxdiff == 0);
+    }
 }
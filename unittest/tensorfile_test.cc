@@ -0,0 +1,217 @@
+#include <cstdio>
+#include <sstream>
+#include "test.h"
+#include "itensor/tensorfile.h"
+#include "itensor/mps/mpo.h"
+#include "itensor/mps/sites/spinhalf.h"
+#include "itensor/mps/sites/spinless.h"
+#include "itensor/util/print_macro.h"
+
+using namespace itensor;
+using std::vector;
+
+TEST_CASE("TensorFile")
+{
+auto fname = std::string("tensorfile_test.itf");
+
+auto i = Index("i",3);
+auto j = Index("j",4);
+auto k = Index("k",5);
+
+auto S = IQIndex("S",Index("s-",1,Site),QN(-1),
+                     Index("s+",1,Site),QN(+1));
+auto L = IQIndex("L",Index("l-2",2),QN(-2),
+                     Index("l+0",3),QN(+0),
+                     Index("l+2",2),QN(+2));
+
+SECTION("ITensor")
+    {
+    auto A = randomTensor(i,j,prime(i));
+    A *= 3.;
+    auto C = randomTensorC(j,k);
+    auto D = delta(i,prime(i));
+    auto Z = ITensor(2.+3._i);
+    auto N = ITensor(i,k);
+        {
+        TensorFileWriter w(fname);
+        w.write("A",A);
+        w.write("C",C);
+        w.write("D",D);
+        w.write("Z",Z);
+        w.write("N",N);
+        w.writeAttribute("note",std::string("a\0b",3));
+        }
+
+    TensorFile f(fname);
+    CHECK(f.version() == tensorFileVersion());
+    CHECK(f.has("A"));
+    CHECK(!f.has("B"));
+    CHECK(f.names().size() == 5);
+    CHECK(f.hasAttribute("note"));
+    CHECK(f.attribute("note") == std::string("a\0b",3));
+    CHECK_THROWS_AS(f.attribute("A"),ITError);
+
+    auto rA = f.read<ITensor>("A");
+    CHECK(hasindex(rA,i));
+    CHECK(hasindex(rA,j));
+    CHECK(hasindex(rA,prime(i)));
+    CHECK(norm(rA-A) < 1E-12);
+
+    auto rC = f.read<ITensor>("C");
+    CHECK(isComplex(rC));
+    CHECK(norm(rC-C) < 1E-12);
+
+    auto rD = f.read<ITensor>("D");
+    CHECK(norm(rD*A-D*A) < 1E-12);
+
+    CHECK_CLOSE(f.read<ITensor>("Z").cplx(),2.+3._i);
+    CHECK(!f.read<ITensor>("N").store());
+
+    CHECK_THROWS_AS(f.read<IQTensor>("A"),ITError);
+    CHECK_THROWS_AS(f.read<ITensor>("B"),ITError);
+    std::remove(fname.c_str());
+    }
+
+SECTION("IQTensor")
+    {
+    auto A = randomTensor(QN(0),L,S,dag(prime(L)));
+    auto C = randomTensorC(QN(1),L,dag(S));
+        {
+        TensorFileWriter w(fname);
+        w.write("A",A);
+        w.write("C",C);
+        w.write("Ad",dag(A));
+        }
+    TensorFile f(fname);
+    auto rA = f.read<IQTensor>("A");
+    CHECK(div(rA) == div(A));
+    CHECK(norm(rA-A) < 1E-12);
+    CHECK(findindex(rA.inds(),L) >= 0);
+    CHECK(rA.inds()[0].dir() == L.dir());
+    CHECK(rA.inds()[0].nblock() == L.nblock());
+    auto rC = f.read<IQTensor>("C");
+    CHECK(div(rC) == div(C));
+    CHECK(norm(rC-C) < 1E-12);
+    //Arrows of dag'd indices are kept
+    CHECK(norm(f.read<IQTensor>("Ad")*A-dag(A)*A) < 1E-12);
+    CHECK_THROWS_AS(f.read<ITensor>("A"),ITError);
+    std::remove(fname.c_str());
+    }
+
+SECTION("Invalid File")
+    {
+        {
+        std::ofstream s(fname.c_str());
+        s << "not a tensor file";
+        }
+    CHECK_THROWS_AS(TensorFile{fname},ITError);
+    std::remove(fname.c_str());
+    CHECK_THROWS_AS(TensorFile{fname},ITError);
+    }
+
+SECTION("Failed Write")
+    {
+    //A write failing midway must not terminate the
+    //program when the writer is destroyed
+    if(fileExists("/dev/full"))
+        {
+        auto A = randomTensor(i,j,k);
+        auto writeAll = [&A]()
+            {
+            TensorFileWriter w("/dev/full");
+            for(auto n : range(1000)) w.write(format("A%d",n),A);
+            };
+        CHECK_THROWS_AS(writeAll(),ITError);
+        }
+
+    //discard() leaves no file behind
+        {
+        TensorFileWriter w(fname);
+        w.write("A",randomTensor(i,j));
+        w.discard();
+        }
+    CHECK(!fileExists(fname));
+    }
+
+SECTION("MPS")
+    {
+    auto N = 8;
+    auto sites = SpinHalf(N);
+    auto init = InitState(sites,"Up");
+    for(auto n : range1(N)) if(n%2==0) init.set(n,"Dn");
+    auto psi = MPS(init);
+    psi.Aref(3) = randomTensor(Index(sites(3)),linkInd(psi,2),linkInd(psi,3));
+    psi.position(1);
+    psi.writeTensorFile(fname);
+
+    auto lpsi = MPS(sites);
+    lpsi.readTensorFile(fname);
+    CHECK(lpsi.N() == N);
+    CHECK(lpsi.leftLim() == psi.leftLim());
+    CHECK(lpsi.rightLim() == psi.rightLim());
+    CHECK(norm(lpsi.A(3)-psi.A(3)) < 1E-12);
+    //Copies share the sites not loaded yet
+    auto cpsi = lpsi;
+    CHECK_CLOSE(overlap(psi,lpsi),overlap(psi,psi));
+    CHECK_CLOSE(overlap(psi,cpsi),overlap(psi,psi));
+
+    //Writing a lazily read MPS back to its own file
+    auto rpsi = MPS(sites);
+    rpsi.readTensorFile(fname);
+    rpsi.writeTensorFile(fname);
+    CHECK_CLOSE(overlap(psi,rpsi),overlap(psi,psi));
+    auto rrpsi = MPS(sites);
+    rrpsi.readTensorFile(fname);
+    CHECK(rrpsi.leftLim() == psi.leftLim());
+    CHECK(norm(rrpsi.A(3)-psi.A(3)) < 1E-12);
+    CHECK_CLOSE(overlap(psi,rrpsi),overlap(psi,psi));
+
+    //Reading from a stream replaces
+    //the sites not loaded yet
+    auto psi2 = MPS(init);
+    psi2.Aref(3) = randomTensor(Index(sites(3)),linkInd(psi2,2),linkInd(psi2,3));
+    std::stringstream ss;
+    psi2.write(ss);
+    auto spsi = MPS(sites);
+    spsi.readTensorFile(fname);
+    spsi.read(ss);
+    for(auto n : range1(N))
+        {
+        CHECK(norm(spsi.A(n)-psi2.A(n)) < 1E-12);
+        }
+
+    auto epsi = MPS(sites);
+    epsi.readTensorFile(fname,{"Lazy",false});
+    std::remove(fname.c_str());
+    CHECK_CLOSE(overlap(psi,epsi),overlap(psi,psi));
+
+    auto ssites = Spinless(N);
+    auto iinit = InitState(ssites,"Emp");
+    iinit.set(2,"Occ");
+    iinit.set(5,"Occ");
+    auto ipsi = IQMPS(iinit);
+    ipsi.position(N);
+    ipsi.writeTensorFile(fname);
+    auto lipsi = IQMPS(ssites);
+    lipsi.readTensorFile(fname);
+    lipsi.position(1);
+    std::remove(fname.c_str());
+    CHECK(checkQNs(lipsi));
+    CHECK_CLOSE(overlap(ipsi,lipsi),1.0);
+    }
+
+SECTION("MPO")
+    {
+    auto N = 6;
+    auto sites = SpinHalf(N);
+    auto H = IQMPO(sites);
+    H.writeTensorFile(fname);
+    auto lH = IQMPO(sites);
+    lH.readTensorFile(fname);
+    std::remove(fname.c_str());
+    for(auto n : range1(N))
+        {
+        CHECK(norm(lH.A(n)-H.A(n)) < 1E-12);
+        }
+    }
+}
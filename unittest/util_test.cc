@@ -1,8 +1,23 @@
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
 #include "test.h"
 
 #include "itensor/global.h"
 #include "itensor/util/infarray.h"
 #include "itensor/util/stats.h"
+#include "itensor/util/multalloc.h"
+#include "itensor/util/threadpool.h"
+#include "itensor/util/asyncfile.h"
+#include "itensor/mps/spillmanager.h"
+#include "itensor/util/profiler.h"
+#include "itensor/util/tensorstats.h"
+#include "itensor/util/opcount.h"
+#include "itensor/tensor/algs.h"
+#include "itensor/iqtensor.h"
 
 using namespace itensor;
 using namespace std;
@@ -261,3 +276,594 @@ SECTION("BinErr")
     }
 }
 
+TEST_CASE("ScratchArena")
+{
+SECTION("Nested Buffers")
+    {
+    ScratchArena::local().clear();
+    resetScratchStats();
+        {
+        auto b1 = ScratchBuf<Real>(100);
+        auto b2 = ScratchBuf<Cplx>(300);
+        for(auto j : range(b1.size())) b1[j] = j;
+        for(auto j : range(b2.size())) b2[j] = Cplx(0,j);
+        //Buffers don't overlap
+        for(auto j : range(b1.size())) CHECK(b1[j] == j);
+        //and start on 64 byte boundaries
+        CHECK((reinterpret_cast<std::uintptr_t>(b1.data()) % 64) == 0);
+        CHECK((reinterpret_cast<std::uintptr_t>(b2.data()) % 64) == 0);
+        auto b3 = ScratchBuf<Real>(0);
+        CHECK(b3.empty());
+        }
+    auto s = scratchStats();
+    CHECK(s.nacquire == 2);
+    CHECK(s.nheap == 2);
+    CHECK(s.peak >= (100+600)*sizeof(Real));
+
+    //Arena now holds one chunk large enough for both
+    for(int n = 0; n < 3; ++n)
+        {
+        auto b1 = ScratchBuf<Real>(100);
+        auto b2 = ScratchBuf<Cplx>(300);
+        }
+    s = scratchStats();
+    CHECK(s.nacquire == 8);
+    CHECK(s.nheap == 2);
+    CHECK(s.nreuse == 6);
+    }
+
+SECTION("Trim")
+    {
+    //Memory of another thread's idle arena is freed
+    std::promise<void> used,
+                       done;
+    auto worker = std::thread([&used,&done]()
+        {
+            {
+            auto b = ScratchBuf<Real>(1000);
+            }
+        used.set_value();
+        done.get_future().wait();
+        });
+    used.get_future().wait();
+    auto b = ScratchBuf<Real>(100);
+    CHECK(trimScratch() >= 1000*sizeof(Real));
+    //but not that of arenas in use
+    CHECK(ScratchArena::local().capacity() >= 100);
+    CHECK(trimScratch() == 0);
+    done.set_value();
+    worker.join();
+    }
+}
+
+TEST_CASE("ThreadPool")
+{
+ThreadPool pool(4);
+CHECK(pool.size() == 4);
+
+SECTION("Parallel For")
+    {
+    auto N = 1000ul;
+    auto v = std::vector<long>(N,0);
+    pool.parallelFor(N,4,[&v](size_t i) { v[i] += i; });
+    for(auto i : range(N)) CHECK(v[i] == long(i));
+    }
+
+SECTION("Nested")
+    {
+    auto sums = std::vector<std::atomic<long>>(8);
+    for(auto& s : sums) s = 0;
+    pool.parallelFor(sums.size(),4,[&](size_t i)
+        {
+        pool.parallelFor(100,4,[&](size_t j) { sums[i] += j; });
+        });
+    for(auto& s : sums) CHECK(s == 4950);
+    }
+
+SECTION("Nested Serial BLAS")
+    {
+    CHECK(detail::serialBLASDepth() == 0);
+        {
+        detail::SerialBLAS outer;
+        CHECK(detail::serialBLASDepth() == 1);
+            {
+            detail::SerialBLAS inner;
+            CHECK(detail::serialBLASDepth() == 2);
+            }
+        CHECK(detail::serialBLASDepth() == 1);
+        }
+    CHECK(detail::serialBLASDepth() == 0);
+
+    //The calling thread runs parts of both regions
+    auto caller = std::this_thread::get_id();
+    std::atomic<int> max_depth(0);
+    pool.parallelFor(8,4,[&](size_t)
+        {
+        pool.parallelFor(8,4,[&](size_t)
+            {
+            if(std::this_thread::get_id() != caller) return;
+            auto d = detail::serialBLASDepth();
+            if(d > max_depth) max_depth = d;
+            });
+        });
+    CHECK(max_depth >= 1);
+    CHECK(detail::serialBLASDepth() == 0);
+    }
+
+SECTION("Exceptions")
+    {
+    auto f = [](size_t i) { if(i == 7) throw std::runtime_error("task 7"); };
+    CHECK_THROWS_AS(pool.parallelFor(20,4,f),std::runtime_error);
+    }
+
+SECTION("Submit")
+    {
+    std::atomic<int> count(0);
+    for(int n = 0; n < 50; ++n) pool.submit([&count]() { ++count; });
+    //Submitted tasks are run by the workers
+    while(count < 50) std::this_thread::yield();
+    CHECK(count == 50);
+    }
+
+SECTION("NThread")
+    {
+    //Threading is off unless asked for
+    CHECK(getNThread(Args()) == 1);
+    CHECK(getNThread({"NThread",3}) == 3);
+    CHECK(getNThread(Args(),4) == 4);
+    }
+}
+
+TEST_CASE("TempDir")
+{
+auto exists = [](std::string const& fname) { return std::ifstream(fname).good(); };
+auto base = mkTempDir("tempdir");
+//A sibling whose name is the part of the
+//location before the space must survive
+auto sibling = base + "/a";
+mkdir(sibling.c_str(),0700);
+std::ofstream(sibling+"/keep") << 1;
+auto locn = base + "/a b";
+mkdir(locn.c_str(),0700);
+
+std::string name;
+    {
+    TempDir d("t",locn);
+    name = d.name();
+    auto sub = name + "/sub";
+    mkdir(sub.c_str(),0700);
+    std::ofstream(sub+"/f") << 1;
+    std::ofstream(name+"/g") << 2;
+    CHECK(exists(sub+"/f"));
+    }
+CHECK(!exists(name+"/g"));
+CHECK(rmdir(name.c_str()) != 0);
+CHECK(exists(sibling+"/keep"));
+
+removeTree(base);
+CHECK(rmdir(base.c_str()) != 0);
+}
+
+TEST_CASE("AsyncFileStore")
+{
+auto dir = mkTempDir("asyncfile");
+auto fname = [&dir](int j) { return format("%s/v_%d",dir,j); };
+auto vec = [](int j) { return std::vector<Real>(100,Real(j)); };
+
+SECTION("Write and Read")
+    {
+        {
+        AsyncFileStore<std::vector<Real>> io;
+        for(int j = 0; j < 10; ++j) io.write(fname(j),vec(j));
+        //Pending writes are read from memory
+        CHECK(io.read(fname(3)) == vec(3));
+        io.flush();
+        for(int j = 0; j < 10; ++j) io.prefetch(fname(j));
+        for(int j = 9; j >= 0; --j) CHECK(io.read(fname(j)) == vec(j));
+        //Overwrite with a newer version
+        io.write(fname(2),vec(20));
+        io.prefetch(fname(2));
+        CHECK(io.read(fname(2)) == vec(20));
+        }
+    //Destructor finished all writes
+    CHECK(readFromFile<std::vector<Real>>(fname(2)) == vec(20));
+    }
+
+SECTION("Read During Write")
+    {
+    AsyncFileStore<std::vector<Real>> io;
+    //Keeps the I/O thread busy so the
+    //write of fname(1) is still queued
+    io.write(fname(0),std::vector<Real>(1<<16,1.));
+    io.write(fname(1),vec(1));
+    //Both reads come from memory
+    CHECK(io.read(fname(1)) == vec(1));
+    CHECK(io.read(fname(1)) == vec(1));
+    }
+
+SECTION("Prefetch After Read")
+    {
+    AsyncFileStore<std::vector<Real>> io;
+    //Keeps the I/O thread busy so the write of
+    //fname(1) is still queued when prefetch
+    //queues a read of the same file
+    io.write(fname(0),std::vector<Real>(1<<16,1.));
+    io.write(fname(1),vec(1));
+    CHECK(io.read(fname(1)) == vec(1));
+    io.prefetch(fname(1));
+    io.flush();
+    CHECK(io.read(fname(1)) == vec(1));
+    }
+
+SECTION("Errors")
+    {
+    AsyncFileStore<std::vector<Real>> io;
+    io.prefetch(fname(100));
+    CHECK_THROWS_AS(io.read(fname(100)),ITError);
+    CHECK_THROWS_AS(io.read(fname(101)),ITError);
+    io.write(dir+"/nodir/v",vec(1));
+    CHECK_THROWS_AS(io.flush(),ITError);
+    }
+
+removeTree(dir);
+}
+
+TEST_CASE("SpillManager")
+{
+SECTION("Spill Least Recently Used")
+    {
+    SpillManager m(100);
+    auto spilled = std::vector<int>();
+    auto inuse = 3;
+    auto c = m.addClient([&](int j)
+        {
+        if(j == inuse) return false;
+        spilled.push_back(j);
+        return true;
+        });
+    for(auto j : range1(4)) m.track(c,j,30);
+    CHECK(m.liveBytes() == 120);
+    //Touching 2 then 1 leaves 3 least recently
+    //used, but it is in use so 4 is spilled
+    m.track(c,2,30);
+    m.track(c,1,30);
+    m.enforce();
+    CHECK((spilled == std::vector<int>{4}));
+    CHECK(m.liveBytes() == 90);
+    m.track(c,5,50);
+    m.enforce();
+    CHECK((spilled == std::vector<int>{4,2,1}));
+    CHECK(m.liveBytes() == 80);
+    CHECK(m.peakBytes() == 140);
+    m.removeClient(c);
+    CHECK(m.liveBytes() == 0);
+    }
+}
+
+TEST_CASE("Profiler")
+{
+auto inner = [](int n)
+    {
+    PROFILE_SCOPE_BYTES("test inner",8*n)
+    };
+auto outer = [&inner]()
+    {
+    PROFILE_SCOPE("test outer")
+    inner(1);
+    inner(2);
+    };
+
+profiler().reset();
+auto was_enabled = profiler().enabled();
+
+SECTION("Disabled")
+    {
+    profiler().disable();
+    outer();
+    CHECK(profiler().stats({"test outer"}).calls == 0);
+    }
+
+SECTION("Nested Regions")
+    {
+    profiler().enable();
+    outer();
+    outer();
+    inner(4);
+    auto so = profiler().stats({"test outer"});
+    auto si = profiler().stats({"test outer","test inner"});
+    CHECK(so.calls == 2);
+    CHECK(si.calls == 4);
+    CHECK(si.bytes == 48);
+    CHECK(so.inclusive >= si.inclusive);
+    CHECK(so.exclusive <= so.inclusive-si.inclusive+1E-12);
+    CHECK(profiler().stats({"test inner"}).calls == 1);
+
+    std::ostringstream s;
+    profiler().writeJSON(s,"test");
+    auto json = s.str();
+    CHECK(json.find("\"label\":\"test\"") != std::string::npos);
+    CHECK(json.find("{\"name\":\"test outer\",\"calls\":2,") != std::string::npos);
+
+    profiler().reset();
+    CHECK(profiler().stats({"test outer"}).calls == 0);
+    }
+
+SECTION("Threads")
+    {
+    profiler().enable();
+    ThreadPool pool(4);
+    pool.parallelFor(100,4,[&inner](size_t) { inner(1); });
+    CHECK(profiler().stats({"test inner"}).calls == 100);
+    }
+
+SECTION("Session")
+    {
+    profiler().disable();
+    auto prev_file = profiler().file();
+        {
+        ProfileSession session("profile_test.json");
+        CHECK(profiler().enabled());
+        CHECK(profiler().file() == "profile_test.json");
+        }
+    CHECK(!profiler().enabled());
+    CHECK(profiler().file() == prev_file);
+
+    //Empty file name: the profiler is left alone
+        {
+        ProfileSession session("");
+        CHECK(!profiler().enabled());
+        }
+
+    //Previous state restored if an exception is thrown
+    profiler().enable();
+    try
+        {
+        ProfileSession session("profile_test.json");
+        throw std::runtime_error("test");
+        }
+    catch(std::runtime_error const&) { }
+    CHECK(profiler().enabled());
+    CHECK(profiler().file() == prev_file);
+    }
+
+if(!was_enabled) profiler().disable();
+profiler().reset();
+}
+
+TEST_CASE("EventTracer")
+{
+auto inner = []()
+    {
+    PROFILE_SCOPE_BYTES("trace inner",16)
+    };
+auto outer = [&inner]()
+    {
+    PROFILE_SCOPE("trace outer")
+    inner();
+    };
+auto count = [](std::string const& s, std::string const& sub)
+    {
+    int n = 0;
+    for(auto p = s.find(sub); p != std::string::npos; p = s.find(sub,p+1)) ++n;
+    return n;
+    };
+
+SECTION("Begin and End Events")
+    {
+    eventTracer().start();
+    eventTracer().setPosition(2,5);
+    outer();
+    CHECK(eventTracer().size() == 4);
+    CHECK(eventTracer().dropped() == 0);
+    std::ostringstream s;
+    eventTracer().writeJSON(s);
+    eventTracer().stop();
+    auto json = s.str();
+    CHECK(json.find("{\"traceEvents\":[") == 0);
+    CHECK(json.find("\"name\":\"trace outer\",\"cat\":\"itensor\",\"ph\":\"B\"") != std::string::npos);
+    CHECK(json.find("\"args\":{\"sweep\":2,\"bond\":5,\"bytes\":16}") != std::string::npos);
+    CHECK(count(json,"\"ph\":\"B\"") == 2);
+    CHECK(count(json,"\"ph\":\"E\"") == 2);
+    //Not recording after stop
+    outer();
+    CHECK(eventTracer().size() == 4);
+    }
+
+SECTION("Ring Buffer")
+    {
+    eventTracer().start("",5);
+    for(int n = 0; n < 3; ++n) outer();
+    CHECK(eventTracer().size() == 5);
+    CHECK(eventTracer().dropped() == 7);
+    std::ostringstream s;
+    eventTracer().writeJSON(s);
+    eventTracer().stop();
+    auto json = s.str();
+    //The buffer starts with the end of an outer region
+    //whose begin event was overwritten
+    CHECK(count(json,"\"ph\":\"B\"") == 2);
+    CHECK(count(json,"\"ph\":\"E\"") == 2);
+    CHECK(json.find("\"dropped\":7") != std::string::npos);
+    }
+
+SECTION("Max Depth")
+    {
+    eventTracer().start("",100,1);
+    outer();
+    outer();
+    CHECK(eventTracer().size() == 4);
+    std::ostringstream s;
+    eventTracer().writeJSON(s);
+    eventTracer().stop();
+    auto json = s.str();
+    CHECK(count(json,"trace outer") == 4);
+    CHECK(count(json,"trace inner") == 0);
+    }
+
+SECTION("File")
+    {
+    auto fname = std::string("util_test_events.json");
+        {
+        EventTraceSession trace(fname);
+        CHECK(eventTracer().active());
+        outer();
+        }
+    CHECK(!eventTracer().active());
+    std::ifstream f(fname);
+    std::stringstream s;
+    s << f.rdbuf();
+    CHECK(count(s.str(),"\"ph\":\"B\"") == 2);
+    std::remove(fname.c_str());
+    }
+
+SECTION("Bad File")
+    {
+    //Failing to write the file only prints a warning
+    CHECK_NOTHROW(EventTraceSession("no_such_dir/events.json"));
+    CHECK(!eventTracer().active());
+    }
+}
+
+TEST_CASE("OpCounter")
+{
+auto was_enabled = opCounter().enabled();
+auto start = opCounter().counts();
+
+SECTION("Disabled")
+    {
+    opCounter().disable();
+    auto A = Matrix(10,10),
+         B = Matrix(10,10);
+    auto C = A*B;
+    auto d = opCounter().counts()-start;
+    CHECK(d[GemmOp].calls == 0);
+    }
+
+SECTION("Gemm")
+    {
+    opCounter().enable();
+    auto A = Matrix(20,30),
+         B = Matrix(30,40);
+    auto C = A*B;
+    auto d = opCounter().counts()-start;
+    CHECK(d[GemmOp].calls == 1);
+    CHECK(d[GemmOp].flops == 2.*20*30*40);
+    CHECK(d[GemmOp].bytes == 8.*(20*30+30*40+20*40));
+    CHECK(d[GemmOp].time >= 0);
+    CHECK(d[PermuteOp].calls == 0);
+    }
+
+SECTION("Permute and Decomp")
+    {
+    opCounter().enable();
+    auto i = Index("i",4),
+         j = Index("j",5),
+         k = Index("k",6);
+    auto T = randomTensor(i,j,k);
+    //Contracting over the middle index
+    //needs a permutation of T
+    auto R = T*randomTensor(j);
+    auto d = opCounter().counts()-start;
+    CHECK(d[PermuteOp].calls >= 1);
+    CHECK(d[PermuteOp].flops == 0);
+    CHECK(d[PermuteOp].bytes >= 2*8*120);
+
+    auto M = Matrix(10,10);
+    for(auto& el : M) el = detail::quickran();
+    Matrix U,V;
+    Vector D;
+    SVD(M,U,D,V,GesddSVD);
+    d = opCounter().counts()-start;
+    CHECK(d[DecompOp].calls == 1);
+    CHECK(d[DecompOp].flops == 26*1000);
+    CHECK(showRates(d).find("GFLOP/s/thread") != std::string::npos);
+    }
+
+SECTION("Session")
+    {
+    opCounter().disable();
+        {
+        OpCountSession session(true);
+        CHECK(opCounter().enabled());
+        }
+    CHECK(!opCounter().enabled());
+        {
+        OpCountSession session(false);
+        CHECK(!opCounter().enabled());
+        }
+    //Left on if it was already enabled
+    opCounter().enable();
+        {
+        OpCountSession session(true);
+        }
+    CHECK(opCounter().enabled());
+    }
+
+if(!was_enabled) opCounter().disable();
+}
+
+TEST_CASE("ContractTrace")
+{
+auto fname = std::string("util_test.trace");
+auto i = Index("i",2),
+     j = Index("j",3),
+     k = Index("k",4);
+auto S = IQIndex("S",Index("s-",1),QN(-1),
+                     Index("s+",2),QN(+1));
+auto L = IQIndex("L",Index("l-",3),QN(-1),
+                     Index("l0",4),QN( 0),
+                     Index("l+",3),QN(+1));
+
+contractTrace().start(fname);
+auto C = randomTensor(i,j)*randomTensorC(j,k);
+auto D = randomTensor(QN(),L,S,dag(prime(L)))*randomTensor(QN(),prime(L),prime(S,2));
+CHECK(contractTrace().size() == 2);
+contractTrace().stop();
+//Not recorded
+C = randomTensor(i,j)*randomTensor(j,k);
+
+auto trace = readContractTrace(fname);
+CHECK(trace.size() == 2);
+
+//The tensors may be recorded as A or B depending
+//on how the contraction was carried out
+auto contracted = [](TStats::Tens const& A, TStats::Tens const& B)
+    {
+    auto res = std::vector<long>();
+    for(auto& ia : A.inds)
+    for(auto& ib : B.inds)
+        {
+        if(ia.label == ib.label && ia.label < 0) res.push_back(ia.dim);
+        }
+    return res;
+    };
+
+auto& t0 = trace.at(0);
+CHECK(!t0.blocksparse);
+CHECK(t0.A.cplx != t0.B.cplx);
+CHECK(t0.C.cplx);
+CHECK(t0.A.inds.size() == 2);
+CHECK(t0.B.inds.size() == 2);
+CHECK(t0.C.inds.size() == 2);
+CHECK((contracted(t0.A,t0.B) == std::vector<long>{3}));
+CHECK(t0.time >= 0);
+
+auto& t1 = trace.at(1);
+auto& A1 = (t1.A.inds.size() == 3 ? t1.A : t1.B);
+auto& B1 = (t1.A.inds.size() == 3 ? t1.B : t1.A);
+CHECK(t1.blocksparse);
+CHECK(B1.inds.size() == 2);
+CHECK(t1.C.inds.size() == 3);
+CHECK((contracted(t1.A,t1.B) == std::vector<long>{10}));
+CHECK(A1.inds[0].dim == 10);
+CHECK((A1.inds[0].sector_dims == std::vector<long>{3,4,3}));
+CHECK(A1.inds[0].sector_qns.at(2) == QN(+1));
+CHECK(A1.inds[2].dir == int(In));
+CHECK(B1.inds[0].dir == int(Out));
+//Blocks with zero divergence
+CHECK(A1.blocks.size() == 4);
+CHECK(B1.blocks.size() == 2);
+CHECK(!t1.C.blocks.empty());
+
+std::remove(fname.c_str());
+}